@@ -0,0 +1,64 @@
+// aws_certs.h
+#ifndef AWS_CERTS_H
+#define AWS_CERTS_H
+
+#include <Arduino.h>
+#include <WiFiClientSecureBearSSL.h>
+
+// Device certificate, private key and root CA of the AWS IoT connection.
+//
+// Parse them once at startup, from the PEM text in the sketch or from the DER blobs that
+// Tools/cert-compiler writes to aws_certs_der.h, then attach() them to the TLS client. The client
+// only keeps pointers, so the object must outlive every connection: declare it as a global.
+class AwsCertificates {
+public:
+  // Parse PEM text, which BearSSL base64-decodes first
+  void loadPem(const char* cert, const char* privateKey, const char* rootCA) {
+    clientCert.append(cert);
+    clientKey.parse(privateKey);
+    trustAnchors.append(rootCA);
+  }
+
+  // Parse DER blobs stored in PROGMEM. No base64 decoding, and each blob is copied out of flash
+  // only while it is parsed.
+  void loadDer(const uint8_t* cert, size_t certLength, const uint8_t* privateKey, size_t privateKeyLength,
+               const uint8_t* rootCA, size_t rootCALength) {
+    uint8_t* der = fromFlash(cert, certLength);
+    clientCert.append(der, certLength);
+    free(der);
+    der = fromFlash(privateKey, privateKeyLength);
+    clientKey.parse(der, privateKeyLength);
+    memset(der, 0, privateKeyLength); // Do not leave a copy of the key on the heap
+    free(der);
+    der = fromFlash(rootCA, rootCALength);
+    trustAnchors.append(der, rootCALength);
+    free(der);
+  }
+
+  // Give the certificates to a TLS client
+  void attach(BearSSL::WiFiClientSecure& client) {
+    client.setClientRSACert(&clientCert, &clientKey);
+    client.setTrustAnchors(&trustAnchors);
+  }
+
+private:
+  // Copy a DER blob from flash to RAM, where the BearSSL parsers read it
+  static uint8_t* fromFlash(const uint8_t* progmemDer, size_t length) {
+    uint8_t* buffer = (uint8_t*)malloc(length);
+    if (buffer == nullptr) {
+      // Without the certificates no connection can ever succeed, so stop here rather than fail later
+      Serial.print("Out of memory copying a ");
+      Serial.print(length);
+      Serial.println(" byte certificate from flash, restarting");
+      ESP.restart();
+    }
+    memcpy_P(buffer, progmemDer, length);
+    return buffer;
+  }
+
+  BearSSL::X509List clientCert; // Device certificate
+  BearSSL::PrivateKey clientKey; // Device private key
+  BearSSL::X509List trustAnchors; // Amazon root CA
+};
+
+#endif // AWS_CERTS_H
@@ -0,0 +1,43 @@
+// backoff.h
+// Shared with the host-side simulation (Tools/reconnect-sim), so it must not depend on any Arduino header.
+#ifndef BACKOFF_H
+#define BACKOFF_H
+
+#include <stdint.h>
+
+// Exponential backoff with full jitter for reconnect attempts.
+//
+// After the n-th consecutive failure the caller waits a uniformly random time in
+// [0, min(cap, base * 2^n)] milliseconds. Boards that lose the broker or the access point at
+// the same moment therefore spread their retries over the whole window instead of all coming
+// back in lockstep. reset() after a success makes the next failure start from base again.
+class Backoff {
+public:
+  Backoff(uint32_t baseMs, uint32_t capMs) : baseMs(baseMs), capMs(capMs) {}
+
+  // Delay before the next attempt. random must be a uniformly distributed 32-bit value
+  // (ESP.random() on the device) so that every board draws a different delay.
+  uint32_t next(uint32_t random) {
+    uint32_t ceiling = ceilingMs();
+    if (ceiling < capMs && level < 31) {
+      level++; // Double the window for the next failure until it reaches the cap
+    }
+    return (uint32_t)(((uint64_t)random * ((uint64_t)ceiling + 1)) >> 32);
+  }
+
+  // Call after a successful attempt
+  void reset() { level = 0; }
+
+  // Upper bound of the next delay
+  uint32_t ceilingMs() const {
+    uint64_t ceiling = (uint64_t)baseMs << level;
+    return ceiling < capMs ? (uint32_t)ceiling : capMs;
+  }
+
+private:
+  uint32_t baseMs;
+  uint32_t capMs;
+  uint8_t level = 0; // Number of doublings applied to base
+};
+
+#endif // BACKOFF_H
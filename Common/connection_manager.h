@@ -0,0 +1,230 @@
+// connection_manager.h
+#ifndef CONNECTION_MANAGER_H
+#define CONNECTION_MANAGER_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <PubSubClient.h>
+#include <time.h>
+#include "backoff.h"
+#include "dns_cache.h"
+#include "tls_session.h"
+
+// Connection stages, advanced one step per loop() iteration so the web server and the rest of loop() keep running
+enum ConnectionState {
+  CONN_WIFI, // Waiting for the access point
+  CONN_TIME, // Waiting for NTP, the broker certificate cannot be validated before the clock is set
+  CONN_DNS, // Resolving the AWS IoT endpoint
+  CONN_TLS, // TLS handshake with the broker
+  CONN_MQTT, // MQTT CONNECT and subscriptions
+  CONN_READY // Connected, watching for a drop
+};
+
+// Where a lab connects to
+struct ConnectionConfig {
+  const char* ssid;
+  const char* password;
+  const char* ntpServer1;
+  const char* ntpServer2;
+  const char* endpoint; // AWS IoT endpoint, connected by name so the certificate is checked against it
+  uint16_t port;
+  const char* clientId; // MQTT client ID
+  size_t dnsIndex; // Index of endpoint in the DNS cache
+};
+
+// The parts of a connection that differ between labs
+struct ConnectionCallbacks {
+  void (*log)(const String& message); // Report a connection event, e.g. on Serial and the web console
+  void (*mqttConnected)(); // Subscribe and queue what the broker should hear first, called before CONN_READY
+  void (*wifiConnected)(); // Optional, called when the access point is joined
+};
+
+// Non-blocking connection to AWS IoT: WiFi, NTP, DNS, TLS and MQTT, one stage at a time.
+//
+// service() advances the connection by at most one stage. Each stage either returns at once or
+// makes a single bounded attempt, so loop() is never held for long. A failed stage is retried
+// after a jittered exponential backoff (backoff.h); WiFi and NTP have their own backoffs, the
+// DNS, TLS and MQTT stages share one and always restart from DNS. Client is the OutboxClient the
+// lab publishes through, so in-flight messages are framed again on every new connection, and
+// Resolver is its DnsCache.
+//
+// The longest a single service() call can hold loop() is in CONN_TLS. Against a broker that drops
+// the SYN the TCP connect gives up after TLS_CONNECT_TIMEOUT_MS (2 s instead of the core's 5 s).
+// A broker that accepts TCP and then goes quiet is bounded by the BearSSL client's handshake
+// timeout, and in CONN_MQTT a missing CONNACK by PubSubClient's socket timeout (15 s).
+template <typename Client, typename Resolver>
+class ConnectionManager {
+public:
+  ConnectionManager(const ConnectionConfig& config, Client& tls, PubSubClient& mqtt, Resolver& dns, TlsSession& session)
+    : config(config), tls(tls), mqtt(mqtt), dns(dns), session(session) {}
+
+  // Start joining the access point, service() waits for it without blocking
+  void begin(const ConnectionCallbacks& connectionCallbacks) {
+    callbacks = connectionCallbacks;
+    WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(false); // service() reconnects with backoff instead of the fixed SDK cadence
+    WiFi.begin(config.ssid, config.password);
+    stageStart = millis();
+  }
+
+  // Advance or maintain the connection, call from every loop() iteration
+  void service() {
+    // Every later stage depends on WiFi, start over when it drops
+    if (state != CONN_WIFI && WiFi.status() != WL_CONNECTED) {
+      retry(CONN_WIFI, wifiBackoff, "WiFi lost");
+      return;
+    }
+    if (retryPending) {
+      if ((long)(millis() - retryAt) < 0) {
+        return; // Still waiting out the backoff delay
+      }
+      retryPending = false;
+      setState(state);
+      return;
+    }
+
+    switch (state) {
+      case CONN_WIFI:
+        if (WiFi.status() == WL_CONNECTED) {
+          wifiBackoff.reset();
+          if (callbacks.wifiConnected != nullptr) {
+            callbacks.wifiConnected();
+          }
+          callbacks.log("WiFi connected, IP address: " + WiFi.localIP().toString());
+          callbacks.log("Access web interface via http://" + WiFi.localIP().toString());
+          setState(CONN_TIME);
+        } else if (millis() - stageStart >= WIFI_TIMEOUT_MS) {
+          WiFi.disconnect();
+          retry(CONN_WIFI, wifiBackoff, "WiFi connection timed out");
+        }
+        break;
+
+      case CONN_TIME:
+        if (time(nullptr) >= 8 * 3600) { // Time has been set
+          time_t now = time(nullptr);
+          struct tm timeinfo;
+          localtime_r(&now, &timeinfo);
+          Serial.print("Current time: ");
+          Serial.print(asctime(&timeinfo));
+          ntpBackoff.reset();
+          setState(CONN_DNS);
+        } else if (millis() - stageStart >= NTP_TIMEOUT_MS) {
+          retry(CONN_TIME, ntpBackoff, "NTP sync timed out");
+        }
+        break;
+
+      case CONN_DNS:
+        // Waits for the query without blocking, connectTLS() then finds the address in lwIP's cache
+        switch (dns.lookup(config.dnsIndex, millis(), address)) {
+          case DNS_LOOKUP_HIT:
+          case DNS_LOOKUP_RESOLVED:
+            callbacks.log(String(config.endpoint) + " is " + address.toString() + " after " +
+                          String(millis() - stageStart) + " ms");
+            setState(CONN_TLS);
+            break;
+          case DNS_LOOKUP_PENDING:
+            break;
+          case DNS_LOOKUP_FAILED:
+            retry(CONN_DNS, awsBackoff, "DNS lookup failed");
+            break;
+        }
+        break;
+
+      case CONN_TLS:
+        if (connectTLS()) {
+          setState(CONN_MQTT);
+        } else {
+          retry(CONN_DNS, awsBackoff, "TLS connection failed, error " + String(tls.getLastSSLError()));
+        }
+        break;
+
+      case CONN_MQTT:
+        // The TLS connection is already open, so connect() only sends CONNECT and waits for CONNACK
+        if (mqtt.connect(config.clientId)) {
+          callbacks.mqttConnected();
+          callbacks.log("Connected to AWS IoT");
+          awsBackoff.reset();
+          setState(CONN_READY);
+        } else {
+          retry(CONN_DNS, awsBackoff, "MQTT connect failed, rc=" + String(mqtt.state()));
+        }
+        break;
+
+      case CONN_READY:
+        if (!mqtt.connected()) {
+          retry(CONN_DNS, awsBackoff, "Disconnected from AWS IoT, rc=" + String(mqtt.state()));
+        }
+        break;
+    }
+  }
+
+  // Name of the current stage, e.g. "ready"
+  const char* stateName() const {
+    static const char* const names[] = { "wifi", "time", "dns", "tls", "mqtt", "ready" };
+    return names[state];
+  }
+
+  ConnectionState state = CONN_WIFI; // Current connection stage
+
+private:
+  static const unsigned long RETRY_BASE_MS = 1000; // The first retry after a failure waits up to 1 s
+  static const unsigned long RETRY_CAP_MS = 60000; // No retry waits more than a minute
+  static const unsigned long WIFI_TIMEOUT_MS = 20000; // Give up on an association attempt after this long
+  static const unsigned long NTP_TIMEOUT_MS = 15000; // Ask the NTP servers again after this long
+  static const unsigned long TLS_CONNECT_TIMEOUT_MS = 2000; // TCP connect and write timeout of the TLS client
+
+  // Open the TLS connection to the broker and log whether the session was resumed
+  bool connectTLS() {
+    tls.beginConnection(); // Frame the new connection from its first byte
+    tls.setTimeout(TLS_CONNECT_TIMEOUT_MS); // An unreachable broker stalls loop() this long, not the default 5 s
+    session.attach(tls); // Offer the previous session, BearSSL falls back to a full handshake if refused
+
+    // By name so the certificate is checked against it
+    bool connected = session.connect([this]() { return tls.connect(config.endpoint, config.port); });
+    if (connected) {
+      callbacks.log(session.summary());
+    }
+    return connected;
+  }
+
+  // Start, or restart, a connection stage
+  void setState(ConnectionState next) {
+    state = next;
+    stageStart = millis();
+    callbacks.log(String("Connection: ") + stateName());
+
+    if (next == CONN_WIFI) {
+      WiFi.begin(config.ssid, config.password);
+    } else if (next == CONN_TIME) {
+      configTime(0, 0, config.ntpServer1, config.ntpServer2); // Configure time using NTP servers
+    }
+  }
+
+  // Abandon the current attempt and restart a stage after a jittered backoff delay
+  void retry(ConnectionState next, Backoff& backoff, const String& reason) {
+    unsigned long wait = backoff.next(ESP.random()); // Hardware RNG, so every board draws a different delay
+    callbacks.log(reason + ", retrying in " + String(wait) + " ms");
+    mqtt.disconnect();
+    tls.stop();
+    tls.endConnection(); // In-flight messages are sent again after the reconnect
+    state = next;
+    retryPending = true;
+    retryAt = millis() + wait;
+  }
+
+  ConnectionConfig config;
+  Client& tls;
+  PubSubClient& mqtt;
+  Resolver& dns;
+  TlsSession& session;
+  ConnectionCallbacks callbacks = {};
+  unsigned long stageStart = 0; // millis() value when the current stage was started
+  bool retryPending = false; // True while waiting out a backoff delay before restarting the stage
+  unsigned long retryAt = 0; // millis() value at which the pending retry starts
+  Backoff wifiBackoff{ RETRY_BASE_MS, RETRY_CAP_MS }; // Retries to join the access point
+  Backoff ntpBackoff{ RETRY_BASE_MS, RETRY_CAP_MS }; // Retries to reach the time servers
+  Backoff awsBackoff{ RETRY_BASE_MS, RETRY_CAP_MS }; // Retries of the DNS, TLS and MQTT stages
+  IPAddress address; // Last resolved address of the endpoint
+};
+
+#endif // CONNECTION_MANAGER_H
@@ -0,0 +1,50 @@
+// console_log.h
+#ifndef CONSOLE_LOG_H
+#define CONSOLE_LOG_H
+
+#include <Arduino.h>
+
+// Fixed-capacity log of the lines shown in the web console.
+// Every line gets a sequence number that only ever increases, so a page can ask for the lines
+// it has not seen yet. When the log is full the oldest line is overwritten, and lines longer
+// than LineLength - 1 characters are truncated, so memory use never grows.
+template <size_t Capacity, size_t LineLength>
+class ConsoleLog {
+public:
+  // Add a line, returns its sequence number
+  uint32_t add(const char* text) {
+    char* line = lines[nextSeq % Capacity];
+    strncpy(line, text, LineLength - 1);
+    line[LineLength - 1] = '\0';
+    return nextSeq++;
+  }
+
+  uint32_t add(const String& text) { return add(text.c_str()); }
+
+  // Sequence number of the oldest line still held
+  uint32_t first() const { return nextSeq > Capacity ? nextSeq - Capacity : 0; }
+
+  // Sequence number the next line will get
+  uint32_t next() const { return nextSeq; }
+
+  // Append the lines numbered since to until - 1 to out, each followed by <br>.
+  // Lines that were already overwritten are skipped.
+  void appendTo(String& out, uint32_t since, uint32_t until) const {
+    if (since < first()) {
+      since = first();
+    }
+    if (until > nextSeq) {
+      until = nextSeq;
+    }
+    for (uint32_t seq = since; seq < until; seq++) {
+      out += lines[seq % Capacity];
+      out += "<br>";
+    }
+  }
+
+private:
+  char lines[Capacity][LineLength] = {};
+  uint32_t nextSeq = 0; // Sequence number of the next line
+};
+
+#endif // CONSOLE_LOG_H
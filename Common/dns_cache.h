@@ -0,0 +1,229 @@
+// dns_cache.h
+#ifndef DNS_CACHE_H
+#define DNS_CACHE_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <stdarg.h>
+#include "link_stats.h"
+
+#ifdef ARDUINO_ARCH_ESP8266
+extern "C" {
+#include <lwip/dns.h>
+}
+#endif
+
+// One cached host name
+struct DnsName {
+  const char* name; // Key in the summary
+  const char* host;
+};
+
+// Outcome of DnsCache::lookup()
+enum DnsStatus {
+  DNS_LOOKUP_HIT, // Answered from the cache, no query on the connect path
+  DNS_LOOKUP_RESOLVED, // Answered by the query this lookup waited for
+  DNS_LOOKUP_PENDING, // A query is running, ask again on a later pass
+  DNS_LOOKUP_FAILED // The query failed or no DNS server is known
+};
+
+// Cache of the few names a lab connects to, kept fresh in the background.
+//
+// On the ESP8266 the cache is lwIP's own resolver table, which keeps every answer for the TTL of
+// its record. service() asks lwIP for each name every checkIntervalMs without waiting: a cached
+// name is answered at once, an expired one starts an asynchronous query, so the table is
+// refilled from loop() rather than by the next connect(). WiFiClientSecure::connect(name) and
+// SNTP look names up through the same table, so they find the address without a query and the
+// TLS connection still goes by name for SNI and the certificate check. lwIP does not hand out
+// the TTL, so the reported ttl_s is how long the last answer stayed in the table. Keep the names
+// within DNS_TABLE_SIZE (4 entries in the core), or they push each other out.
+//
+// On the host (native build) names go through WiFi.hostByName(), synchronously, and are kept for
+// HOST_TTL_MS, refreshed by service() before they expire.
+template <size_t NameCount>
+class DnsCache {
+public:
+  DnsCache(const DnsName (&names)[NameCount], uint32_t checkIntervalMs) : intervalMs(checkIntervalMs) {
+    for (size_t i = 0; i < NameCount; i++) {
+      state[i].config = &names[i];
+    }
+  }
+
+  // Refresh the names that are due, nothing is looked up while linkUp is false.
+  // Returns true if a query was started.
+  bool service(uint32_t nowMs, bool linkUp) {
+    bool started = false;
+    for (size_t i = 0; i < NameCount; i++) {
+      NameState& entry = state[i];
+      if (!linkUp || entry.resolving || (int32_t)(nowMs - entry.nextCheckMs) < 0) {
+        continue;
+      }
+      entry.nextCheckMs = nowMs + intervalMs;
+      if (query(entry, nowMs, intervalMs) == QUERY_STARTED) {
+        entry.refreshes++;
+        started = true;
+      }
+    }
+    return started;
+  }
+
+  // Look a name up for a connection. Call it again on later passes while it returns DNS_LOOKUP_PENDING.
+  // A lookup that had to wait for a query counts once as a miss.
+  DnsStatus lookup(size_t index, uint32_t nowMs, IPAddress& address) {
+    NameState& entry = state[index];
+    if (!entry.waiting) {
+      if (!entry.resolving) {
+        QueryState result = query(entry, nowMs, 0);
+        if (result == QUERY_CACHED) {
+          entry.hits++;
+          address = IPAddress(entry.address);
+          return DNS_LOOKUP_HIT;
+        }
+        if (result == QUERY_FAILED) {
+          return DNS_LOOKUP_FAILED;
+        }
+      }
+      entry.waiting = true;
+      entry.misses++;
+    }
+    if (entry.resolving) {
+      return DNS_LOOKUP_PENDING;
+    }
+    entry.waiting = false;
+    if (entry.failed) {
+      return DNS_LOOKUP_FAILED;
+    }
+    address = IPAddress(entry.address);
+    return DNS_LOOKUP_RESOLVED;
+  }
+
+  // Write the counters of the period as JSON, times in milliseconds.
+  // Returns the length, or 0 if it did not fit.
+  size_t writeSummary(char* buffer, size_t size) const {
+    size_t length = 0;
+    append(buffer, size, length, "{");
+    for (size_t i = 0; i < NameCount; i++) {
+      const NameState& entry = state[i];
+      const RttStats& times = entry.resolveTimes;
+      uint32_t lookups = entry.hits + entry.misses;
+      uint32_t address = entry.address;
+      append(buffer, size, length,
+             "%s\"%s\": {\"host\": \"%s\", \"address\": \"%u.%u.%u.%u\", \"ttl_s\": %lu, \"hits\": %lu, \"misses\": %lu, "
+             "\"hit_rate\": %.2f, \"refreshes\": %lu, \"queries\": %lu, \"failed\": %lu, "
+             "\"resolve_ms\": {\"min\": %.1f, \"p50\": %.1f, \"p95\": %.1f, \"max\": %.1f}}",
+             i > 0 ? ", " : "", entry.config->name, entry.config->host, (unsigned)(address & 0xFF),
+             (unsigned)((address >> 8) & 0xFF), (unsigned)((address >> 16) & 0xFF), (unsigned)(address >> 24),
+             (unsigned long)(entry.ttlMs / 1000), (unsigned long)entry.hits, (unsigned long)entry.misses,
+             lookups ? (float)entry.hits / lookups : 0.0f, (unsigned long)entry.refreshes, (unsigned long)times.sent(),
+             (unsigned long)times.lost(), times.min() / 1000.0f, times.percentileUs(50) / 1000.0f,
+             times.percentileUs(95) / 1000.0f, times.max() / 1000.0f);
+    }
+    append(buffer, size, length, "}");
+    return length < size ? length : 0;
+  }
+
+  // Start a new report period, the cached addresses are kept
+  void resetPeriod() {
+    for (size_t i = 0; i < NameCount; i++) {
+      state[i].hits = 0;
+      state[i].misses = 0;
+      state[i].refreshes = 0;
+      state[i].resolveTimes.reset();
+    }
+  }
+
+private:
+  static const uint32_t HOST_TTL_MS = 60000; // The host resolver does not report the TTL either
+
+  enum QueryState { QUERY_CACHED, QUERY_STARTED, QUERY_FAILED };
+
+  struct NameState {
+    const DnsName* config;
+    uint32_t address = 0; // Network byte order, 0 until resolved
+    bool valid = false; // address holds an answer, possibly expired
+    uint32_t resolvedAtMs = 0;
+    uint32_t ttlMs = 0;
+    uint32_t nextCheckMs = 0;
+    uint32_t queryStartUs = 0;
+    bool resolving = false; // A query is running
+    bool waiting = false; // lookup() returned DNS_LOOKUP_PENDING and has not seen the answer yet
+    bool failed = false; // The last query got no answer
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint32_t refreshes = 0; // Queries started by service()
+    RttStats resolveTimes; // Every query, a failed one counts as lost
+  };
+
+  static void append(char* buffer, size_t size, size_t& length, const char* format, ...) {
+    if (length >= size) {
+      return;
+    }
+    va_list args;
+    va_start(args, format);
+    length += vsnprintf(buffer + length, size - length, format, args);
+    va_end(args);
+  }
+
+  // Record the end of a query, address is 0 if it failed
+  static void finishQuery(NameState& entry, uint32_t address, uint32_t nowMs) {
+    entry.resolving = false;
+    entry.failed = address == 0;
+    if (entry.failed) {
+      entry.resolveTimes.recordLoss();
+      return;
+    }
+    entry.resolveTimes.recordReply(micros() - entry.queryStartUs);
+    entry.address = address;
+    entry.valid = true;
+    entry.resolvedAtMs = nowMs;
+  }
+
+#ifdef ARDUINO_ARCH_ESP8266
+  // lwIP decides whether the name is still cached, so refreshAheadMs is not used
+  QueryState query(NameState& entry, uint32_t nowMs, uint32_t refreshAheadMs) {
+    (void)refreshAheadMs;
+    ip_addr_t address;
+    err_t result = dns_gethostbyname(entry.config->host, &address, onResolved, &entry);
+    if (result == ERR_OK) {
+      if (!entry.valid || entry.address != ip_addr_get_ip4_u32(&address)) {
+        entry.address = ip_addr_get_ip4_u32(&address);
+        entry.valid = true;
+        entry.resolvedAtMs = nowMs;
+      }
+      return QUERY_CACHED;
+    }
+    if (result != ERR_INPROGRESS) {
+      return QUERY_FAILED;
+    }
+    if (entry.valid) {
+      entry.ttlMs = nowMs - entry.resolvedAtMs; // lwIP dropped the last answer, within a check interval
+    }
+    entry.resolving = true;
+    entry.queryStartUs = micros();
+    return QUERY_STARTED;
+  }
+
+  // Called by lwIP when a query finishes, address is nullptr if it failed
+  static void onResolved(const char* name, const ip_addr_t* address, void* arg) {
+    (void)name;
+    finishQuery(*static_cast<NameState*>(arg), address != nullptr ? ip_addr_get_ip4_u32(address) : 0, millis());
+  }
+#else
+  // A name is cached until HOST_TTL_MS - refreshAheadMs after it was resolved
+  QueryState query(NameState& entry, uint32_t nowMs, uint32_t refreshAheadMs) {
+    if (entry.valid && nowMs - entry.resolvedAtMs + refreshAheadMs < HOST_TTL_MS) {
+      return QUERY_CACHED;
+    }
+    entry.ttlMs = HOST_TTL_MS;
+    entry.queryStartUs = micros();
+    IPAddress address;
+    finishQuery(entry, WiFi.hostByName(entry.config->host, address) ? (uint32_t)address : 0, nowMs);
+    return entry.failed ? QUERY_FAILED : QUERY_STARTED;
+  }
+#endif
+
+  NameState state[NameCount];
+  uint32_t intervalMs;
+};
+
+#endif // DNS_CACHE_H
@@ -0,0 +1,86 @@
+// event_stream.h
+#ifndef EVENT_STREAM_H
+#define EVENT_STREAM_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <ESP8266WebServer.h>
+
+// Server-Sent Events streams of the pages a lab has open, pushed to only when something changes.
+//
+// open() takes over the web server's current connection from a handler such as /events: the
+// connection is kept after the handler returns, the web server only drops its own reference to
+// it. broadcast() sends an event to every stream and closes the ones too slow to take it whole,
+// so the browser reconnects and gets the full state again instead of a torn event. service()
+// sends a comment on idle streams every keepaliveMs, so dead connections are noticed and freed.
+template <size_t MaxClients>
+class EventStream {
+public:
+  explicit EventStream(unsigned long keepaliveMs) : keepaliveMs(keepaliveMs) {}
+
+  // Format one event, every line of data gets its own data: field
+  static String format(const char* event, const String& data) {
+    String message = String("event: ") + event + "\n";
+    int start = 0;
+    int end;
+    while ((end = data.indexOf('\n', start)) >= 0) {
+      message += "data: " + data.substring(start, end) + "\n";
+      start = end + 1;
+    }
+    message += "data: " + data.substring(start) + "\n\n";
+    return message;
+  }
+
+  // Open a stream on the server's current request and send it initial, the events that bring
+  // the page up to date. Answers 503 and returns false if every stream is in use.
+  bool open(ESP8266WebServer& server, const String& initial) {
+    for (size_t i = 0; i < MaxClients; i++) {
+      if (!clients[i].connected()) {
+        WiFiClient client = server.client();
+        client.setNoDelay(true); // Events are small, send them at once
+        client.print("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\nConnection: keep-alive\r\n\r\n");
+        client.print(initial);
+        clients[i] = client;
+        return true;
+      }
+    }
+    server.send(503, "text/plain", "Too many open pages");
+    return false;
+  }
+
+  // Send an event to every open stream
+  void broadcast(const char* event, const String& data) {
+    String message = format(event, data);
+    for (size_t i = 0; i < MaxClients; i++) {
+      if (!clients[i].connected()) {
+        continue;
+      }
+      int room = clients[i].availableForWrite(); // An int in Print, so a negative value is ruled out before the size_t compare
+      if (room < 0 || (size_t)room < message.length()) {
+        clients[i].stop(); // Too slow to keep up, the browser reconnects and gets the full state
+        continue;
+      }
+      clients[i].print(message);
+    }
+  }
+
+  // Send the keepalive comment when it is due, call from loop()
+  void service(unsigned long nowMs) {
+    if (nowMs - lastKeepalive < keepaliveMs) {
+      return;
+    }
+    for (size_t i = 0; i < MaxClients; i++) {
+      if (clients[i].connected()) {
+        clients[i].print(":\n\n"); // SSE comment, ignored by the browser
+      }
+    }
+    lastKeepalive = nowMs;
+  }
+
+private:
+  WiFiClient clients[MaxClients];
+  unsigned long keepaliveMs;
+  unsigned long lastKeepalive = 0; // millis() value of the last keepalive comment
+};
+
+#endif // EVENT_STREAM_H
@@ -0,0 +1,328 @@
+// link_monitor.h
+#ifndef LINK_MONITOR_H
+#define LINK_MONITOR_H
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include "link_stats.h"
+
+#ifdef ARDUINO_ARCH_ESP8266
+extern "C" {
+#include <lwip/dns.h>
+#include <lwip/icmp.h>
+#include <lwip/inet_chksum.h>
+#include <lwip/prot/ip4.h>
+#include <lwip/raw.h>
+}
+#else
+#include <fcntl.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/ip_icmp.h>
+#include <sys/socket.h>
+#endif
+
+// One probed host. host is a name or a dotted address, nullptr probes the Wi-Fi gateway.
+struct LinkTarget {
+  const char* name; // Key in the summary
+  const char* host;
+};
+
+// Background link-quality monitor. Sends an ICMP echo request to each target every
+// probeIntervalMs and never waits for the reply: the reply is timestamped when lwIP hands it
+// over, and a probe without a reply after timeoutMs counts as lost. service() only sends due
+// probes and expires old ones, so it can run from loop() on every pass. Names are resolved
+// with the asynchronous lwIP resolver for the same reason.
+//
+// Each probe also samples the RSSI, so the summary can set signal strength against round trip
+// and loss. On the host (native build) the probes go through a Linux ping socket instead.
+template <size_t TargetCount>
+class LinkMonitor {
+public:
+  LinkMonitor(const LinkTarget (&targets)[TargetCount], uint32_t probeIntervalMs, uint32_t timeoutMs)
+      : intervalMs(probeIntervalMs), timeoutMs(timeoutMs) {
+    for (size_t i = 0; i < TargetCount; i++) {
+      state[i].config = &targets[i];
+      state[i].nextProbeMs = probeIntervalMs * i / TargetCount; // Spread the targets over the interval
+    }
+  }
+
+  // Open the ICMP endpoint, returns false if the system does not allow it
+  bool begin() {
+#ifdef ARDUINO_ARCH_ESP8266
+    pcb = raw_new(IP_PROTO_ICMP);
+    if (pcb == nullptr) {
+      return false;
+    }
+    raw_recv(pcb, onReceive, this);
+    raw_bind(pcb, IP_ADDR_ANY);
+#else
+    fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_ICMP); // Needs net.ipv4.ping_group_range to include the user
+    if (fd < 0) {
+      return false;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+#endif
+    return true;
+  }
+
+  // Set the address probed for targets without a host, in network byte order
+  void setGateway(uint32_t address) {
+    for (size_t i = 0; i < TargetCount; i++) {
+      if (state[i].config->host == nullptr) {
+        state[i].address = address;
+      }
+    }
+  }
+
+  // Send the probes that are due and expire the ones that timed out. rssi is the current
+  // signal strength, nothing is sent while linkUp is false. Returns true if a probe was due.
+  bool service(uint32_t nowMs, int8_t rssi, bool linkUp) {
+    bool due = false;
+#ifndef ARDUINO_ARCH_ESP8266
+    receiveReplies();
+#endif
+    for (size_t i = 0; i < TargetCount; i++) {
+      TargetState& target = state[i];
+      if (target.outstanding && nowMs - target.sentAtMs >= timeoutMs) {
+        target.outstanding = false;
+        target.stats.recordLoss();
+        rssiLatency.recordLoss(target.sentRssi);
+      }
+      if (!linkUp || (int32_t)(nowMs - target.nextProbeMs) < 0) {
+        continue;
+      }
+      target.nextProbeMs = nowMs + intervalMs;
+      due = true;
+      if (target.config->host != nullptr && (target.address == 0 || nowMs - target.resolvedAtMs >= RESOLVE_INTERVAL_MS)) {
+        resolve(target, nowMs); // Keeps probing the old address until the new one is known
+      }
+      if (target.address != 0 && !target.outstanding) {
+        sendProbe(target, nowMs, rssi);
+      }
+    }
+    return due;
+  }
+
+  // Write the summary of the period as JSON. Times are in milliseconds, RSSI in dBm.
+  // Returns the length, or 0 if it did not fit.
+  size_t writeSummary(char* buffer, size_t size, uint32_t periodMs) const {
+    size_t length = 0;
+    float correlation = rssiLatency.correlation();
+    append(buffer, size, length, "{\"period_s\": %lu, \"rssi\": {\"mean\": %.1f, \"min\": %d, \"max\": %d, \"rtt_corr\": ",
+           (unsigned long)(periodMs / 1000), rssiLatency.mean(), rssiLatency.min(), rssiLatency.max());
+    if (isnan(correlation)) {
+      append(buffer, size, length, "null}, \"bands\": {");
+    } else {
+      append(buffer, size, length, "%.2f}, \"bands\": {", correlation);
+    }
+    const char* separator = "";
+    for (size_t band = 0; band < RSSI_BANDS; band++) {
+      if (rssiLatency.bandReplyCount(band) + rssiLatency.bandLossCount(band) == 0) {
+        continue;
+      }
+      append(buffer, size, length, "%s\"%s\": {\"replies\": %lu, \"lost\": %lu, \"mean\": %.1f}", separator,
+             RSSI_BAND_NAMES[band], (unsigned long)rssiLatency.bandReplyCount(band),
+             (unsigned long)rssiLatency.bandLossCount(band), rssiLatency.bandMeanUs(band) / 1000.0f);
+      separator = ", ";
+    }
+    append(buffer, size, length, "}, \"targets\": {");
+    for (size_t i = 0; i < TargetCount; i++) {
+      const RttStats& stats = state[i].stats;
+      append(buffer, size, length,
+             "%s\"%s\": {\"sent\": %lu, \"lost\": %lu, \"min\": %.1f, \"p50\": %.1f, \"p95\": %.1f, \"max\": %.1f, \"jitter\": %.1f}",
+             i > 0 ? ", " : "", state[i].config->name, (unsigned long)stats.sent(), (unsigned long)stats.lost(),
+             stats.min() / 1000.0f, stats.percentileUs(50) / 1000.0f, stats.percentileUs(95) / 1000.0f,
+             stats.max() / 1000.0f, stats.jitter() / 1000.0f);
+    }
+    append(buffer, size, length, "}}");
+    return length < size ? length : 0;
+  }
+
+  // Start a new report period
+  void resetPeriod() {
+    for (size_t i = 0; i < TargetCount; i++) {
+      state[i].stats.reset();
+    }
+    rssiLatency.reset();
+  }
+
+  const RttStats& targetStats(size_t index) const { return state[index].stats; }
+  const RssiLatency& rssiStats() const { return rssiLatency; }
+
+private:
+  static const uint32_t RESOLVE_INTERVAL_MS = 600000; // Look names up again every 10 minutes
+  static const uint16_t PROBE_ID = 0x1A8D; // ICMP identifier of our echo requests
+  static const size_t PROBE_PAYLOAD = 16; // Bytes of data after the ICMP header
+
+  struct TargetState {
+    const LinkTarget* config;
+    uint32_t address = 0; // Network byte order, 0 until resolved
+    uint32_t resolvedAtMs = 0;
+    bool resolving = false;
+    uint32_t nextProbeMs = 0;
+    bool outstanding = false; // An echo request is waiting for its reply
+    uint16_t sequence = 0;
+    uint32_t sentAtMs = 0;
+    uint32_t sentAtUs = 0;
+    int8_t sentRssi = 0;
+    RttStats stats;
+  };
+
+  static void append(char* buffer, size_t size, size_t& length, const char* format, ...) {
+    if (length >= size) {
+      return;
+    }
+    va_list args;
+    va_start(args, format);
+    length += vsnprintf(buffer + length, size - length, format, args);
+    va_end(args);
+  }
+
+  // Match a reply to the probe waiting for it, called with the time it arrived
+  void handleReply(uint32_t address, uint16_t sequence, uint32_t nowUs) {
+    for (size_t i = 0; i < TargetCount; i++) {
+      TargetState& target = state[i];
+      if (target.outstanding && target.sequence == sequence && target.address == address) {
+        target.outstanding = false;
+        target.stats.recordReply(nowUs - target.sentAtUs);
+        rssiLatency.recordReply(target.sentRssi, nowUs - target.sentAtUs);
+        return;
+      }
+    }
+  }
+
+#ifdef ARDUINO_ARCH_ESP8266
+  void resolve(TargetState& target, uint32_t nowMs) {
+    if (target.resolving) {
+      return;
+    }
+    ip_addr_t address;
+    err_t result = dns_gethostbyname(target.config->host, &address, onResolved, &target);
+    if (result == ERR_OK) { // A dotted address or a cached name
+      target.address = ip_addr_get_ip4_u32(&address);
+      target.resolvedAtMs = nowMs;
+    } else if (result == ERR_INPROGRESS) {
+      target.resolving = true;
+    }
+  }
+
+  // Called by lwIP when a lookup finishes, address is nullptr if it failed
+  static void onResolved(const char* name, const ip_addr_t* address, void* arg) {
+    (void)name;
+    TargetState& target = *static_cast<TargetState*>(arg);
+    target.resolving = false;
+    target.resolvedAtMs = millis();
+    if (address != nullptr) {
+      target.address = ip_addr_get_ip4_u32(address);
+    }
+  }
+
+  void sendProbe(TargetState& target, uint32_t nowMs, int8_t rssi) {
+    struct pbuf* packet = pbuf_alloc(PBUF_IP, sizeof(struct icmp_echo_hdr) + PROBE_PAYLOAD, PBUF_RAM);
+    if (packet == nullptr) {
+      return;
+    }
+    struct icmp_echo_hdr* echo = (struct icmp_echo_hdr*)packet->payload;
+    ICMPH_TYPE_SET(echo, ICMP_ECHO);
+    ICMPH_CODE_SET(echo, 0);
+    echo->id = lwip_htons(PROBE_ID);
+    echo->seqno = lwip_htons(++nextSequence);
+    memset((uint8_t*)echo + sizeof(*echo), 0xA5, PROBE_PAYLOAD);
+    echo->chksum = 0;
+    echo->chksum = inet_chksum(echo, packet->len);
+
+    ip_addr_t destination;
+    uint32_t address = target.address;
+    IP_ADDR4(&destination, address & 0xFF, (address >> 8) & 0xFF, (address >> 16) & 0xFF, address >> 24);
+    target.sentAtUs = micros();
+    if (raw_sendto(pcb, packet, &destination) == ERR_OK) {
+      markSent(target, nowMs, rssi);
+    }
+    pbuf_free(packet);
+  }
+
+  // Called by lwIP for every ICMP packet. lwIP runs between two loop() passes, never in the
+  // middle of one, so the target state needs no locking. Returns 1 when the packet was ours.
+  static u8_t onReceive(void* arg, struct raw_pcb* pcb, struct pbuf* packet, const ip_addr_t* address) {
+    (void)pcb;
+    uint32_t nowUs = micros();
+    struct icmp_echo_hdr echo;
+    const struct ip_hdr* header = (const struct ip_hdr*)packet->payload; // Raw IPv4 packets keep their IP header
+    u16_t headerLength = IPH_HL_BYTES(header);
+    if (packet->tot_len < headerLength + sizeof(echo) ||
+        pbuf_copy_partial(packet, &echo, sizeof(echo), headerLength) != sizeof(echo) ||
+        ICMPH_TYPE(&echo) != ICMP_ER || echo.id != lwip_htons(PROBE_ID)) {
+      return 0; // Not a reply to us, let lwIP handle it
+    }
+    static_cast<LinkMonitor*>(arg)->handleReply(ip_addr_get_ip4_u32(address), lwip_ntohs(echo.seqno), nowUs);
+    pbuf_free(packet);
+    return 1;
+  }
+
+  struct raw_pcb* pcb = nullptr;
+#else
+  void resolve(TargetState& target, uint32_t nowMs) {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    addrinfo* result = nullptr;
+    target.resolvedAtMs = nowMs;
+    if (getaddrinfo(target.config->host, nullptr, &hints, &result) == 0) {
+      target.address = ((sockaddr_in*)result->ai_addr)->sin_addr.s_addr;
+      freeaddrinfo(result);
+    }
+  }
+
+  void sendProbe(TargetState& target, uint32_t nowMs, int8_t rssi) {
+    if (fd < 0) {
+      return;
+    }
+    uint8_t packet[sizeof(icmphdr) + PROBE_PAYLOAD];
+    memset(packet, 0xA5, sizeof(packet));
+    icmphdr* echo = (icmphdr*)packet;
+    echo->type = ICMP_ECHO;
+    echo->code = 0;
+    echo->checksum = 0; // The kernel fills in the identifier and checksum of a ping socket
+    echo->un.echo.sequence = htons(++nextSequence);
+    sockaddr_in destination = {};
+    destination.sin_family = AF_INET;
+    destination.sin_addr.s_addr = target.address;
+    target.sentAtUs = micros();
+    if (sendto(fd, packet, sizeof(packet), 0, (sockaddr*)&destination, sizeof(destination)) == (ssize_t)sizeof(packet)) {
+      markSent(target, nowMs, rssi);
+    }
+  }
+
+  void receiveReplies() {
+    uint8_t packet[64];
+    sockaddr_in source;
+    socklen_t sourceLength = sizeof(source);
+    ssize_t length;
+    while (fd >= 0 && (length = recvfrom(fd, packet, sizeof(packet), 0, (sockaddr*)&source, &sourceLength)) > 0) {
+      const icmphdr* echo = (const icmphdr*)packet;
+      if (length >= (ssize_t)sizeof(icmphdr) && echo->type == ICMP_ECHOREPLY) {
+        handleReply(source.sin_addr.s_addr, ntohs(echo->un.echo.sequence), micros());
+      }
+      sourceLength = sizeof(source);
+    }
+  }
+
+  int fd = -1;
+#endif
+
+  void markSent(TargetState& target, uint32_t nowMs, int8_t rssi) {
+    target.outstanding = true;
+    target.sequence = nextSequence;
+    target.sentAtMs = nowMs;
+    target.sentRssi = rssi;
+  }
+
+  TargetState state[TargetCount];
+  uint32_t intervalMs;
+  uint32_t timeoutMs;
+  uint16_t nextSequence = 0;
+  RssiLatency rssiLatency;
+};
+
+#endif // LINK_MONITOR_H
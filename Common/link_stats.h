@@ -0,0 +1,179 @@
+// link_stats.h
+// Does not depend on any Arduino header, so it can be checked on the host.
+#ifndef LINK_STATS_H
+#define LINK_STATS_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Upper bounds of the round-trip time buckets in milliseconds. A last bucket takes everything slower.
+const uint16_t RTT_BOUNDS_MS[] = { 2, 5, 10, 20, 50, 100, 200, 500, 1000 };
+const size_t RTT_BUCKETS = sizeof(RTT_BOUNDS_MS) / sizeof(RTT_BOUNDS_MS[0]) + 1;
+
+// Probe results of one target over one report period: loss, round-trip time histogram and jitter.
+// Jitter is the smoothed difference between consecutive round trips, as RTP computes it (RFC 3550).
+class RttStats {
+public:
+  void recordReply(uint32_t rttUs) {
+    size_t bucket = 0;
+    while (bucket < RTT_BUCKETS - 1 && rttUs > RTT_BOUNDS_MS[bucket] * 1000UL) {
+      bucket++;
+    }
+    counts[bucket]++;
+    replies++;
+    sumUs += rttUs;
+    if (replies == 1 || rttUs < minUs) {
+      minUs = rttUs;
+    }
+    if (rttUs > maxUs) {
+      maxUs = rttUs;
+    }
+    if (hasLast) {
+      int32_t difference = (int32_t)(rttUs - lastUs);
+      uint32_t magnitude = difference < 0 ? -difference : difference;
+      jitterUs += ((int32_t)magnitude - jitterUs) / 16;
+    }
+    lastUs = rttUs;
+    hasLast = true;
+  }
+
+  void recordLoss() { losses++; }
+
+  // Start a new period. The jitter is a running estimate and carries over.
+  void reset() {
+    for (size_t i = 0; i < RTT_BUCKETS; i++) {
+      counts[i] = 0;
+    }
+    replies = 0;
+    losses = 0;
+    sumUs = 0;
+    minUs = 0;
+    maxUs = 0;
+  }
+
+  uint32_t sent() const { return replies + losses; }
+  uint32_t received() const { return replies; }
+  uint32_t lost() const { return losses; }
+  uint32_t min() const { return minUs; }
+  uint32_t max() const { return maxUs; }
+  uint32_t mean() const { return replies ? sumUs / replies : 0; }
+  uint32_t jitter() const { return (uint32_t)jitterUs; }
+
+  // Loss in percent of the probes that were answered or timed out
+  float lossPercent() const { return sent() ? 100.0f * losses / sent() : 0; }
+
+  // Upper bound of the bucket holding the percentile, 0 to 100, in microseconds. Capped by the slowest reply.
+  uint32_t percentileUs(uint8_t percentile) const {
+    if (replies == 0) {
+      return 0;
+    }
+    uint32_t rank = ((uint64_t)replies * percentile + 99) / 100;
+    uint32_t seen = 0;
+    for (size_t i = 0; i < RTT_BUCKETS - 1; i++) {
+      seen += counts[i];
+      if (seen >= rank && seen > 0) {
+        return RTT_BOUNDS_MS[i] * 1000UL < maxUs ? RTT_BOUNDS_MS[i] * 1000UL : maxUs;
+      }
+    }
+    return maxUs;
+  }
+
+private:
+  uint32_t counts[RTT_BUCKETS] = {};
+  uint32_t replies = 0;
+  uint32_t losses = 0;
+  uint64_t sumUs = 0;
+  uint32_t minUs = 0;
+  uint32_t maxUs = 0;
+  uint32_t lastUs = 0;
+  bool hasLast = false;
+  int32_t jitterUs = 0;
+};
+
+// Signal strength bands used to group the probes, in dBm
+const int8_t RSSI_BAND_FLOORS[] = { -60, -70, -80 }; // Lowest RSSI of each band but the last
+const size_t RSSI_BANDS = sizeof(RSSI_BAND_FLOORS) / sizeof(RSSI_BAND_FLOORS[0]) + 1;
+const char* const RSSI_BAND_NAMES[RSSI_BANDS] = { "strong", "good", "fair", "weak" }; // -60 and up, to -70, to -80, below
+
+// Signal strength taken with every probe, set against its outcome. Reports the RSSI range, the
+// mean round trip and loss per RSSI band, and the Pearson correlation between RSSI and round trip:
+// close to -1 when a weaker signal (lower RSSI) goes with slower replies.
+class RssiLatency {
+public:
+  void recordReply(int8_t rssi, uint32_t rttUs) {
+    recordRssi(rssi);
+    size_t band = bandOf(rssi);
+    bandReplies[band]++;
+    bandSumUs[band] += rttUs;
+    double x = rssi;
+    double y = rttUs / 1000.0;
+    n++;
+    sumX += x;
+    sumY += y;
+    sumXX += x * x;
+    sumYY += y * y;
+    sumXY += x * y;
+  }
+
+  void recordLoss(int8_t rssi) {
+    recordRssi(rssi);
+    bandLosses[bandOf(rssi)]++;
+  }
+
+  void reset() { *this = RssiLatency(); }
+
+  uint32_t samples() const { return rssiCount; }
+  int8_t min() const { return minRssi; }
+  int8_t max() const { return maxRssi; }
+  float mean() const { return rssiCount ? (float)rssiSum / rssiCount : 0; }
+  uint32_t bandReplyCount(size_t band) const { return bandReplies[band]; }
+  uint32_t bandLossCount(size_t band) const { return bandLosses[band]; }
+  uint32_t bandMeanUs(size_t band) const { return bandReplies[band] ? bandSumUs[band] / bandReplies[band] : 0; }
+
+  // Pearson correlation of RSSI and round-trip time, NAN with fewer than 3 replies or a constant RSSI
+  float correlation() const {
+    if (n < 3) {
+      return NAN;
+    }
+    double covariance = n * sumXY - sumX * sumY;
+    double varianceX = n * sumXX - sumX * sumX;
+    double varianceY = n * sumYY - sumY * sumY;
+    if (varianceX <= 0 || varianceY <= 0) {
+      return NAN;
+    }
+    return covariance / sqrt(varianceX * varianceY);
+  }
+
+private:
+  static size_t bandOf(int8_t rssi) {
+    size_t band = 0;
+    while (band < RSSI_BANDS - 1 && rssi < RSSI_BAND_FLOORS[band]) {
+      band++;
+    }
+    return band;
+  }
+
+  void recordRssi(int8_t rssi) {
+    if (rssiCount == 0 || rssi < minRssi) {
+      minRssi = rssi;
+    }
+    if (rssiCount == 0 || rssi > maxRssi) {
+      maxRssi = rssi;
+    }
+    rssiSum += rssi;
+    rssiCount++;
+  }
+
+  uint32_t rssiCount = 0;
+  int32_t rssiSum = 0;
+  int8_t minRssi = 0;
+  int8_t maxRssi = 0;
+  uint32_t bandReplies[RSSI_BANDS] = {};
+  uint32_t bandLosses[RSSI_BANDS] = {};
+  uint64_t bandSumUs[RSSI_BANDS] = {};
+  uint32_t n = 0;
+  double sumX = 0, sumY = 0, sumXX = 0, sumYY = 0, sumXY = 0;
+};
+
+#endif // LINK_STATS_H
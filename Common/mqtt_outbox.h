@@ -0,0 +1,293 @@
+// mqtt_outbox.h
+// Does not depend on any Arduino header, so it can be checked on the host.
+#ifndef MQTT_OUTBOX_H
+#define MQTT_OUTBOX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Lower values are sent first
+enum OutboxPriority {
+  PRIORITY_ACK = 0, // Reply to a command received over MQTT
+  PRIORITY_REPORT = 1 // State report or telemetry nobody is waiting for
+};
+
+// One queued message. topic must point to storage that outlives the message (a global).
+template <size_t MaxPayload>
+struct OutboxMessage {
+  const char* topic;
+  uint8_t payload[MaxPayload];
+  uint16_t length;
+  uint8_t priority;
+  bool used; // Slot holds a message
+  bool inFlight; // Sent and waiting for its PUBACK
+  uint8_t attempts; // Times the message was sent
+  uint16_t packetId; // MQTT packet identifier while in flight
+  uint32_t queuedAt; // Time the message was queued, for the ack latency
+  uint32_t sentAt; // Time of the last send, for the PUBACK timeout
+};
+
+// Bounded queue of outbound QoS1 publishes.
+//
+// Handlers only queue a message, which never touches the socket. service() is called from loop()
+// and keeps at most window messages in flight, sending the highest priority and then the oldest
+// first. A message stays in its slot until the broker acknowledges it: without a PUBACK within
+// ackTimeoutMs it is sent again with the DUP flag, and after maxAttempts sends it is dropped.
+// When the queue is full a new message replaces the oldest waiting message of a lower priority,
+// otherwise it is dropped. Every drop is counted.
+template <size_t Capacity, size_t MaxPayload>
+class MqttOutbox {
+public:
+  typedef OutboxMessage<MaxPayload> Message;
+
+  MqttOutbox(uint8_t window, uint32_t ackTimeoutMs, uint8_t maxAttempts)
+      : window(window < Capacity ? window : Capacity), ackTimeoutMs(ackTimeoutMs), maxAttempts(maxAttempts) {}
+
+  // Queue a message, returns false if it was dropped
+  bool enqueue(const char* topic, const uint8_t* payload, size_t length, OutboxPriority priority, uint32_t now) {
+    if (length > MaxPayload) {
+      dropped++;
+      return false;
+    }
+    Message* slot = freeSlot();
+    if (slot == nullptr) {
+      slot = victim(priority);
+      if (slot == nullptr) {
+        dropped++;
+        return false;
+      }
+      dropped++; // The replaced message is lost
+    }
+    slot->topic = topic;
+    memcpy(slot->payload, payload, length);
+    slot->length = length;
+    slot->priority = priority;
+    slot->used = true;
+    slot->inFlight = false;
+    slot->attempts = 0;
+    slot->queuedAt = now;
+    return true;
+  }
+
+  // Resend timed out messages, then fill the window. send(message, dup) writes one PUBLISH and
+  // returns false if the socket did not take it, which ends this pass.
+  template <typename Send>
+  void service(uint32_t now, Send send) {
+    for (size_t i = 0; i < Capacity; i++) {
+      Message& message = messages[i];
+      if (!message.used || !message.inFlight || now - message.sentAt < ackTimeoutMs) {
+        continue;
+      }
+      if (message.attempts >= maxAttempts) {
+        message.used = false;
+        inFlightCount--;
+        dropped++;
+        continue;
+      }
+      if (!send(message, true)) {
+        return;
+      }
+      message.attempts++;
+      message.sentAt = now;
+      retries++;
+    }
+
+    while (inFlightCount < window) {
+      Message* next = nextToSend();
+      if (next == nullptr) {
+        return;
+      }
+      next->packetId = nextPacketId();
+      if (!send(*next, false)) {
+        return;
+      }
+      next->inFlight = true;
+      next->attempts = 1;
+      next->sentAt = now;
+      inFlightCount++;
+    }
+  }
+
+  // Call with the packet identifier of every PUBACK
+  void acknowledge(uint16_t packetId, uint32_t now) {
+    for (size_t i = 0; i < Capacity; i++) {
+      Message& message = messages[i];
+      if (message.used && message.inFlight && message.packetId == packetId) {
+        message.used = false;
+        inFlightCount--;
+        acked++;
+        lastAckLatencyMs = now - message.queuedAt;
+        totalAckLatencyMs += lastAckLatencyMs;
+        if (lastAckLatencyMs > maxAckLatencyMs) {
+          maxAckLatencyMs = lastAckLatencyMs;
+        }
+        return;
+      }
+    }
+  }
+
+  // Call when the connection is lost: the broker forgets unacknowledged messages with the
+  // session, so everything in flight is sent again after the reconnect
+  void requeue() {
+    for (size_t i = 0; i < Capacity; i++) {
+      messages[i].inFlight = false;
+    }
+    inFlightCount = 0;
+  }
+
+  // Messages queued or in flight
+  size_t depth() const {
+    size_t count = 0;
+    for (size_t i = 0; i < Capacity; i++) {
+      count += messages[i].used;
+    }
+    return count;
+  }
+
+  uint8_t inFlight() const { return inFlightCount; }
+  uint32_t averageAckLatencyMs() const { return acked ? totalAckLatencyMs / acked : 0; }
+
+  // Counters since boot
+  uint32_t acked = 0; // Messages acknowledged by the broker
+  uint32_t retries = 0; // Sends repeated after a PUBACK timeout
+  uint32_t dropped = 0; // Messages lost to a full queue, an oversized payload or too many attempts
+  uint32_t lastAckLatencyMs = 0; // From enqueue() to PUBACK
+  uint32_t maxAckLatencyMs = 0;
+
+private:
+  Message* freeSlot() {
+    for (size_t i = 0; i < Capacity; i++) {
+      if (!messages[i].used) {
+        return &messages[i];
+      }
+    }
+    return nullptr;
+  }
+
+  // Oldest waiting message of a lower priority than the one being queued
+  Message* victim(OutboxPriority priority) {
+    Message* oldest = nullptr;
+    for (size_t i = 0; i < Capacity; i++) {
+      Message& message = messages[i];
+      if (message.inFlight || message.priority <= priority) {
+        continue;
+      }
+      if (oldest == nullptr || (int32_t)(message.queuedAt - oldest->queuedAt) < 0) {
+        oldest = &message;
+      }
+    }
+    return oldest;
+  }
+
+  // Waiting message with the highest priority, the oldest among equals
+  Message* nextToSend() {
+    Message* best = nullptr;
+    for (size_t i = 0; i < Capacity; i++) {
+      Message& message = messages[i];
+      if (!message.used || message.inFlight) {
+        continue;
+      }
+      if (best == nullptr || message.priority < best->priority ||
+          (message.priority == best->priority && (int32_t)(message.queuedAt - best->queuedAt) < 0)) {
+        best = &message;
+      }
+    }
+    return best;
+  }
+
+  // Identifiers start at 0x8000 so they never meet the small ones PubSubClient uses for SUBSCRIBE
+  uint16_t nextPacketId() {
+    lastPacketId = lastPacketId >= 0xFFFF ? 0x8000 : lastPacketId + 1;
+    return lastPacketId;
+  }
+
+  Message messages[Capacity] = {};
+  uint8_t window;
+  uint32_t ackTimeoutMs;
+  uint8_t maxAttempts;
+  uint8_t inFlightCount = 0;
+  uint16_t lastPacketId = 0x7FFF;
+  uint32_t totalAckLatencyMs = 0;
+};
+
+// Write a QoS1 PUBLISH packet to out, returns its length or 0 if it does not fit
+inline size_t encodeQos1Publish(uint8_t* out, size_t outSize, const char* topic, const uint8_t* payload,
+                                size_t length, uint16_t packetId, bool dup) {
+  size_t topicLength = strlen(topic);
+  size_t remaining = 2 + topicLength + 2 + length;
+  if (remaining > 0x3FFF || outSize < 3 + remaining) {
+    return 0; // Two length bytes cover 16 kB, far more than a message here
+  }
+  size_t pos = 0;
+  out[pos++] = 0x32 | (dup ? 0x08 : 0x00); // PUBLISH, QoS 1
+  if (remaining < 128) {
+    out[pos++] = remaining;
+  } else {
+    out[pos++] = (remaining & 0x7F) | 0x80;
+    out[pos++] = remaining >> 7;
+  }
+  out[pos++] = topicLength >> 8;
+  out[pos++] = topicLength & 0xFF;
+  memcpy(out + pos, topic, topicLength);
+  pos += topicLength;
+  out[pos++] = packetId >> 8;
+  out[pos++] = packetId & 0xFF;
+  memcpy(out + pos, payload, length);
+  return pos + length;
+}
+
+// Follows the packet framing of the bytes read from the broker and reports every PUBACK.
+// PubSubClient reads and discards PUBACKs, so the outbox learns about them here.
+class PubackDetector {
+public:
+  // Feed one received byte, returns true when it completes a PUBACK
+  bool feed(uint8_t byte, uint16_t& packetId) {
+    switch (state) {
+      case HEADER:
+        type = byte >> 4;
+        remaining = 0;
+        shift = 0;
+        state = LENGTH;
+        return false;
+      case LENGTH:
+        remaining |= (uint32_t)(byte & 0x7F) << shift;
+        shift += 7;
+        if (byte & 0x80) {
+          return false;
+        }
+        position = 0;
+        state = remaining ? BODY : HEADER;
+        return false;
+      case BODY:
+        if (position < 2) {
+          id = (id << 8) | byte;
+        }
+        position++;
+        if (position < remaining) {
+          return false;
+        }
+        state = HEADER;
+        if (type == 4 && remaining == 2) { // PUBACK
+          packetId = id;
+          return true;
+        }
+        return false;
+    }
+    return false;
+  }
+
+  // Call before a new connection, a dropped one can end in the middle of a packet
+  void reset() { state = HEADER; }
+
+private:
+  enum State { HEADER, LENGTH, BODY };
+  State state = HEADER;
+  uint8_t type = 0;
+  uint8_t shift = 0;
+  uint32_t remaining = 0;
+  uint32_t position = 0;
+  uint16_t id = 0;
+};
+
+#endif // MQTT_OUTBOX_H
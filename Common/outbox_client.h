@@ -0,0 +1,79 @@
+// outbox_client.h
+#ifndef OUTBOX_CLIENT_H
+#define OUTBOX_CLIENT_H
+
+#include <Arduino.h>
+#include <WiFiClientSecureBearSSL.h>
+#include "mqtt_outbox.h"
+
+// TLS client that carries an outbox of QoS1 publishes.
+//
+// Handlers queue() a message, which never touches the socket, and service() writes the queued
+// messages from loop(). PubSubClient reads one byte at a time and ignores PUBACKs, so read()
+// also shows every byte to a PubackDetector, which is where the outbox learns that the broker
+// has a message.
+template <size_t Capacity, size_t MaxPayload>
+class OutboxClient : public BearSSL::WiFiClientSecure {
+public:
+  typedef MqttOutbox<Capacity, MaxPayload> Outbox;
+
+  OutboxClient(uint8_t window, uint32_t ackTimeoutMs, uint8_t maxAttempts) : outbox(window, ackTimeoutMs, maxAttempts) {}
+
+  using BearSSL::WiFiClientSecure::read;
+
+  int read() override {
+    int c = BearSSL::WiFiClientSecure::read();
+    uint16_t packetId;
+    if (c >= 0 && pubackDetector.feed(c, packetId)) {
+      outbox.acknowledge(packetId, millis());
+    }
+    return c;
+  }
+
+  // Queue a message for topic, which must be a global. Returns false if it was dropped.
+  bool queue(const char* topic, const char* payload, OutboxPriority priority) {
+    if (outbox.enqueue(topic, (const uint8_t*)payload, strlen(payload), priority, millis())) {
+      return true;
+    }
+    Serial.print("Outbox full, message on ");
+    Serial.print(topic);
+    Serial.println(" dropped");
+    return false;
+  }
+
+  // Send queued messages and resend unacknowledged ones. Call from loop(), only while the MQTT
+  // session is up: the TLS socket is open before CONNACK, and a PUBLISH must not precede it.
+  void service() {
+    outbox.service(millis(), [this](const typename Outbox::Message& message, bool dup) {
+      uint8_t packet[MaxPayload + 64];
+      size_t length = encodeQos1Publish(packet, sizeof(packet), message.topic, message.payload, message.length, message.packetId, dup);
+      return length > 0 && this->write(packet, length) == length;
+    });
+  }
+
+  // Call before every connect, a dropped connection can end in the middle of a packet
+  void beginConnection() { pubackDetector.reset(); }
+
+  // Call when the connection is dropped. The broker forgets unacknowledged messages with the
+  // session, so everything in flight is sent again after the reconnect.
+  void endConnection() { outbox.requeue(); }
+
+  // Outbox counters as JSON, for the /outbox route
+  String countersJson() const {
+    return "{\"depth\": " + String(outbox.depth()) +
+           ", \"inFlight\": " + String(outbox.inFlight()) +
+           ", \"acked\": " + String(outbox.acked) +
+           ", \"retries\": " + String(outbox.retries) +
+           ", \"dropped\": " + String(outbox.dropped) +
+           ", \"ackLatencyMs\": {\"last\": " + String(outbox.lastAckLatencyMs) +
+           ", \"average\": " + String(outbox.averageAckLatencyMs()) +
+           ", \"max\": " + String(outbox.maxAckLatencyMs) + "}}";
+  }
+
+  Outbox outbox;
+
+private:
+  PubackDetector pubackDetector;
+};
+
+#endif // OUTBOX_CLIENT_H
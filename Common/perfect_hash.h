@@ -0,0 +1,87 @@
+// perfect_hash.h
+// Does not depend on any Arduino header, so it can be checked on the host.
+#ifndef PERFECT_HASH_H
+#define PERFECT_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// FNV-1a with a seed and a final mix, so the low bits used for the slot depend on every character
+constexpr uint32_t perfectHash(const char* key, uint32_t seed) {
+  uint32_t hash = 2166136261u ^ seed;
+  while (*key) {
+    hash = (hash ^ (uint8_t)*key++) * 16777619u;
+  }
+  return hash ^ (hash >> 15);
+}
+
+// Smallest power of two of at least twice the number of names, keeps the seed search short
+constexpr size_t perfectHashSlots(size_t count) {
+  size_t slots = 4;
+  while (slots < 2 * count) {
+    slots <<= 1;
+  }
+  return slots;
+}
+
+// Lookup table from a fixed set of names to their position in a constexpr array, built by the
+// compiler. Entry is any struct with a const char* name member.
+//
+// The constructor searches for a seed that gives every name its own slot, so a lookup is one
+// hash of the key, one slot read and one strcmp against the only name that can match. That
+// strcmp is what rejects unknown keys. The cost does not grow with the number of entries.
+template <typename Entry, size_t N>
+class PerfectHash {
+public:
+  static_assert(N > 0 && N < 255, "slots hold an entry index in a uint8_t");
+
+  static constexpr size_t SLOTS = perfectHashSlots(N);
+  static constexpr uint8_t EMPTY = 0xFF;
+  static constexpr uint32_t MAX_SEED = 10000; // The search gives up after this many seeds
+
+  constexpr PerfectHash(const Entry (&entries)[N]) : entries(entries), seed(0), slots() {
+    for (seed = 0; seed < MAX_SEED; seed++) {
+      if (place()) {
+        return;
+      }
+    }
+  }
+
+  // False if no seed was found, for example because two entries have the same name
+  constexpr bool valid() const { return seed < MAX_SEED; }
+
+  // Position of the entry with this name, or -1 if there is none
+  int find(const char* key) const {
+    if (key == nullptr) {
+      return -1;
+    }
+    uint8_t index = slots[perfectHash(key, seed) & (SLOTS - 1)];
+    if (index == EMPTY || strcmp(entries[index].name, key) != 0) {
+      return -1;
+    }
+    return index;
+  }
+
+private:
+  // Try the current seed, returns false on the first collision
+  constexpr bool place() {
+    for (size_t slot = 0; slot < SLOTS; slot++) {
+      slots[slot] = EMPTY;
+    }
+    for (size_t i = 0; i < N; i++) {
+      size_t slot = perfectHash(entries[i].name, seed) & (SLOTS - 1);
+      if (slots[slot] != EMPTY) {
+        return false;
+      }
+      slots[slot] = (uint8_t)i;
+    }
+    return true;
+  }
+
+  const Entry* entries;
+  uint32_t seed;
+  uint8_t slots[SLOTS];
+};
+
+#endif // PERFECT_HASH_H
@@ -0,0 +1,46 @@
+// tls_session.h
+#ifndef TLS_SESSION_H
+#define TLS_SESSION_H
+
+#include <Arduino.h>
+#include <WiFiClientSecureBearSSL.h>
+
+// TLS session kept between connections, so a reconnect can resume it and skip the full handshake.
+//
+// attach() offers the session to the TLS client, which falls back to a full handshake if the
+// broker refuses it and stores the new session either way. connect() runs the call that makes
+// the handshake and times it. A resumed session keeps its ID and master secret and a full
+// handshake replaces them, so comparing a snapshot taken before the call tells the two apart.
+class TlsSession {
+public:
+  // Offer the session on the next connection of client
+  void attach(BearSSL::WiFiClientSecure& client) { client.setSession(&session); }
+
+  // Run connect(), which returns whether the connection is up, and record how the handshake went
+  template <typename Connect>
+  bool connect(Connect connect) {
+    BearSSL::Session previous = session; // Snapshot on the stack, it is only needed for the comparison
+    unsigned long start = millis();
+    bool connected = connect();
+    handshakeMs = millis() - start;
+    if (connected) {
+      resumed = valid && memcmp(&previous, &session, sizeof(session)) == 0;
+      valid = true;
+    }
+    return connected;
+  }
+
+  // Result of the last successful connect(), e.g. "TLS session resumed in 180 ms"
+  String summary() const {
+    return String(resumed ? "TLS session resumed" : "Full TLS handshake") + " in " + String(handshakeMs) + " ms";
+  }
+
+  bool resumed = false; // The last successful connect() resumed the session
+  unsigned long handshakeMs = 0; // Duration of the last connect(), successful or not
+
+private:
+  BearSSL::Session session;
+  bool valid = false; // True once session holds a negotiated session
+};
+
+#endif // TLS_SESSION_H
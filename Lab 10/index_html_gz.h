@@ -0,0 +1,75 @@
+// index_html_gz.h
+// Generated by Tools/web-compiler from web/index.html. Do not edit, regenerate it instead.
+#ifndef INDEX_HTML_GZ_H
+#define INDEX_HTML_GZ_H
+
+#include <pgmspace.h>
+
+// 2816 bytes of HTML, 2230 minified, 984 gzipped
+#define INDEX_HTML_ETAG "\"8341eb50\""
+const uint8_t indexHtmlGz[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x95, 0x56, 0x5d, 0x6f, 0xdb, 0x38,
+  0x10, 0x7c, 0xd7, 0xaf, 0xd8, 0xba, 0x0f, 0x94, 0xd1, 0x58, 0xba, 0x38, 0xb9, 0xc0, 0xb0, 0x65,
+  0x17, 0x68, 0x91, 0x5c, 0xef, 0x90, 0x26, 0x87, 0x3a, 0x0f, 0x07, 0xb4, 0x45, 0x40, 0x4b, 0x94,
+  0xc4, 0x2b, 0x4d, 0xaa, 0x24, 0x95, 0xd8, 0xd7, 0xf8, 0xbf, 0xdf, 0x52, 0x94, 0x3f, 0x13, 0x17,
+  0x68, 0xa2, 0x58, 0x22, 0x77, 0x39, 0x3b, 0x9c, 0x59, 0xca, 0x49, 0x4a, 0x3b, 0x17, 0x93, 0x20,
+  0x29, 0x19, 0xcd, 0xf0, 0x66, 0xb9, 0x15, 0x6c, 0x72, 0x39, 0xfd, 0x7b, 0xd0, 0xbf, 0xb8, 0x80,
+  0xf7, 0x4a, 0x5a, 0xad, 0x44, 0x12, 0xfb, 0xe9, 0x20, 0x31, 0x76, 0xe9, 0xee, 0x33, 0x95, 0x2d,
+  0xe1, 0x07, 0xe4, 0x18, 0xee, 0xe5, 0x74, 0xce, 0xc5, 0x72, 0x08, 0x73, 0x25, 0x95, 0xa9, 0x68,
+  0xca, 0x46, 0x60, 0xd9, 0xc2, 0xf6, 0xa8, 0xe0, 0x85, 0x1c, 0x42, 0xca, 0xa4, 0x65, 0x7a, 0x04,
+  0x33, 0x9a, 0x7e, 0x2b, 0xb4, 0xaa, 0x65, 0xd6, 0x4b, 0x95, 0x50, 0x7a, 0x08, 0xaf, 0xfb, 0x83,
+  0x7e, 0x7a, 0x76, 0x3e, 0x82, 0x76, 0xfc, 0x58, 0x72, 0x8b, 0x8b, 0x57, 0x41, 0x94, 0x22, 0x2e,
+  0xe5, 0x92, 0x69, 0xac, 0x91, 0x71, 0x53, 0x09, 0x8a, 0xf8, 0xb9, 0x60, 0x8b, 0x11, 0xfc, 0x5b,
+  0x1b, 0xcb, 0xf3, 0x65, 0xcf, 0xa5, 0x20, 0xf2, 0x16, 0xdf, 0x85, 0x7b, 0x8f, 0x9a, 0x56, 0x08,
+  0x84, 0x9f, 0x0d, 0xce, 0x4c, 0x2d, 0x10, 0xa1, 0xa2, 0x59, 0xc6, 0x65, 0x31, 0x84, 0xfe, 0x6f,
+  0x15, 0x22, 0xcc, 0xa9, 0x2e, 0xb8, 0x5c, 0x8f, 0x5e, 0xa0, 0x75, 0x7e, 0x8e, 0x9c, 0x66, 0x4a,
+  0x67, 0x4c, 0xf7, 0x34, 0xcd, 0x78, 0x6d, 0x86, 0x70, 0xda, 0x24, 0xaf, 0x82, 0x59, 0x6d, 0xad,
+  0x92, 0xbb, 0xa0, 0x2e, 0x72, 0x80, 0xec, 0x93, 0x1b, 0x71, 0x0c, 0xff, 0x8f, 0xe1, 0xc4, 0x85,
+  0x9b, 0x48, 0x6b, 0x6d, 0x5c, 0x81, 0x4a, 0xf1, 0xa3, 0x92, 0x0c, 0x06, 0x83, 0x43, 0x3d, 0x3c,
+  0x93, 0x21, 0x48, 0x25, 0xd9, 0x33, 0x5e, 0xbf, 0x7b, 0x5a, 0x11, 0x35, 0x29, 0xe7, 0x3d, 0xaa,
+  0xed, 0xda, 0x95, 0xb6, 0x70, 0xdf, 0xc5, 0x05, 0x4a, 0xd9, 0x2b, 0x19, 0x2f, 0x4a, 0xd4, 0xeb,
+  0x74, 0xad, 0xb0, 0x51, 0x82, 0x61, 0xb6, 0x27, 0xdd, 0xb3, 0xaa, 0x5a, 0x4b, 0xb2, 0xb7, 0xb5,
+  0x17, 0x59, 0x9e, 0x9d, 0x9d, 0x1d, 0x51, 0x68, 0xd7, 0x79, 0xc1, 0x72, 0xeb, 0x8a, 0x25, 0x71,
+  0xdb, 0x35, 0x49, 0xdc, 0x36, 0x99, 0x6b, 0x1f, 0xd7, 0x72, 0xa7, 0xcf, 0x1b, 0x0d, 0xe7, 0x82,
+  0xa4, 0xd2, 0x0c, 0x52, 0x41, 0x8d, 0x19, 0x93, 0xcd, 0xc6, 0xc8, 0x04, 0xf0, 0xe7, 0x1e, 0xaf,
+  0x00, 0xff, 0x9e, 0xe0, 0x09, 0xaf, 0x7b, 0x08, 0xdc, 0x07, 0xdc, 0xdf, 0x37, 0x53, 0x4d, 0xe0,
+  0x58, 0x04, 0x87, 0x4f, 0x78, 0xe1, 0x43, 0x12, 0x23, 0x3e, 0x56, 0xc9, 0xf8, 0xc3, 0xba, 0xca,
+  0xa6, 0xe1, 0x08, 0xf0, 0x6c, 0x4c, 0x34, 0xc3, 0x8e, 0x33, 0x64, 0x92, 0xc4, 0x98, 0xf3, 0x2c,
+  0xd3, 0x09, 0xe7, 0xf3, 0xda, 0xc1, 0xb5, 0x2a, 0xb6, 0xb9, 0x26, 0xd5, 0xbc, 0xb2, 0x93, 0x20,
+  0xaf, 0x65, 0x6a, 0x39, 0xf6, 0x8a, 0x55, 0x45, 0x21, 0xd8, 0x27, 0x07, 0x19, 0x36, 0xc0, 0x27,
+  0x40, 0x9b, 0x48, 0x17, 0x7e, 0x04, 0x0f, 0x54, 0xc3, 0xa2, 0xd4, 0x30, 0x06, 0xc9, 0x1e, 0xe1,
+  0x9f, 0x8f, 0xd7, 0x1f, 0xac, 0xad, 0x3e, 0xb1, 0xef, 0x35, 0x33, 0x36, 0xec, 0x8e, 0x02, 0x8c,
+  0x45, 0xaa, 0x62, 0x32, 0x24, 0x7f, 0x5c, 0xde, 0x91, 0x13, 0x20, 0x31, 0x81, 0x37, 0xd0, 0xc0,
+  0xe0, 0xdd, 0x8f, 0x3c, 0xda, 0x09, 0x58, 0x5d, 0xb3, 0x76, 0x89, 0x61, 0x32, 0xc3, 0xe5, 0x10,
+  0xc7, 0x70, 0x57, 0xb2, 0x06, 0xdb, 0x58, 0x6a, 0x51, 0x55, 0x35, 0x67, 0xa6, 0xb1, 0x14, 0xa8,
+  0x01, 0xda, 0xcc, 0xd6, 0x06, 0xd8, 0x03, 0x9e, 0xa2, 0x60, 0xb5, 0x25, 0xdd, 0x54, 0x78, 0xa7,
+  0x16, 0x9e, 0xf1, 0x9a, 0xa9, 0x3b, 0x4f, 0x63, 0xc8, 0x54, 0x5a, 0xcf, 0x31, 0x3f, 0x2a, 0x98,
+  0xbd, 0x14, 0xcc, 0x3d, 0xbe, 0x5b, 0xfe, 0x99, 0xb5, 0xa9, 0xa3, 0x80, 0xe7, 0x10, 0xbe, 0xc2,
+  0x54, 0xb7, 0xea, 0x60, 0x45, 0xaa, 0x19, 0xb2, 0x68, 0x17, 0x85, 0x04, 0x15, 0x23, 0xb8, 0x00,
+  0x93, 0x22, 0x9e, 0x61, 0x5e, 0x83, 0xe0, 0xc7, 0x8d, 0xdc, 0x37, 0x74, 0xce, 0x70, 0x9a, 0xe0,
+  0x04, 0x69, 0xd3, 0x24, 0x9a, 0xf4, 0xe1, 0xee, 0xe3, 0xb5, 0x9b, 0x4e, 0xca, 0xfe, 0x64, 0x4f,
+  0x0e, 0x6c, 0x9f, 0xfe, 0x24, 0xa9, 0xd0, 0x8b, 0xca, 0x05, 0x82, 0x4e, 0xd2, 0x9e, 0xd7, 0xd6,
+  0x3c, 0x25, 0x09, 0x28, 0x99, 0x0a, 0x9e, 0x7e, 0x1b, 0x7f, 0xe9, 0xec, 0x1a, 0x43, 0x3a, 0x3b,
+  0x38, 0x1d, 0x27, 0x34, 0xe6, 0x76, 0xbf, 0x74, 0x26, 0x77, 0xb5, 0x96, 0xb0, 0x17, 0x84, 0xdb,
+  0x9b, 0x24, 0xf6, 0xb8, 0x93, 0xce, 0x4b, 0x45, 0xf2, 0xfc, 0x17, 0xaa, 0x60, 0xf2, 0xb1, 0x32,
+  0x57, 0x57, 0xdb, 0x3a, 0xa3, 0xe0, 0x98, 0xea, 0xeb, 0x66, 0xed, 0x46, 0xb4, 0xc2, 0x46, 0xc9,
+  0xde, 0x97, 0x5c, 0x64, 0xa1, 0x93, 0x7f, 0x84, 0x86, 0x6a, 0x66, 0x1d, 0x32, 0x0e, 0x47, 0xbb,
+  0xf6, 0x9a, 0x52, 0x3d, 0x4e, 0x1b, 0xeb, 0x43, 0xdf, 0x01, 0xce, 0xab, 0x5c, 0x69, 0x08, 0x9d,
+  0xcd, 0x9e, 0x03, 0x97, 0xb0, 0x8d, 0x6d, 0xdd, 0x3f, 0xe8, 0x0c, 0x6f, 0x0b, 0xf6, 0xab, 0x5e,
+  0x4e, 0x99, 0x60, 0xa9, 0x55, 0x3a, 0x24, 0x15, 0xb2, 0xd9, 0x75, 0x6a, 0x63, 0x10, 0x70, 0x03,
+  0xce, 0xb1, 0xb6, 0xea, 0xe7, 0x26, 0xf0, 0x15, 0xde, 0x02, 0xb9, 0xbd, 0x21, 0x30, 0xc4, 0xdb,
+  0xd5, 0x15, 0x79, 0x19, 0x33, 0x72, 0x86, 0xf8, 0xb6, 0xb8, 0xe6, 0xc6, 0x46, 0x5e, 0xd7, 0x90,
+  0xb8, 0xee, 0x7f, 0x60, 0xa8, 0xe5, 0x1e, 0xe4, 0x31, 0x0c, 0x27, 0xf7, 0xcf, 0x40, 0x5e, 0x1d,
+  0xa2, 0xac, 0xf0, 0xd7, 0x6d, 0xbe, 0x39, 0x21, 0xa6, 0x3d, 0xa7, 0x97, 0x6e, 0x30, 0x55, 0xb5,
+  0x4e, 0x71, 0x6d, 0xec, 0x43, 0x8e, 0xb6, 0x7f, 0x42, 0xa6, 0xee, 0xc8, 0x62, 0xee, 0x46, 0xef,
+  0xd0, 0x69, 0x78, 0xd4, 0xc1, 0x9d, 0xd7, 0xc8, 0xbe, 0x6e, 0x84, 0x6c, 0x8e, 0x70, 0x5e, 0x0b,
+  0x01, 0x42, 0x15, 0x4e, 0x41, 0x3c, 0xdd, 0x16, 0x68, 0x81, 0x2f, 0x2c, 0xec, 0x33, 0xc7, 0x4c,
+  0x2f, 0x01, 0xed, 0xe8, 0x22, 0x8e, 0xc4, 0x9d, 0x06, 0xab, 0x0d, 0x13, 0x7c, 0x93, 0x37, 0x5c,
+  0xdd, 0x66, 0x19, 0xe2, 0x86, 0xc4, 0xef, 0x0f, 0x77, 0xba, 0xe5, 0xc6, 0x1c, 0xb9, 0x9d, 0x8e,
+  0xf8, 0x6b, 0x7a, 0x7b, 0x13, 0x55, 0x54, 0x1b, 0x16, 0xb2, 0x28, 0xa3, 0x96, 0x76, 0x9d, 0x0e,
+  0xdd, 0x9f, 0x80, 0xae, 0x5f, 0x8a, 0xcf, 0x50, 0x7f, 0x75, 0xcb, 0x6f, 0xc6, 0xe0, 0x4b, 0xfa,
+  0x82, 0xf8, 0xcd, 0xd1, 0xbe, 0x4d, 0xf1, 0x24, 0xf8, 0xef, 0x8c, 0xd8, 0xff, 0xbb, 0xf2, 0x3f,
+  0x4c, 0x61, 0xcb, 0x84, 0xb6, 0x08, 0x00, 0x00,
+};
+
+#endif // INDEX_HTML_GZ_H
@@ -0,0 +1,96 @@
+// latency_histogram.h
+// Does not depend on any Arduino header, so it can be checked on the host.
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Upper bounds of the buckets in microseconds. A last bucket takes everything slower.
+const uint32_t LATENCY_BOUNDS_US[] = { 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 1000000 };
+const size_t LATENCY_BUCKETS = sizeof(LATENCY_BOUNDS_US) / sizeof(LATENCY_BOUNDS_US[0]) + 1;
+
+// Count of durations per fixed bucket, enough for Prometheus and for p50/p99 estimates.
+// record() is a short scan of the bounds and a few additions, cheap enough to time every loop stage.
+class LatencyHistogram {
+public:
+  void record(uint32_t us) {
+    size_t bucket = 0;
+    while (bucket < LATENCY_BUCKETS - 1 && us > LATENCY_BOUNDS_US[bucket]) {
+      bucket++;
+    }
+    counts[bucket]++;
+    total++;
+    sumUs += us;
+    if (us > maxUs) {
+      maxUs = us;
+    }
+  }
+
+  uint32_t count() const { return total; }
+  uint64_t sum() const { return sumUs; }
+  uint32_t max() const { return maxUs; }
+
+  // What was recorded after earlier, a copy of this histogram taken before. The result keeps
+  // the worst time since boot, which only the percentiles of the last bucket use.
+  LatencyHistogram since(const LatencyHistogram& earlier) const {
+    LatencyHistogram difference = *this;
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+      difference.counts[i] -= earlier.counts[i];
+    }
+    difference.total -= earlier.total;
+    difference.sumUs -= earlier.sumUs;
+    return difference;
+  }
+
+  // Upper bound of the bucket holding the percentile, 0 to 100. Slower than the last bound, it is the worst time seen.
+  uint32_t percentileUs(uint8_t percentile) const {
+    if (total == 0) {
+      return 0;
+    }
+    uint64_t rank = ((uint64_t)total * percentile + 99) / 100; // 1-based rank of the sample
+    if (rank == 0) {
+      rank = 1;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS - 1; i++) {
+      seen += counts[i];
+      if (seen >= rank) {
+        return LATENCY_BOUNDS_US[i] < maxUs ? LATENCY_BOUNDS_US[i] : maxUs;
+      }
+    }
+    return maxUs;
+  }
+
+  // Write the samples of a Prometheus histogram in seconds. emit(line) is called for every line,
+  // labels is empty or a list such as stage="web", without braces.
+  template <typename Emit>
+  void writePrometheus(const char* name, const char* labels, Emit emit) const {
+    char line[160];
+    const char* separator = labels[0] ? "," : "";
+    uint32_t cumulative = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS - 1; i++) {
+      cumulative += counts[i];
+      snprintf(line, sizeof(line), "%s_bucket{%s%sle=\"%g\"} %lu\n", name, labels, separator,
+               LATENCY_BOUNDS_US[i] / 1e6, (unsigned long)cumulative);
+      emit(line);
+    }
+    snprintf(line, sizeof(line), "%s_bucket{%s%sle=\"+Inf\"} %lu\n", name, labels, separator, (unsigned long)total);
+    emit(line);
+    const char* braceOpen = labels[0] ? "{" : "";
+    const char* braceClose = labels[0] ? "}" : "";
+    snprintf(line, sizeof(line), "%s_sum%s%s%s %.6f\n", name, braceOpen, labels, braceClose, sumUs / 1e6);
+    emit(line);
+    snprintf(line, sizeof(line), "%s_count%s%s%s %lu\n", name, braceOpen, labels, braceClose, (unsigned long)total);
+    emit(line);
+  }
+
+private:
+  uint32_t counts[LATENCY_BUCKETS] = {};
+  uint32_t total = 0;
+  uint64_t sumUs = 0;
+  uint32_t maxUs = 0;
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -6,8 +6,23 @@
 #include <PubSubClient.h> // Library for MQTT communication
 #include <WiFiClientSecureBearSSL.h> // Library for secure WiFi connections using BearSSL
 #include <ESP8266WebServer.h> // Library for creating a web server on the ESP8266
+#include <uri/UriBraces.h> // Route patterns with a {} placeholder, used for the relay routes
 #include <ArduinoJson.h> // Library for parsing JSON data
 #include <time.h> // Library for time functions, used for NTP
+#include "index_html_gz.h" // Gzipped control page generated by Tools/web-compiler
+#include "console_log.h" // Fixed-size console log with sequence numbers
+#include "event_stream.h" // Server-Sent Events streams of the open pages
+#include "perfect_hash.h" // Compile-time lookup tables for MQTT topics and relay names
+#include "outbox_client.h" // TLS client with a queue of outbound QoS1 publishes
+#include "connection_manager.h" // WiFi, NTP, DNS, TLS and MQTT stages with backoff
+#include "latency_histogram.h" // Fixed-bucket latency histograms for /metrics
+#include "link_monitor.h" // Background ICMP probes with round-trip, jitter, loss and RSSI statistics
+#include "dns_cache.h" // Background refresh of the broker and NTP names, with hit rates and resolve times
+#include "tls_session.h" // TLS session resumption, with the handshake time of every connect
+#include "aws_certs.h" // Device certificate, key and root CA, parsed once at startup
+#if __has_include("aws_certs_der.h")
+#include "aws_certs_der.h" // Certificates precompiled to DER by Tools/cert-compiler
+#endif
 
 // Blynk authentication token
 char auth[] = "YourBlynkAuthToken"; // Replace with your Blynk authentication token
@@ -19,8 +34,17 @@ char pass[] = "YourPassword"; // Replace with your WiFi password
 // AWS IoT Core parameters
 const char* awsEndpoint = "YourAWSEndpoint"; // Replace with your AWS IoT endpoint
 const int awsPort = 8883; // Port for AWS IoT
-const char* controlTopic = "ESP8266/control/relay"; // Topic for controlling relays
+const char* ntpServer1 = "pool.ntp.org"; // NTP servers, resolved through dnsCache like the endpoint
+const char* ntpServer2 = "time.nist.gov";
+constexpr const char* controlTopic = "ESP8266/control/relay"; // Topic for controlling relays
 const char* statusTopic = "ESP8266/status/relay"; // Topic for relay status
+constexpr const char* shadowDeltaTopic = "$aws/things/ESP8266-01/shadow/update/delta"; // Device Shadow delta topic, replace ESP8266-01 with your thing name
+const char* shadowUpdateTopic = "$aws/things/ESP8266-01/shadow/update"; // Device Shadow update topic, the reported state goes here
+const char* shadowGetTopic = "$aws/things/ESP8266-01/shadow/get"; // An empty message here asks for the full shadow document
+constexpr const char* shadowGetAcceptedTopic = "$aws/things/ESP8266-01/shadow/get/accepted"; // The full shadow document, with its current version
+constexpr const char* shadowDeleteAcceptedTopic = "$aws/things/ESP8266-01/shadow/delete/accepted"; // Sent when the shadow is deleted
+const char* metricsTopic = "ESP8266/metrics/relay"; // Topic for the periodic latency summary
+const char* linkTopic = "ESP8266/link/relay"; // Topic for the periodic link-quality summary
 
 // AWS IoT certificates and keys
 const char* awsCert = R"EOF(
@@ -41,19 +65,129 @@ const char* awsRootCA = R"EOF(
 -----END CERTIFICATE-----
 )EOF";
 
-// Relay pins
-const int relay1Pin = D6; // GPIO pin for relay 1
-const int relay2Pin = D7; // GPIO pin for relay 2
+// Relay table, one row per relay. Adding a row is all it takes to add a relay:
+// the web routes, MQTT commands, Blynk virtual pins, /status and the page are all driven by this table.
+struct Relay {
+  uint8_t pin; // GPIO pin the relay is wired to
+  uint8_t activeLevel; // Level that turns the relay on, LOW for the usual active-low modules
+  uint8_t virtualPin; // Blynk virtual pin that controls and shows the relay
+  const char* name; // Name used in URLs, MQTT messages and /status
+};
+#if __has_include("relay_table.h")
+#include "relay_table.h" // Another table in place of the one below, e.g. the 16 rows of Tools/relay-check
+#else
+constexpr Relay relays[] = {
+  { D6, LOW, V1, "relay1" },
+  { D7, LOW, V2, "relay2" },
+};
+#endif
+const uint8_t RELAY_COUNT = sizeof(relays) / sizeof(relays[0]);
+static_assert(RELAY_COUNT <= 16, "relayStates has one bit per relay");
+constexpr PerfectHash<Relay, RELAY_COUNT> relayIndex(relays); // Finds a relay by name without comparing against every row
+static_assert(relayIndex.valid(), "relay names must be unique");
+
+// Where a relay command came from, for the log and so the change is not echoed back to its source
+enum RelaySource { FROM_WEB, FROM_MQTT, FROM_BLYNK, FROM_SHADOW, SOURCE_COUNT };
+const char* relaySourceNames[] = { "", " via MQTT", " via Blynk", " via shadow" };
+
+// Channels told about relay changes. Each keeps its own view of the relays, so a change is not
+// sent back to the channel it came from and changes that cancel out are not sent at all.
+enum RelayChannel { CHANNEL_MQTT, CHANNEL_BLYNK, CHANNEL_SHADOW, CHANNEL_COUNT };
+const unsigned long RELAY_PUBLISH_WINDOW_MS = 1000; // A channel gets at most one update per relay in this time
+struct ChannelSync {
+  uint16_t knownStates; // Relay states as the channel last saw them
+  uint32_t syncedEpoch[RELAY_COUNT]; // Value of relayEpoch the channel is up to date with, per relay
+  unsigned long lastSent[RELAY_COUNT]; // millis() value of the last update per relay
+  uint32_t sent; // Updates sent
+  uint32_t coalesced; // Changes folded into a later update or cancelled out
+  uint32_t echoes; // Changes not sent back to the channel they came from
+};
 
 // Global variables
-BearSSL::WiFiClientSecure wifiClient; // Secure WiFi client
+const size_t OUTBOX_CAPACITY = 8; // Messages waiting for the broker, queued or in flight
+const size_t OUTBOX_MAX_PAYLOAD = 128; // Longest payload that can be queued
+const uint8_t OUTBOX_WINDOW = 2; // QoS1 messages sent before waiting for their PUBACK
+const unsigned long PUBACK_TIMEOUT_MS = 5000; // Send again with DUP if the PUBACK takes longer
+const uint8_t PUBLISH_MAX_ATTEMPTS = 5; // Drop a message after this many sends
+// The full shadow document has up to five entries per relay (desired, reported and delta states, and
+// the metadata timestamps of two of them), about 115 bytes. A larger one is dropped by PubSubClient
+// and shadowVersion stays 0, which accepts every delta: only the check for stale deltas is lost.
+const uint16_t MQTT_BUFFER_SIZE = 256 + 128 * RELAY_COUNT; // Largest incoming message, with its topic
+OutboxClient<OUTBOX_CAPACITY, OUTBOX_MAX_PAYLOAD> wifiClient(OUTBOX_WINDOW, PUBACK_TIMEOUT_MS, PUBLISH_MAX_ATTEMPTS); // Secure WiFi client, queues the status messages
+TlsSession tlsSession; // Kept between connections so reconnects can skip the full handshake
+AwsCertificates awsCertificates; // Parsed once and kept for as long as the TLS client uses them
 PubSubClient mqttClient(wifiClient); // MQTT client
 ESP8266WebServer server(80); // Web server
-bool relay1State = false; // Track the state of relay 1
-bool relay2State = false; // Track the state of relay 2
-String consoleLog = ""; // Log for console output on the webpage
+const char* cacheHeaders[] = { "If-None-Match" }; // Request headers the web server keeps for handleRoot()
+const int MAX_EVENT_CLIENTS = 5; // Open pages that can receive pushed updates at the same time
+const unsigned long EVENT_KEEPALIVE_MS = 15000; // Idle streams get a comment this often, so dead ones are noticed
+EventStream<MAX_EVENT_CLIENTS> events(EVENT_KEEPALIVE_MS); // Server-Sent Events streams of the open pages
+uint32_t consolePushed = 0; // Sequence number of the first console line not yet pushed to the event streams
+uint16_t relayStatesPushed = 0; // Relay states last pushed to the event streams
+
+// Stages of loop(), in the order it runs them. Each has a latency histogram exported at /metrics.
+enum LoopStage { STAGE_CONNECTION, STAGE_BLYNK, STAGE_MQTT, STAGE_RELAYS, STAGE_OUTBOX, STAGE_WEB, STAGE_EVENTS, STAGE_LINK, STAGE_COUNT };
+const char* loopStageNames[] = { "connection", "blynk", "mqtt", "relays", "outbox", "web", "events", "link" };
+// Web routes with a latency histogram of their own
+enum WebRoute { ROUTE_ROOT, ROUTE_STATUS, ROUTE_CONSOLE, ROUTE_CONNECTION, ROUTE_OUTBOX, ROUTE_PUBLICATIONS,
+                ROUTE_EVENTS, ROUTE_METRICS, ROUTE_DNS, ROUTE_RELAY_ON, ROUTE_RELAY_OFF, ROUTE_COUNT };
+const char* webRouteNames[] = { "/", "/status", "/console", "/connection", "/outbox", "/publications",
+                                "/events", "/metrics", "/dns", "/{}/on", "/{}/off" };
+LatencyHistogram stageLatency[STAGE_COUNT]; // Time of each loop() stage
+LatencyHistogram routeLatency[ROUTE_COUNT]; // Time of each route handler
+LatencyHistogram loopLatency; // Time of a whole loop() iteration
+const unsigned long LOOP_IDLE_US = 200; // An iteration this short found nothing to do
+uint64_t loopTotalUs = 0; // Time spent in loop() since boot
+uint64_t loopIdleUs = 0; // Part of it spent in iterations shorter than LOOP_IDLE_US
+const unsigned long METRICS_PUBLISH_INTERVAL_MS = 60000; // Publish a latency summary on metricsTopic this often, 0 turns it off
+unsigned long lastMetricsPublish = 0; // millis() value of the last summary
+LatencyHistogram stageLatencyPublished[STAGE_COUNT]; // Copies taken at the last summary, so each summary covers its own interval
+LatencyHistogram loopLatencyPublished;
+uint64_t loopTotalUsPublished = 0;
+uint64_t loopIdleUsPublished = 0;
+uint16_t relayStates = 0; // Bit i is set while relay i is on
+uint32_t relayEpoch[RELAY_COUNT] = {}; // Number of changes of each relay, a channel is current when its epoch matches
+ChannelSync channelSync[CHANNEL_COUNT] = {}; // What MQTT, Blynk and the device shadow know about the relays
+uint32_t relayChanges[SOURCE_COUNT] = {}; // Relay changes per RelaySource
+uint32_t shadowVersion = 0; // Version of the shadow the board last saw, older deltas are dropped
+uint32_t shadowStaleDeltas = 0; // Deltas dropped because their version was not newer
+bool shadowResync = true; // Report every relay to the shadow once, set on every connect
+bool blynkResync = false; // Write every relay to Blynk once, set by BLYNK_CONNECTED()
+const size_t CONSOLE_LINES = 32; // Lines kept for the web console, older ones are overwritten
+const size_t CONSOLE_LINE_LENGTH = 96; // Longer lines are truncated
+ConsoleLog<CONSOLE_LINES, CONSOLE_LINE_LENGTH> consoleLog; // Log for console output on the webpage, constant memory
+
+// Link-quality monitor: the targets are probed in the background, loop() never waits for a reply
+const LinkTarget linkTargets[] = {
+  { "gateway", nullptr }, // The access point's router, shows the quality of the Wi-Fi hop alone
+  { "internet", "1.1.1.1" }, // A public resolver that answers pings
+};
+const unsigned long LINK_PROBE_INTERVAL_MS = 5000; // Each target is probed this often
+const unsigned long LINK_PROBE_TIMEOUT_MS = 1000; // A probe without a reply after this long is lost
+const unsigned long LINK_PUBLISH_INTERVAL_MS = 60000; // Publish a link summary on linkTopic this often, 0 turns it off
+LinkMonitor<sizeof(linkTargets) / sizeof(linkTargets[0])> linkMonitor(linkTargets, LINK_PROBE_INTERVAL_MS, LINK_PROBE_TIMEOUT_MS);
+unsigned long lastLinkPublish = 0; // millis() value of the last link summary
+
+// DNS cache: the names are refreshed from loop(), so a reconnect finds the endpoint's address without a query
+const DnsName dnsNames[] = {
+  { "aws", awsEndpoint },
+  { "ntp1", ntpServer1 },
+  { "ntp2", ntpServer2 },
+};
+const size_t DNS_AWS = 0; // Index of awsEndpoint in dnsNames
+const unsigned long DNS_CHECK_INTERVAL_MS = 1000; // Each name is checked this often, an expired one is queried again
+DnsCache<sizeof(dnsNames) / sizeof(dnsNames[0])> dnsCache(dnsNames, DNS_CHECK_INTERVAL_MS);
+
+// Connection to AWS IoT, advanced from loop() by connection.service()
+ConnectionManager<decltype(wifiClient), decltype(dnsCache)> connection(
+  { ssid, pass, ntpServer1, ntpServer2, awsEndpoint, awsPort, "ESP8266Client", DNS_AWS }, wifiClient, mqttClient, dnsCache, tlsSession);
+
+// Function to count the free outbox slots
+size_t outboxSpace() {
+  return OUTBOX_CAPACITY - wifiClient.outbox.depth();
+}
 
-// Function to publish relay status to AWS IoT
+// Function to queue a relay status message for AWS IoT
 void publishRelayStatus(const char* relay, const char* state) {
   StaticJsonDocument<200> doc;
   doc["device_id"] = "ESP8266-01"; // Replace with your device ID
@@ -61,341 +195,670 @@ void publishRelayStatus(const char* relay, const char* state) {
   doc["status"] = state;
   doc["timestamp"] = time(nullptr); // Current time in seconds since the Epoch
 
-  char buffer[256];
-  size_t n = serializeJson(doc, buffer);
-  mqttClient.publish(statusTopic, buffer, n);
+  char buffer[OUTBOX_MAX_PAYLOAD];
+  if (measureJson(doc) >= sizeof(buffer)) {
+    Serial.print(relay);
+    Serial.println(" status too long for the outbox, not sent");
+    return;
+  }
+  serializeJson(doc, buffer);
+  wifiClient.queue(statusTopic, buffer, PRIORITY_REPORT);
 }
 
-// Callback function to handle messages received from AWS IoT
-void messageReceived(char* topic, byte* payload, unsigned int length) {
-  Serial.print("Message arrived [");
-  Serial.print(topic);
-  Serial.print("]: ");
-  String message;
-  for (unsigned int i = 0; i < length; i++) {
-    Serial.print((char)payload[i]);
-    message += (char)payload[i];
+// Function to queue the reply to a command that carried an "id", ahead of the state reports.
+// The sender matches it to its command by the id, e.g. to measure the round trip.
+void publishCommandAck(const char* relay, const char* state, JsonVariantConst id) {
+  StaticJsonDocument<200> doc;
+  doc["device_id"] = "ESP8266-01"; // Replace with your device ID
+  doc["relay"] = relay;
+  doc["status"] = state;
+  doc["id"] = id;
+  doc["timestamp"] = time(nullptr);
+
+  char buffer[OUTBOX_MAX_PAYLOAD];
+  if (measureJson(doc) >= sizeof(buffer)) {
+    Serial.println("Command id too long, no reply sent");
+    return;
   }
-  Serial.println();
+  serializeJson(doc, buffer);
+  wifiClient.queue(statusTopic, buffer, PRIORITY_ACK);
+}
 
-  // Add to console log
-  consoleLog += "Message arrived [" + String(topic) + "]: " + message + "<br>";
+// Function to check whether a relay is on
+bool relayOn(uint8_t index) {
+  return relayStates & (1u << index);
+}
 
-  // Parse the JSON payload
+// Function to switch a relay. publishRelayChanges() tells the other channels about it.
+void setRelay(uint8_t index, bool on, RelaySource source) {
+  const Relay& relay = relays[index];
+  digitalWrite(relay.pin, on ? relay.activeLevel : !relay.activeLevel);
+  if (on) {
+    relayStates |= 1u << index;
+  } else {
+    relayStates &= ~(1u << index);
+  }
+
+  char message[CONSOLE_LINE_LENGTH]; // No String, so a command from MQTT is handled without touching the heap
+  snprintf(message, sizeof(message), "%s turned %s%s", relay.name, on ? "ON" : "OFF", relaySourceNames[source]);
+  Serial.println(message);
+  consoleLog.add(message);
+
+  relayEpoch[index]++;
+  relayChanges[source]++;
+  if (source == FROM_WEB || source == FROM_SHADOW) {
+    return; // A change from the shadow is reported back, that is what clears its delta
+  }
+  // The channel that sent the change already shows the new state
+  ChannelSync& sync = channelSync[source == FROM_MQTT ? CHANNEL_MQTT : CHANNEL_BLYNK];
+  sync.coalesced += relayEpoch[index] - 1 - sync.syncedEpoch[index]; // Earlier changes it was still waiting for
+  sync.syncedEpoch[index] = relayEpoch[index];
+  if (on) {
+    sync.knownStates |= 1u << index;
+  } else {
+    sync.knownStates &= ~(1u << index);
+  }
+  sync.echoes++;
+}
+
+// Shadow report of every relay, {"state": {"reported": {...}}}. Its JSON is cut into outbox-sized
+// updates by addShadowReport(), the document only has to hold the tree.
+typedef StaticJsonDocument<2 * JSON_OBJECT_SIZE(1) + JSON_OBJECT_SIZE(RELAY_COUNT)> ShadowReport;
+
+// Function to queue a shadow update, refused if its JSON would not fit an outbox message
+void queueShadowReport(ShadowReport& report) {
+  char buffer[OUTBOX_MAX_PAYLOAD];
+  if (measureJson(report) >= sizeof(buffer)) {
+    Serial.println("Shadow report too long for the outbox, not sent");
+  } else {
+    serializeJson(report, buffer);
+    wifiClient.queue(shadowUpdateTopic, buffer, PRIORITY_REPORT);
+  }
+  report.clear();
+}
+
+// Function to add a relay to the shadow report. When the report would no longer fit an outbox
+// message, the relays before it go out as one update and the report starts again. The shadow
+// merges reported fields, so several partial updates leave the same document as one full one.
+void addShadowReport(ShadowReport& report, uint8_t index, bool on) {
+  const char* name = relays[index].name;
+  report["state"]["reported"][name] = on ? "ON" : "OFF";
+  if (measureJson(report) < OUTBOX_MAX_PAYLOAD || report["state"]["reported"].size() == 1) {
+    return; // Fits, or is a single relay that queueShadowReport() will refuse
+  }
+  report["state"]["reported"].remove(name);
+  queueShadowReport(report);
+  report["state"]["reported"][name] = on ? "ON" : "OFF";
+}
+
+// Function to send relay changes to MQTT, Blynk and the device shadow, called from loop(). Each
+// channel gets the latest state of a relay at most once per RELAY_PUBLISH_WINDOW_MS, and nothing
+// if the state it last saw is still current. The shadow fields due in one pass share as few updates as fit.
+void publishRelayChanges() {
+  unsigned long now = millis();
+  ShadowReport shadowReport; // Only the changed relays, or all of them after a connect
+
+  // After a connect the shadow gets every relay once, it answers with a delta if desired differs.
+  // The report waits for an empty outbox, so none of the updates it is split into is refused.
+  if (shadowResync && connection.state == CONN_READY && outboxSpace() == OUTBOX_CAPACITY) {
+    ChannelSync& sync = channelSync[CHANNEL_SHADOW];
+    for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+      addShadowReport(shadowReport, i, relayOn(i));
+      sync.syncedEpoch[i] = relayEpoch[i];
+      sync.lastSent[i] = now;
+      sync.sent++;
+    }
+    sync.knownStates = relayStates;
+    shadowResync = false;
+  }
+
+  // Blynk drops what is written while it is offline, so after a connect its widgets get every relay
+  if (blynkResync && Blynk.connected()) {
+    ChannelSync& sync = channelSync[CHANNEL_BLYNK];
+    for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+      Blynk.virtualWrite(relays[i].virtualPin, relayOn(i) ? 1 : 0);
+      sync.syncedEpoch[i] = relayEpoch[i];
+      sync.lastSent[i] = now;
+      sync.sent++;
+    }
+    sync.knownStates = relayStates;
+    blynkResync = false;
+  }
+
+  for (int channel = 0; channel < CHANNEL_COUNT; channel++) {
+    ChannelSync& sync = channelSync[channel];
+    if (channel == CHANNEL_SHADOW && connection.state != CONN_READY) {
+      continue; // Changes made while offline go out with the resync
+    }
+    if (channel == CHANNEL_BLYNK && !Blynk.connected()) {
+      continue; // Same for Blynk, a write now would be lost and still count as sent
+    }
+    for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+      uint32_t pending = relayEpoch[i] - sync.syncedEpoch[i];
+      if (pending == 0 || now - sync.lastSent[i] < RELAY_PUBLISH_WINDOW_MS) {
+        continue;
+      }
+      if ((channel == CHANNEL_MQTT && outboxSpace() == 0) ||
+          (channel == CHANNEL_SHADOW && outboxSpace() <= (shadowReport.isNull() ? 0 : 1))) {
+        break; // Outbox full, the rest stay pending until PUBACKs free some slots
+      }
+      sync.syncedEpoch[i] = relayEpoch[i];
+      bool on = relayOn(i);
+      if (on == (bool)(sync.knownStates & (1u << i))) {
+        sync.coalesced += pending; // Toggled back, or switched to the state it already had
+        continue;
+      }
+
+      if (channel == CHANNEL_MQTT) {
+        publishRelayStatus(relays[i].name, on ? "ON" : "OFF");
+      } else if (channel == CHANNEL_SHADOW) {
+        addShadowReport(shadowReport, i, on);
+      } else {
+        Blynk.virtualWrite(relays[i].virtualPin, on ? 1 : 0);
+      }
+      sync.knownStates ^= 1u << i;
+      sync.lastSent[i] = now;
+      sync.sent++;
+      sync.coalesced += pending - 1;
+    }
+  }
+
+  if (!shadowReport.isNull()) {
+    queueShadowReport(shadowReport);
+  }
+}
+
+// Function to handle a message on controlTopic
+void handleControlMessage(byte* payload, unsigned int length) {
+  char line[CONSOLE_LINE_LENGTH]; // For the error message
+
+  // Parse the JSON payload in place: the strings in doc point into payload, so nothing is copied or allocated
   StaticJsonDocument<200> doc;
-  DeserializationError error = deserializeJson(doc, message);
+  DeserializationError error = deserializeJson(doc, (char*)payload, length);
 
   if (error) {
     Serial.print("deserializeJson() failed: ");
     Serial.println(error.f_str());
-    consoleLog += "deserializeJson() failed: " + String(error.f_str()) + "<br>";
+    snprintf(line, sizeof(line), "deserializeJson() failed: %s", error.c_str());
+    consoleLog.add(line);
     return;
   }
 
-  const char* relay = doc["relay"];
+  int index = relayIndex.find(doc["relay"].as<const char*>());
   const char* state = doc["status"];
+  if (index < 0 || state == nullptr) {
+    return;
+  }
+
+  bool on;
+  if (strcmp(state, "ON") == 0) {
+    on = true;
+  } else if (strcmp(state, "OFF") == 0) {
+    on = false;
+  } else {
+    return;
+  }
+  setRelay(index, on, FROM_MQTT);
+
+  // A command without an id is not answered, the sender already knows the state it asked for
+  if (!doc["id"].isNull()) {
+    publishCommandAck(relays[index].name, state, doc["id"]);
+  }
+}
+
+// Function to apply a device shadow delta. It only holds the relays whose desired state differs
+// from the reported one, and its version tells a late or repeated delta from a new one.
+void handleShadowDelta(byte* payload, unsigned int length) {
+  StaticJsonDocument<32> filter; // Keep version and state, skip the metadata and timestamps
+  filter["version"] = true;
+  filter["state"] = true;
+  StaticJsonDocument<JSON_OBJECT_SIZE(2) + JSON_OBJECT_SIZE(RELAY_COUNT)> doc; // Version and a state with every relay
+  DeserializationError error = deserializeJson(doc, (char*)payload, length, DeserializationOption::Filter(filter));
+  if (error) {
+    Serial.print("Shadow delta not parsed: ");
+    Serial.println(error.c_str());
+    return;
+  }
+
+  uint32_t version = doc["version"];
+  if (version <= shadowVersion) {
+    shadowStaleDeltas++;
+    Serial.println("Stale shadow delta dropped");
+    return;
+  }
+  shadowVersion = version;
 
-  // Handle control message for relay 1
-  if (String(relay) == "relay1") {
-    if (String(state) == "ON") {
-      digitalWrite(relay1Pin, LOW); // Turn relay 1 on
-      relay1State = true;
-      Serial.println("Relay 1 turned ON via MQTT");
-      consoleLog += "Relay 1 turned ON via MQTT<br>";
-      publishRelayStatus("relay1", "ON");
-      Blynk.virtualWrite(V1, 1); // Sync with Blynk
-    } else if (String(state) == "OFF") {
-      digitalWrite(relay1Pin, HIGH); // Turn relay 1 off
-      relay1State = false;
-      Serial.println("Relay 1 turned OFF via MQTT");
-      consoleLog += "Relay 1 turned OFF via MQTT<br>";
-      publishRelayStatus("relay1", "OFF");
-      Blynk.virtualWrite(V1, 0); // Sync with Blynk
+  for (JsonPair field : doc["state"].as<JsonObject>()) {
+    int index = relayIndex.find(field.key().c_str());
+    const char* state = field.value();
+    if (index < 0 || state == nullptr) {
+      continue; // Not a relay, or not a string
     }
-  // Handle control message for relay 2
-  } else if (String(relay) == "relay2") {
-    if (String(state) == "ON") {
-      digitalWrite(relay2Pin, LOW); // Turn relay 2 on
-      relay2State = true;
-      Serial.println("Relay 2 turned ON via MQTT");
-      consoleLog += "Relay 2 turned ON via MQTT<br>";
-      publishRelayStatus("relay2", "ON");
-      Blynk.virtualWrite(V2, 1); // Sync with Blynk
-    } else if (String(state) == "OFF") {
-      digitalWrite(relay2Pin, HIGH); // Turn relay 2 off
-      relay2State = false;
-      Serial.println("Relay 2 turned OFF via MQTT");
-      consoleLog += "Relay 2 turned OFF via MQTT<br>";
-      publishRelayStatus("relay2", "OFF");
-      Blynk.virtualWrite(V2, 0); // Sync with Blynk
+    if (strcmp(state, "ON") == 0) {
+      setRelay(index, true, FROM_SHADOW);
+    } else if (strcmp(state, "OFF") == 0) {
+      setRelay(index, false, FROM_SHADOW);
     }
   }
 }
 
-// Time synchronization using NTP
-void NTPConnect() {
-  Serial.print("Setting time using SNTP");
-  configTime(0, 0, "pool.ntp.org", "time.nist.gov"); // Configure time using NTP servers
-  time_t now = time(nullptr);
-  while (now < 8 * 3600) { // Wait for time to be set
-    delay(500);
-    Serial.print(".");
-    now = time(nullptr);
+// Function to take the version of the full shadow document, requested on every connect. A shadow
+// that was deleted and created again counts its versions from 1, so the version is taken even
+// when it is lower than the last one seen.
+void handleShadowDocument(byte* payload, unsigned int length) {
+  StaticJsonDocument<16> filter; // Only the version, the state is reported again after a connect
+  filter["version"] = true;
+  StaticJsonDocument<32> doc;
+  DeserializationError error = deserializeJson(doc, (char*)payload, length, DeserializationOption::Filter(filter));
+  if (error) {
+    Serial.print("Shadow document not parsed: ");
+    Serial.println(error.c_str());
+    return;
   }
-  Serial.println(" done!");
-  struct tm timeinfo;
-  localtime_r(&now, &timeinfo);
-  Serial.print("Current time: ");
-  Serial.print(asctime(&timeinfo));
+  shadowVersion = doc["version"];
 }
 
-// Function to setup WiFi connection
+// Function to forget the shadow version when the shadow is deleted, the next one starts again
+// from version 1. The state is reported again so the new shadow has it.
+void handleShadowDeleted(byte* payload, unsigned int length) {
+  shadowVersion = 0;
+  shadowResync = true;
+  Serial.println("Shadow deleted, reporting the state again");
+}
+
+// MQTT topics the board handles, one row per topic. Every topic in the table is subscribed on
+// connect, and messageReceived() finds the row through topicRouter, built by the compiler.
+typedef void (*TopicHandler)(byte* payload, unsigned int length);
+struct TopicRoute {
+  const char* name; // MQTT topic
+  TopicHandler handler; // Function called with the payload of each message on the topic
+};
+constexpr TopicRoute topicRoutes[] = {
+  { controlTopic, handleControlMessage },
+  { shadowDeltaTopic, handleShadowDelta },
+  { shadowGetAcceptedTopic, handleShadowDocument },
+  { shadowDeleteAcceptedTopic, handleShadowDeleted },
+};
+constexpr PerfectHash<TopicRoute, sizeof(topicRoutes) / sizeof(topicRoutes[0])> topicRouter(topicRoutes);
+static_assert(topicRouter.valid(), "MQTT topics must be unique");
+
+// Callback function to handle messages received from AWS IoT
+void messageReceived(char* topic, byte* payload, unsigned int length) {
+  Serial.print("Message arrived [");
+  Serial.print(topic);
+  Serial.print("]: ");
+  Serial.write(payload, length);
+  Serial.println();
+
+  // Add to console log, before parsing changes the payload
+  char line[CONSOLE_LINE_LENGTH];
+  snprintf(line, sizeof(line), "Message arrived [%s]: %.*s", topic, (int)length, (const char*)payload);
+  consoleLog.add(line);
+
+  // One hash of the topic finds its handler, topics nobody subscribed to are dropped here
+  int route = topicRouter.find(topic);
+  if (route < 0) {
+    Serial.println("No handler for this topic");
+    return;
+  }
+  topicRoutes[route].handler(payload, length);
+}
+
+// Function to parse the certificates and key once at startup.
+// The TLS client only keeps pointers to them, so they must outlive every connection.
+void loadCertificates() {
+#ifdef AWS_CERTS_DER_H
+  // DER from aws_certs_der.h, no base64 decoding
+  awsCertificates.loadDer(awsCertDer, sizeof(awsCertDer), awsPrivateKeyDer, sizeof(awsPrivateKeyDer),
+                          awsRootCADer, sizeof(awsRootCADer));
+#else
+  awsCertificates.loadPem(awsCert, awsPrivateKey, awsRootCA);
+#endif
+  awsCertificates.attach(wifiClient);
+}
+
+// Function to log a connection event to the serial port and the web console
+void logConnection(const String& message) {
+  Serial.println(message);
+  consoleLog.add(message);
+}
+
+// Function to configure the MQTT client, connection.service() makes the actual connection
+void setupAWS() {
+  mqttClient.setServer(awsEndpoint, awsPort);
+  mqttClient.setCallback(messageReceived);
+  mqttClient.setBufferSize(MQTT_BUFFER_SIZE);
+}
+
+// Function to subscribe once the broker has accepted the connection, and ask for the shadow
+void onAwsConnected() {
+  for (const TopicRoute& route : topicRoutes) {
+    mqttClient.subscribe(route.name);
+  }
+  shadowResync = true; // Deltas sent while offline were missed
+  shadowVersion = 0; // Until the shadow document says otherwise, the shadow may have been recreated meanwhile
+  wifiClient.queue(shadowGetTopic, "", PRIORITY_REPORT);
+}
+
+// Function to point the link monitor at the gateway of the access point just joined
+void onWiFiConnected() {
+  linkMonitor.setGateway(WiFi.gatewayIP()); // The gateway can change with the access point
+}
+
+// Function to start the WiFi connection, connection.service() waits for it without blocking
 void setupWiFi() {
-  delay(10);
   Serial.begin(115200);
   Serial.println();
   Serial.print("Connecting to ");
   Serial.println(ssid);
-  
-  WiFi.begin(ssid, pass);
-  
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(500);
-    Serial.print(".");
+
+  connection.begin({ logConnection, onAwsConnected, onWiFiConnected });
+}
+
+// Function to serve the control page, stored gzipped in flash by Tools/web-compiler.
+// Nothing is built on the heap, and a browser that already has the page gets a 304.
+void handleRoot() {
+  server.sendHeader("ETag", INDEX_HTML_ETAG);
+  if (server.header("If-None-Match") == INDEX_HTML_ETAG) {
+    server.send(304); // The browser's copy is current
+  } else {
+    server.sendHeader("Cache-Control", "no-cache"); // Revalidate on every load so a reflashed page is picked up
+    server.sendHeader("Content-Encoding", "gzip");
+    server.send_P(200, "text/html", (const char*)indexHtmlGz, sizeof(indexHtmlGz));
   }
-  
-  Serial.println("");
-  Serial.println("WiFi connected");
-  Serial.print("IP address: ");
-  Serial.println(WiFi.localIP());
-  Serial.print("Access web interface via http://");
-  Serial.println(WiFi.localIP());
-}
-
-// Function to connect to AWS IoT Core
-void connectAWS() {
-  NTPConnect();
-
-  // Convert the certificate strings to BearSSL types
-  BearSSL::X509List cert(awsCert);
-  BearSSL::PrivateKey key(awsPrivateKey);
-  BearSSL::X509List ca(awsRootCA);
-
-  // Set the certificates and key
-  wifiClient.setClientRSACert(&cert, &key);
-  wifiClient.setTrustAnchors(&ca);
-  
-  mqttClient.setServer(awsEndpoint, awsPort);
-  mqttClient.setCallback(messageReceived);
+}
 
-  while (!mqttClient.connected()) {
-    Serial.print("Connecting to AWS IoT...");
-    
-    if (mqttClient.connect("ESP8266Client")) {
-      Serial.println("connected");
-      mqttClient.subscribe(controlTopic);
-    } else {
-      Serial.print("failed, rc=");
-      Serial.print(mqttClient.state());
-      Serial.println(" try again in 5 seconds");
-      delay(5000);
-    }
+// Function to handle /<relay>/on and /<relay>/off for every relay in the table
+void handleRelay(bool on) {
+  int index = relayIndex.find(server.pathArg(0).c_str());
+  if (index < 0) {
+    server.send(404, "text/plain", "No such relay");
+    return;
   }
+  setRelay(index, on, FROM_WEB);
+  server.send(200, "text/plain", String(relays[index].name) + " is " + (on ? "ON" : "OFF"));
 }
 
-// Function to handle the root web page
-void handleRoot() {
-  String html = "<html><head><title>ESP8266 Control</title>";
-  html += "<style>body { font-family: monospace; text-align: center; background-color: #282c34; color: white; }";
-  html += ".container { display: flex; justify-content: center; flex-wrap: wrap; }";
-  html += ".box { padding: 20px; margin: 20px; background-color: #444; border-radius: 10px; }";
-  html += "button { padding: 10px 20px; margin: 10px; font-size: 16px; cursor: pointer; background-color: #888; color: white; border: none; border-radius: 5px; }";
-  html += ".ascii-art { font-size: 12px; line-height: 1; }";
-  html += ".console { margin-top: 20px; padding: 10px; background-color: #333; border-radius: 10px; text-align: left; }";
-  html += "</style></head><body>";
-  html += "<h1>ESP8266 Control</h1>";
-  html += "<pre class='ascii-art'>    _  _\n";
-  html += "  _| || |_ \n";
-  html += " |_  __  _| \n";
-  html += "  _|| || |_ \n";
-  html += " |_  __  _| \n";
-  html += "   |_||_|   </pre>";
-  html += "<div class='container'>";
-  html += "<div class='box'><h2>Relay 1</h2>";
-  html += "<p id='status1'>Relay 1 is " + String(relay1State ? "ON" : "OFF") + "</p>";
-  html += "<button id='onButton1' onclick=\"toggleRelay('relay1', 'on')\">Turn Relay 1 ON</button>";
-  html += "<button id='offButton1' onclick=\"toggleRelay('relay1', 'off')\">Turn Relay 1 OFF</button></div>";
-  html += "<div class='box'><h2>Relay 2</h2>";
-  html += "<p id='status2'>Relay 2 is " + String(relay2State ? "ON" : "OFF") + "</p>";
-  html += "<button id='onButton2' onclick=\"toggleRelay('relay2', 'on')\">Turn Relay 2 ON</button>";
-  html += "<button id='offButton2' onclick=\"toggleRelay('relay2', 'off')\">Turn Relay 2 OFF</button></div>";
-  html += "</div>";
-  html += "<div class='console' id='consoleLog'>" + consoleLog + "</div>";
-  html += "<script>";
-  html += "function toggleRelay(relay, action) {";
-  html += "  var xhr = new XMLHttpRequest();";
-  html += "  xhr.open('GET', '/' + relay + '/' + action, true);";
-  html += "  xhr.onreadystatechange = function () {";
-  html += "    if (xhr.readyState == 4 && xhr.status == 200) {";
-  html += "      updateStatus();";
-  html += "      updateConsole();";
-  html += "    }";
-  html += "  };";
-  html += "  xhr.send();";
-  html += "}";
-  html += "function updateStatus() {";
-  html += "  var xhr = new XMLHttpRequest();";
-  html += "  xhr.open('GET', '/status', true);";
-  html += "  xhr.onreadystatechange = function () {";
-  html += "    if (xhr.readyState == 4 && xhr.status == 200) {";
-  html += "      var status = JSON.parse(xhr.responseText);";
-  html += "      document.getElementById('status1').innerHTML = 'Relay 1 is ' + (status.relay1 ? 'ON' : 'OFF');";
-  html += "      document.getElementById('status2').innerHTML = 'Relay 2 is ' + (status.relay2 ? 'ON' : 'OFF');";
-  html += "      document.getElementById('onButton1').classList.toggle('active', status.relay1);";
-  html += "      document.getElementById('offButton1').classList.toggle('active', !status.relay1);";
-  html += "      document.getElementById('onButton2').classList.toggle('active', status.relay2);";
-  html += "      document.getElementById('offButton2').classList.toggle('active', !status.relay2);";
-  html += "    }";
-  html += "  };";
-  html += "  xhr.send();";
-  html += "}";
-  html += "function updateConsole() {";
-  html += "  var xhr = new XMLHttpRequest();";
-  html += "  xhr.open('GET', '/console', true);";
-  html += "  xhr.onreadystatechange = function () {";
-  html += "    if (xhr.readyState == 4 && xhr.status == 200) {";
-  html += "      document.getElementById('consoleLog').innerHTML = xhr.responseText;";
-  html += "    }";
-  html += "  };";
-  html += "  xhr.send();";
-  html += "}";
-  html += "setInterval(updateStatus, 1000);"; // Update status every second
-  html += "setInterval(updateConsole, 1000);"; // Update console log every second
-  html += "</script>";
-  html += "</body></html>";
-  server.send(200, "text/html", html);
-}
-
-// Function to handle turning relay 1 on
-void handleRelay1On() {
-  digitalWrite(relay1Pin, LOW); // Turn relay 1 on
-  relay1State = true;
-  Serial.println("Relay 1 turned ON");
-  consoleLog += "Relay 1 turned ON<br>";
-  publishRelayStatus("relay1", "ON");
-  Blynk.virtualWrite(V1, 1); // Sync with Blynk
-  server.send(200, "text/plain", "Relay 1 is ON");
-}
-
-// Function to handle turning relay 1 off
-void handleRelay1Off() {
-  digitalWrite(relay1Pin, HIGH); // Turn relay 1 off
-  relay1State = false;
-  Serial.println("Relay 1 turned OFF");
-  consoleLog += "Relay 1 turned OFF<br>";
-  publishRelayStatus("relay1", "OFF");
-  Blynk.virtualWrite(V1, 0); // Sync with Blynk
-  server.send(200, "text/plain", "Relay 1 is OFF");
-}
-
-// Function to handle turning relay 2 on
-void handleRelay2On() {
-  digitalWrite(relay2Pin, LOW); // Turn relay 2 on
-  relay2State = true;
-  Serial.println("Relay 2 turned ON");
-  consoleLog += "Relay 2 turned ON<br>";
-  publishRelayStatus("relay2", "ON");
-  Blynk.virtualWrite(V2, 1); // Sync with Blynk
-  server.send(200, "text/plain", "Relay 2 is ON");
-}
-
-// Function to handle turning relay 2 off
-void handleRelay2Off() {
-  digitalWrite(relay2Pin, HIGH); // Turn relay 2 off
-  relay2State = false;
-  Serial.println("Relay 2 turned OFF");
-  consoleLog += "Relay 2 turned OFF<br>";
-  publishRelayStatus("relay2", "OFF");
-  Blynk.virtualWrite(V2, 0); // Sync with Blynk
-  server.send(200, "text/plain", "Relay 2 is OFF");
+// Function to handle turning a relay on
+void handleRelayOn() {
+  handleRelay(true);
+}
+
+// Function to handle turning a relay off
+void handleRelayOff() {
+  handleRelay(false);
+}
+
+// Function to describe the relay states as JSON, for /status and the event streams
+String statusText() {
+  String json = "{";
+  for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+    json += i == 0 ? "\"" : ", \"";
+    json += relays[i].name;
+    json += relayOn(i) ? "\": true" : "\": false";
+  }
+  json += "}";
+  return json;
 }
 
 // Function to handle status requests
 void handleStatus() {
-  String json = "{\"relay1\": " + String(relay1State ? "true" : "false") + ", \"relay2\": " + String(relay2State ? "true" : "false") + "}";
-  server.send(200, "application/json", json);
+  server.send(200, "application/json", statusText());
 }
 
-// Function to handle console log requests
+// Function to handle console log requests, /console?since=N only returns the lines numbered N and up.
+// X-Console-Next tells the page which number to ask for next.
 void handleConsole() {
-  server.send(200, "text/plain", consoleLog);
+  uint32_t since = server.hasArg("since") ? strtoul(server.arg("since").c_str(), nullptr, 10) : 0;
+  if (since > consoleLog.next()) {
+    since = 0; // The board restarted since the page last asked
+  }
+  String lines;
+  consoleLog.appendTo(lines, since, consoleLog.next());
+  server.sendHeader("X-Console-Next", String(consoleLog.next()));
+  server.send(200, "text/plain", lines);
+}
+
+// Function to report the current connection stage
+void handleConnection() {
+  server.send(200, "text/plain", connection.stateName());
+}
+
+// Function to report the DNS cache: address, hit rate and resolve times of each name since boot
+void handleDns() {
+  char json[1024];
+  if (dnsCache.writeSummary(json, sizeof(json)) == 0) {
+    server.send(500, "text/plain", "DNS summary too long");
+    return;
+  }
+  server.send(200, "application/json", json);
+}
+
+// Function to report how many relay changes came in and how many updates each channel was sent
+void handlePublications() {
+  String json = "{\"changes\": {\"web\": " + String(relayChanges[FROM_WEB]) +
+                ", \"mqtt\": " + String(relayChanges[FROM_MQTT]) +
+                ", \"blynk\": " + String(relayChanges[FROM_BLYNK]) +
+                ", \"shadow\": " + String(relayChanges[FROM_SHADOW]) + "}";
+  const char* channelNames[] = { "mqtt", "blynk", "shadow" };
+  for (int channel = 0; channel < CHANNEL_COUNT; channel++) {
+    const ChannelSync& sync = channelSync[channel];
+    json += String(", \"") + channelNames[channel] + "\": {\"sent\": " + String(sync.sent) +
+            ", \"coalesced\": " + String(sync.coalesced) + ", \"echoes\": " + String(sync.echoes) + "}";
+  }
+  json += ", \"shadowVersion\": " + String(shadowVersion) + ", \"staleDeltas\": " + String(shadowStaleDeltas) + "}";
+  server.send(200, "application/json", json);
+}
+
+// Function to report the outbox counters
+void handleOutbox() {
+  server.send(200, "application/json", wifiClient.countersJson());
+}
+
+// Function to export the latency histograms and the loop idle ratio in Prometheus text format
+void handleMetrics() {
+  // Sent in chunks as it is written, the whole text is several kB
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/plain; version=0.0.4", "");
+  String chunk;
+  chunk.reserve(600);
+  auto emit = [&chunk](const char* line) {
+    chunk += line;
+    if (chunk.length() >= 512) {
+      server.sendContent(chunk);
+      chunk = "";
+    }
+  };
+
+  char labels[48];
+  emit("# HELP esp8266_loop_duration_seconds Time of one loop() iteration.\n");
+  emit("# TYPE esp8266_loop_duration_seconds histogram\n");
+  loopLatency.writePrometheus("esp8266_loop_duration_seconds", "", emit);
+  emit("# HELP esp8266_loop_stage_duration_seconds Time of each stage of loop().\n");
+  emit("# TYPE esp8266_loop_stage_duration_seconds histogram\n");
+  for (int stage = 0; stage < STAGE_COUNT; stage++) {
+    snprintf(labels, sizeof(labels), "stage=\"%s\"", loopStageNames[stage]);
+    stageLatency[stage].writePrometheus("esp8266_loop_stage_duration_seconds", labels, emit);
+  }
+  emit("# HELP esp8266_http_request_duration_seconds Time of each web route handler.\n");
+  emit("# TYPE esp8266_http_request_duration_seconds histogram\n");
+  for (int route = 0; route < ROUTE_COUNT; route++) {
+    snprintf(labels, sizeof(labels), "route=\"%s\"", webRouteNames[route]);
+    routeLatency[route].writePrometheus("esp8266_http_request_duration_seconds", labels, emit);
+  }
+  char line[96];
+  emit("# HELP esp8266_loop_idle_ratio Share of loop() time spent in iterations that found nothing to do.\n");
+  emit("# TYPE esp8266_loop_idle_ratio gauge\n");
+  snprintf(line, sizeof(line), "esp8266_loop_idle_ratio %.4f\n", loopTotalUs ? (double)loopIdleUs / loopTotalUs : 0.0);
+  emit(line);
+  server.sendContent(chunk);
+}
+
+// Function to publish the p50 and p99 of every loop stage since the last summary, called from loop().
+// It goes out directly with QoS0: a lost summary is replaced by the next one.
+void publishMetrics() {
+  if (METRICS_PUBLISH_INTERVAL_MS == 0 || connection.state != CONN_READY ||
+      millis() - lastMetricsPublish < METRICS_PUBLISH_INTERVAL_MS) {
+    return;
+  }
+  lastMetricsPublish = millis();
+
+  uint64_t totalUs = loopTotalUs - loopTotalUsPublished;
+  double idle = totalUs ? (double)(loopIdleUs - loopIdleUsPublished) / totalUs : 0.0;
+  LatencyHistogram loopInterval = loopLatency.since(loopLatencyPublished);
+  char payload[400]; // Fits the MQTT buffer set in setupAWS()
+  int length = snprintf(payload, sizeof(payload), "{\"idle\": %.3f, \"loop\": [%lu, %lu]", idle,
+                        (unsigned long)loopInterval.percentileUs(50), (unsigned long)loopInterval.percentileUs(99));
+  for (int stage = 0; stage < STAGE_COUNT && length < (int)sizeof(payload); stage++) {
+    LatencyHistogram interval = stageLatency[stage].since(stageLatencyPublished[stage]);
+    length += snprintf(payload + length, sizeof(payload) - length, ", \"%s\": [%lu, %lu]", loopStageNames[stage],
+                       (unsigned long)interval.percentileUs(50), (unsigned long)interval.percentileUs(99));
+    stageLatencyPublished[stage] = stageLatency[stage];
+  }
+  if (length < (int)sizeof(payload) - 1) {
+    strcat(payload, "}");
+    mqttClient.publish(metricsTopic, payload);
+  }
+  loopLatencyPublished = loopLatency;
+  loopTotalUsPublished = loopTotalUs;
+  loopIdleUsPublished = loopIdleUs;
+}
+
+// Function to publish the link-quality summary of the last period, called from loop().
+// It is streamed with QoS0 because it is longer than the MQTT buffer; a lost summary is replaced by the next one.
+void publishLinkSummary() {
+  if (LINK_PUBLISH_INTERVAL_MS == 0 || connection.state != CONN_READY ||
+      millis() - lastLinkPublish < LINK_PUBLISH_INTERVAL_MS) {
+    return;
+  }
+  char payload[640];
+  size_t length = linkMonitor.writeSummary(payload, sizeof(payload), millis() - lastLinkPublish);
+  lastLinkPublish = millis();
+  linkMonitor.resetPeriod();
+  if (length > 0 && mqttClient.beginPublish(linkTopic, length, false)) {
+    mqttClient.write((const uint8_t*)payload, length);
+    mqttClient.endPublish();
+  }
+}
+
+// Function to open an event stream for a page, or answer 503 if too many are open
+void handleEvents() {
+  // Bring the page up to date, afterwards it only receives changes
+  String lines;
+  consoleLog.appendTo(lines, 0, consolePushed); // Later lines follow with the next push
+  events.open(server, events.format("status", statusText()) + events.format("console", lines));
+}
+
+// Function to push state changes and new console lines to the open pages, called from loop().
+// Nothing is sent while nothing changes, however many pages are open.
+void pushEvents() {
+  if (relayStates != relayStatesPushed) {
+    relayStatesPushed = relayStates;
+    events.broadcast("status", statusText());
+  }
+  if (consoleLog.next() != consolePushed) {
+    String lines;
+    consoleLog.appendTo(lines, consolePushed, consoleLog.next());
+    events.broadcast("console", lines);
+    consolePushed = consoleLog.next();
+  }
+  events.service(millis()); // Keepalive comment on idle streams
+}
+
+// Function to wrap a route handler so its time is recorded in routeLatency
+ESP8266WebServer::THandlerFunction timedRoute(WebRoute route, void (*handler)()) {
+  return [route, handler]() {
+    unsigned long start = micros();
+    handler();
+    routeLatency[route].record(micros() - start);
+  };
+}
+
+// Function to record the time of a loop() stage that started at start, returns the time it ended
+unsigned long endStage(LoopStage stage, unsigned long start) {
+  unsigned long now = micros();
+  stageLatency[stage].record(now - start);
+  return now;
 }
 
 // Setup function
 void setup() {
   Serial.begin(115200);
   
-  pinMode(relay1Pin, OUTPUT);
-  pinMode(relay2Pin, OUTPUT);
-  
-  digitalWrite(relay1Pin, HIGH); // Initialize relay 1 as off
-  digitalWrite(relay2Pin, HIGH); // Initialize relay 2 as off
+  for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+    pinMode(relays[i].pin, OUTPUT);
+    digitalWrite(relays[i].pin, !relays[i].activeLevel); // Initialize every relay as off
+  }
   
   setupWiFi();
-  Blynk.begin(auth, ssid, pass);
-  Serial.println("Connected to Blynk");
-
-  connectAWS();
-
-  server.on("/", handleRoot);
-  server.on("/relay1/on", handleRelay1On);
-  server.on("/relay1/off", handleRelay1Off);
-  server.on("/relay2/on", handleRelay2On);
-  server.on("/relay2/off", handleRelay2Off);
-  server.on("/status", handleStatus);
-  server.on("/console", handleConsole);
+  Blynk.config(auth); // Blynk.begin() would block until WiFi and Blynk are connected
+
+  loadCertificates(); // Parse the certificates once, they are reused by every reconnect
+  setupAWS();
+  if (!linkMonitor.begin()) {
+    Serial.println("ICMP probes unavailable, no link statistics");
+  }
+
+  server.on("/", timedRoute(ROUTE_ROOT, handleRoot));
+  server.on("/status", timedRoute(ROUTE_STATUS, handleStatus));
+  server.on("/console", timedRoute(ROUTE_CONSOLE, handleConsole));
+  server.on("/connection", timedRoute(ROUTE_CONNECTION, handleConnection));
+  server.on("/outbox", timedRoute(ROUTE_OUTBOX, handleOutbox));
+  server.on("/publications", timedRoute(ROUTE_PUBLICATIONS, handlePublications));
+  server.on("/events", timedRoute(ROUTE_EVENTS, handleEvents));
+  server.on("/metrics", timedRoute(ROUTE_METRICS, handleMetrics));
+  server.on("/dns", timedRoute(ROUTE_DNS, handleDns));
+  server.on(UriBraces("/{}/on"), timedRoute(ROUTE_RELAY_ON, handleRelayOn)); // After the fixed routes, {} is the relay name
+  server.on(UriBraces("/{}/off"), timedRoute(ROUTE_RELAY_OFF, handleRelayOff));
+  server.collectHeaders(cacheHeaders, 1); // Keep If-None-Match so handleRoot() can answer 304
   server.begin();
 }
 
 // Main loop function
 void loop() {
+  unsigned long loopStart = micros();
+  unsigned long stageStart = loopStart;
+  connection.service(); // Advance or maintain the connection to AWS IoT
+  dnsCache.service(millis(), WiFi.status() == WL_CONNECTED); // Query the names that have expired, without waiting
+  stageStart = endStage(STAGE_CONNECTION, stageStart);
   Blynk.run();
+  stageStart = endStage(STAGE_BLYNK, stageStart);
   mqttClient.loop();
+  stageStart = endStage(STAGE_MQTT, stageStart);
+  publishRelayChanges(); // Queue the relay updates that are due
+  stageStart = endStage(STAGE_RELAYS, stageStart);
+  if (connection.state == CONN_READY) {
+    wifiClient.service(); // Publish queued status messages
+  }
+  stageStart = endStage(STAGE_OUTBOX, stageStart);
   server.handleClient();
+  stageStart = endStage(STAGE_WEB, stageStart);
+  pushEvents(); // Push changes to the open pages
+  stageStart = endStage(STAGE_EVENTS, stageStart);
+  linkMonitor.service(millis(), WiFi.RSSI(), WiFi.status() == WL_CONNECTED); // Send due link probes, expire old ones
+  endStage(STAGE_LINK, stageStart);
+  publishMetrics(); // Latency summary over MQTT every METRICS_PUBLISH_INTERVAL_MS
+  publishLinkSummary(); // Link-quality summary over MQTT every LINK_PUBLISH_INTERVAL_MS
+
+  unsigned long loopUs = micros() - loopStart;
+  loopLatency.record(loopUs);
+  loopTotalUs += loopUs;
+  if (loopUs < LOOP_IDLE_US) {
+    loopIdleUs += loopUs;
+  }
 }
 
-// Blynk function to control relay 1
-BLYNK_WRITE(V1) {
-  int pinValue = param.asInt(); // Get the value from the Blynk app
-
-  // Turn relay 1 on or off based on the value from the Blynk app
-  if (pinValue == 1) {
-    digitalWrite(relay1Pin, LOW); // Turn relay 1 on
-    relay1State = true;
-    Serial.println("Relay 1 turned ON via Blynk");
-    publishRelayStatus("relay1", "ON");
-  } else {
-    digitalWrite(relay1Pin, HIGH); // Turn relay 1 off
-    relay1State = false;
-    Serial.println("Relay 1 turned OFF via Blynk");
-    publishRelayStatus("relay1", "OFF");
+// Blynk function for every virtual pin without a BLYNK_WRITE of its own, finds the relay by virtual pin
+BLYNK_WRITE_DEFAULT() {
+  for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+    if (relays[i].virtualPin == request.pin) {
+      setRelay(i, param.asInt() == 1, FROM_BLYNK);
+      return;
+    }
   }
 }
 
-// Blynk function to control relay 2
-BLYNK_WRITE(V2) {
-  int pinValue = param.asInt(); // Get the value from the Blynk app
-
-  // Turn relay 2 on or off based on the value from the Blynk app
-  if (pinValue == 1) {
-    digitalWrite(relay2Pin, LOW); // Turn relay 2 on
-    relay2State = true;
-    Serial.println("Relay 2 turned ON via Blynk");
-    publishRelayStatus("relay2", "ON");
-  } else {
-    digitalWrite(relay2Pin, HIGH); // Turn relay 2 off
-    relay2State = false;
-    Serial.println("Relay 2 turned OFF via Blynk");
-    publishRelayStatus("relay2", "OFF");
-  }
+// Blynk function called on every connect to the Blynk server, publishRelayChanges() then writes every relay
+BLYNK_CONNECTED() {
+  blynkResync = true;
 }
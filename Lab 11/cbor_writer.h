@@ -0,0 +1,76 @@
+// cbor_writer.h
+#ifndef CBOR_WRITER_H
+#define CBOR_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Minimal CBOR (RFC 8949) encoder writing into a caller-supplied buffer.
+// Only the types used by the telemetry payload are supported: unsigned and negative
+// integers, text strings, arrays, maps and null. Nothing is allocated; if the buffer
+// is too small the writer stops and length() returns 0.
+class CborWriter {
+public:
+  CborWriter(uint8_t* buffer, size_t size) : buffer(buffer), size(size) {}
+
+  void writeMap(size_t pairs) { writeHead(5, pairs); }
+  void writeArray(size_t items) { writeHead(4, items); }
+  void writeUInt(uint32_t value) { writeHead(0, value); }
+  void writeNull() { writeByte(0xf6); }
+
+  void writeInt(int32_t value) {
+    if (value >= 0) {
+      writeHead(0, (uint32_t)value);
+    } else {
+      writeHead(1, (uint32_t)(-1 - value)); // CBOR stores negative n as -1 - n
+    }
+  }
+
+  void writeText(const char* text) {
+    size_t n = strlen(text);
+    writeHead(3, n);
+    for (size_t i = 0; i < n; i++) {
+      writeByte((uint8_t)text[i]);
+    }
+  }
+
+  size_t length() const { return overflow ? 0 : pos; } // Encoded size, 0 if it did not fit
+
+private:
+  uint8_t* buffer;
+  size_t size;
+  size_t pos = 0;
+  bool overflow = false;
+
+  void writeByte(uint8_t b) {
+    if (pos < size) {
+      buffer[pos++] = b;
+    } else {
+      overflow = true;
+    }
+  }
+
+  // Major type in the top 3 bits, argument in the shortest form that holds it
+  void writeHead(uint8_t major, uint32_t value) {
+    major <<= 5;
+    if (value < 24) {
+      writeByte(major | value);
+    } else if (value <= 0xff) {
+      writeByte(major | 24);
+      writeByte(value);
+    } else if (value <= 0xffff) {
+      writeByte(major | 25);
+      writeByte(value >> 8);
+      writeByte(value);
+    } else {
+      writeByte(major | 26);
+      writeByte(value >> 24);
+      writeByte(value >> 16);
+      writeByte(value >> 8);
+      writeByte(value);
+    }
+  }
+};
+
+#endif // CBOR_WRITER_H
@@ -0,0 +1,75 @@
+// deadband.h
+#ifndef DEADBAND_H
+#define DEADBAND_H
+
+#include <math.h>
+#include <stdint.h>
+
+// How the change threshold of a metric is interpreted
+enum DeadbandMode {
+  DEADBAND_ABSOLUTE, // Report when |value - last reported| >= threshold
+  DEADBAND_PERCENT // Report when |value - last reported| >= threshold % of the last reported value
+};
+
+// Per-metric report-by-exception settings
+struct DeadbandConfig {
+  DeadbandMode mode;
+  float threshold;
+  unsigned long maxSilenceMs; // Heartbeat: report anyway after this long without a report
+};
+
+// Decides whether a new reading of one metric is worth publishing.
+// Keeps only the last reported value and two counters, so it costs a few bytes per metric.
+//
+// Deciding and reporting are separate steps: a value that is due() only becomes the reference
+// once accept() is called, after its sample has been buffered. If a reported value is lost
+// later on, invalidate() makes the next reading due whatever its value, so the cloud side is
+// never left with a value the filter no longer compares against.
+class DeadbandFilter {
+public:
+  // Returns true if the value should be reported, counts it as suppressed otherwise
+  bool due(const DeadbandConfig& config, float value, unsigned long nowMs) {
+    if (!hasReported || nowMs - lastReportMs >= config.maxSilenceMs || changed(config, value)) {
+      return true;
+    }
+    suppressedCount++;
+    return false;
+  }
+
+  // Make a value that was due the new reference, once it is on its way
+  void accept(float value, unsigned long nowMs) {
+    lastValue = value;
+    lastReportMs = nowMs;
+    hasReported = true;
+    sentCount++;
+  }
+
+  // Forget the reference, the value it was taken from will never be delivered
+  void invalidate() { hasReported = false; }
+
+  uint32_t sent() const { return sentCount; }
+  uint32_t suppressed() const { return suppressedCount; }
+
+private:
+  float lastValue = 0;
+  unsigned long lastReportMs = 0;
+  bool hasReported = false;
+  uint32_t sentCount = 0;
+  uint32_t suppressedCount = 0;
+
+  bool changed(const DeadbandConfig& config, float value) const {
+    if (isnan(value) || isnan(lastValue)) {
+      return isnan(value) != isnan(lastValue); // Report a sensor failing or recovering once
+    }
+    float delta = fabsf(value - lastValue);
+    if (delta == 0) {
+      return false; // Unchanged, so a zero threshold means "report any change"
+    }
+    if (config.mode == DEADBAND_PERCENT) {
+      return delta >= fabsf(lastValue) * config.threshold / 100.0f;
+    }
+    return delta >= config.threshold;
+  }
+};
+
+#endif // DEADBAND_H
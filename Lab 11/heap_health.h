@@ -0,0 +1,106 @@
+// heap_health.h
+// Does not depend on any Arduino header, so it can be checked on the host.
+#ifndef HEAP_HEALTH_H
+#define HEAP_HEALTH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Heap calls counted by the allocator hook in main.cpp since boot. Only the count and the
+// requested bytes are kept, the hook never walks the heap.
+struct AllocCounters {
+  uint32_t calls;
+  uint32_t bytes;
+};
+
+// Runtime health of the heap and the loop stack, sampled from loop() and reported as one message.
+//
+// The heap figures are kept as the worst value seen since the last report, so a dip between two
+// reports is not missed. Allocations are counted per loop() pass: a pass that did none of the
+// scheduled work (no sample, publish or reconnect) and still allocated is a steady-state
+// allocation in the hot path, which slowly fragments the heap on a board that runs for months.
+class HeapHealth {
+public:
+  // Fold in one reading of the heap and of the lowest free cont stack since boot
+  void sampleHeap(uint32_t freeHeap, uint32_t maxFreeBlock, uint8_t fragmentationPercent, uint32_t freeStack) {
+    lastFreeHeap = freeHeap;
+    if (heapSamples == 0 || freeHeap < minFreeHeap) {
+      minFreeHeap = freeHeap;
+    }
+    if (heapSamples == 0 || maxFreeBlock < minMaxBlock) {
+      minMaxBlock = maxFreeBlock;
+    }
+    if (fragmentationPercent > maxFragmentation) {
+      maxFragmentation = fragmentationPercent;
+    }
+    stackFree = freeStack;
+    heapSamples++;
+  }
+
+  // Start a loop() pass from the current allocator counters
+  void beginLoop(const AllocCounters& now) { passStart = now; }
+
+  // End a loop() pass, idle is true when the pass did none of the scheduled work.
+  // Returns true the first time an idle pass allocates, so the caller can log it once.
+  bool endLoop(const AllocCounters& now, bool idle) {
+    uint32_t calls = now.calls - passStart.calls;
+    uint32_t bytes = now.bytes - passStart.bytes;
+    loops++;
+    allocCalls += calls;
+    allocBytes += bytes;
+    if (calls > maxLoopCalls) {
+      maxLoopCalls = calls;
+    }
+    if (!idle || calls == 0) {
+      return false;
+    }
+    idleAllocLoops++;
+    idleAllocBytes += bytes;
+    bool first = !hotPathFlagged;
+    hotPathFlagged = true;
+    return first;
+  }
+
+  // Start a new report period. The stack figure is a high-water mark and is kept.
+  void resetPeriod() {
+    heapSamples = 0;
+    maxFragmentation = 0;
+    loops = 0;
+    allocCalls = 0;
+    allocBytes = 0;
+    maxLoopCalls = 0;
+    idleAllocLoops = 0;
+    idleAllocBytes = 0;
+  }
+
+  uint32_t freeHeap() const { return lastFreeHeap; }
+  uint32_t minHeap() const { return minFreeHeap; }
+  uint32_t minBlock() const { return minMaxBlock; }
+  uint8_t maxFragmentationPercent() const { return maxFragmentation; }
+  uint32_t freeStack() const { return stackFree; }
+  uint32_t loopCount() const { return loops; }
+  uint32_t allocCount() const { return allocCalls; }
+  uint32_t allocByteCount() const { return allocBytes; }
+  uint32_t maxAllocsPerLoop() const { return maxLoopCalls; }
+  uint32_t hotPathAllocLoops() const { return idleAllocLoops; }
+  uint32_t hotPathAllocBytes() const { return idleAllocBytes; }
+
+private:
+  uint32_t lastFreeHeap = 0;
+  uint32_t minFreeHeap = 0;
+  uint32_t minMaxBlock = 0;
+  uint8_t maxFragmentation = 0;
+  uint32_t stackFree = 0;
+  uint32_t heapSamples = 0;
+
+  AllocCounters passStart = {};
+  uint32_t loops = 0;
+  uint32_t allocCalls = 0;
+  uint32_t allocBytes = 0;
+  uint32_t maxLoopCalls = 0;
+  uint32_t idleAllocLoops = 0;
+  uint32_t idleAllocBytes = 0;
+  bool hotPathFlagged = false;
+};
+
+#endif // HEAP_HEALTH_H
@@ -3,6 +3,148 @@
 #include <PubSubClient.h> // Include library for MQTT communication
 #include <ArduinoJson.h> // Include library for JSON handling
 #include <DHT.h> // Include library for DHT sensor
+#include "credentials.h" // WiFi credentials, AWS IoT endpoint and certificates
+#include "tls_session.h" // TLS session resumption, with the handshake time of every connect
+#include "aws_certs.h" // Device certificate, key and root CA, parsed once at startup
+#if __has_include("aws_certs_der.h")
+#include "aws_certs_der.h" // Certificates precompiled to DER by Tools/cert-compiler
+#endif
+#include "telemetry_schema.h" // Field names and CBOR keys shared with the cloud-side decoder
+#include "telemetry_encoder.h" // JSON and CBOR payloads, shared with Tools/payload-bench
+#include "deadband.h" // Report-by-exception filter for each metric
+#include "window_stats.h" // Fixed-point streaming min/max/mean/variance
+#include "backoff.h" // Exponential backoff with jitter for reconnects
+#include "sample_buffer.h" // Ring buffer holding samples until they are published
+#include "telemetry_log.h" // Flash log keeping samples taken while AWS IoT is unreachable
+#include "heap_health.h" // Heap, fragmentation, stack and per-loop allocation tracking
+#include "link_monitor.h" // Background ICMP probes with round-trip, jitter, loss and RSSI statistics
+#include "dns_cache.h" // Background refresh of the broker and NTP names, with hit rates and resolve times
+
+// Sampling and batching parameters (can be overridden with -D build flags)
+// With the defaults one sample is taken and published every minute. Set BATCH_MAX_SAMPLES
+// above 1 to sample faster and publish several samples together in one MQTT message.
+#ifndef SAMPLE_INTERVAL_MS
+#define SAMPLE_INTERVAL_MS 60000 // How often the sensors are sampled
+#endif
+#ifndef BATCH_MAX_SAMPLES
+#define BATCH_MAX_SAMPLES 1 // Publish as soon as this many samples are buffered
+#endif
+#ifndef BATCH_MAX_AGE_MS
+#define BATCH_MAX_AGE_MS 60000 // Publish when the oldest buffered sample is this old
+#endif
+#ifndef SAMPLE_BUFFER_CAPACITY
+#define SAMPLE_BUFFER_CAPACITY 64 // Samples kept in RAM while waiting to be published
+#endif
+
+// Payload encoding, PAYLOAD_FORMAT_JSON or PAYLOAD_FORMAT_CBOR (see telemetry_schema.h)
+#ifndef PAYLOAD_FORMAT
+#define PAYLOAD_FORMAT PAYLOAD_FORMAT_JSON
+#endif
+
+// Report-by-exception parameters
+// When enabled, a field is only published if it moved past its deadband (see deadbandConfig
+// below) or has been silent for its heartbeat period. Samples where nothing changed are not
+// published at all, and batches switch to sparse rows carrying a bit mask of present fields.
+#ifndef DEADBAND_ENABLED
+#define DEADBAND_ENABLED 0
+#endif
+#ifndef DEADBAND_REPORT_INTERVAL_MS
+#define DEADBAND_REPORT_INTERVAL_MS 600000 // How often the sent/suppressed counters are published
+#endif
+
+// Windowed statistics parameters
+// When enabled, the sensors are sampled every STATS_SAMPLE_INTERVAL_MS and one message with the
+// count, min, max, mean and standard deviation of each metric is published per window, instead
+// of the instantaneous samples above. Windows closed while AWS IoT is unreachable are kept in RAM
+// and published once it is back.
+#ifndef WINDOW_STATS_ENABLED
+#define WINDOW_STATS_ENABLED 0
+#endif
+#ifndef STATS_SAMPLE_INTERVAL_MS
+#define STATS_SAMPLE_INTERVAL_MS 1000 // Sample at 1 Hz
+#endif
+#ifndef STATS_WINDOW_MS
+#define STATS_WINDOW_MS 60000 // Length of one aggregation window
+#endif
+// A window gets one more sample than the ratio when the first sample lands on its opening edge
+static_assert(STATS_WINDOW_MS / STATS_SAMPLE_INTERVAL_MS + 1 <= WindowStats::MAX_SAMPLES,
+              "a window must hold at most WindowStats::MAX_SAMPLES samples to stay exact");
+#ifndef WINDOW_BUFFER_CAPACITY
+#define WINDOW_BUFFER_CAPACITY 16 // Closed windows kept while AWS IoT is unreachable, the oldest is overwritten
+#endif
+
+// Store-and-forward parameters
+// While AWS IoT is unreachable, ready batches are appended to a log on LittleFS instead of
+// being published. After reconnecting the backlog is replayed at a limited rate so live
+// samples keep going out on time.
+#ifndef RECONNECT_BASE_MS
+#define RECONNECT_BASE_MS 1000 // Longest wait before the first connection attempt of an outage
+#endif
+#ifndef RECONNECT_CAP_MS
+#define RECONNECT_CAP_MS 60000 // The wait doubles after every failure up to this cap
+#endif
+#ifndef REPLAY_INTERVAL_MS
+#define REPLAY_INTERVAL_MS 2000 // Minimum time between two backlog messages
+#endif
+#ifndef REPLAY_BATCH_SAMPLES
+#define REPLAY_BATCH_SAMPLES 16 // Samples per backlog message
+#endif
+
+// Health telemetry parameters
+// Free heap, largest free block, fragmentation and the lowest free loop stack are sampled in
+// loop() and published on the health topic, with the worst values of each period. Building with
+// HEAP_HOOK_ENABLED=1 and the --wrap linker flags of platformio.ini also counts every malloc,
+// calloc and realloc per loop() pass, and flags allocations in passes that had nothing to do.
+#ifndef HEALTH_SAMPLE_INTERVAL_MS
+#define HEALTH_SAMPLE_INTERVAL_MS 1000 // Each sample walks the heap, keep it well above a millisecond
+#endif
+#ifndef HEALTH_REPORT_INTERVAL_MS
+#define HEALTH_REPORT_INTERVAL_MS 300000 // How often the health message is published, 0 turns it off
+#endif
+#ifndef HEAP_HOOK_ENABLED
+#define HEAP_HOOK_ENABLED 0
+#endif
+
+// Link-quality parameters
+// The gateway and a public host are pinged in the background, without waiting for the replies.
+// A summary with round trip, jitter and loss per target, set against the RSSI, is published on
+// the link topic every LINK_REPORT_INTERVAL_MS (0 turns it off).
+#ifndef LINK_PROBE_INTERVAL_MS
+#define LINK_PROBE_INTERVAL_MS 5000 // Each target is probed this often
+#endif
+#ifndef LINK_PROBE_TIMEOUT_MS
+#define LINK_PROBE_TIMEOUT_MS 1000 // A probe without a reply after this long is lost
+#endif
+#ifndef LINK_REPORT_INTERVAL_MS
+#define LINK_REPORT_INTERVAL_MS 300000 // How often the link summary is published
+#endif
+
+// DNS cache parameters
+// The AWS endpoint and the NTP servers are looked up again in the background when their cached
+// answer expires, so a reconnect does not wait for a query. Hits, misses and resolve times of
+// each name are published on the DNS topic every DNS_REPORT_INTERVAL_MS (0 turns it off).
+#ifndef DNS_CHECK_INTERVAL_MS
+#define DNS_CHECK_INTERVAL_MS 1000 // Each name is checked this often, an expired one is queried again
+#endif
+#ifndef DNS_REPORT_INTERVAL_MS
+#define DNS_REPORT_INTERVAL_MS 300000 // How often the DNS summary is published
+#endif
+
+#if REPLAY_BATCH_SAMPLES > BATCH_MAX_SAMPLES
+#define PUBLISH_MAX_SAMPLES REPLAY_BATCH_SAMPLES
+#else
+#define PUBLISH_MAX_SAMPLES BATCH_MAX_SAMPLES
+#endif
+
+#define DEVICE_ID "ESP8266-01" // Device identifier included in every payload
+#define ALL_FIELDS ((1 << FIELD_COUNT) - 1) // Field mask with every field present
+#define DEADBAND_STATS_TOPIC AWS_IOT_PUBLISH_TOPIC "/deadband" // Topic for the deadband counters
+#define HEALTH_TOPIC AWS_IOT_PUBLISH_TOPIC "/health" // Topic for the heap and stack health
+#define LINK_TOPIC AWS_IOT_PUBLISH_TOPIC "/link" // Topic for the link-quality summary
+#define DNS_TOPIC AWS_IOT_PUBLISH_TOPIC "/dns" // Topic for the DNS cache summary
+#define NTP_SERVER_1 "my.pool.ntp.org" // NTP servers, resolved through dnsCache like the endpoint
+#define NTP_SERVER_2 "time.nist.gov"
+#define PAYLOAD_BUFFER_SIZE (256 + PUBLISH_MAX_SAMPLES * 96) // Room for the header plus one row per sample
 
 // Define the DHT sensor pin and type
 #define DHTPIN 14 // GPIO14 (D5 on ESP8266)
@@ -11,7 +153,81 @@
 DHT dht(DHTPIN, DHTTYPE); // Initialize DHT sensor
 
 WiFiClientSecure net; // Secure WiFi client
+TlsSession tlsSession; // Kept between connections so reconnects can skip the full handshake
+AwsCertificates awsCertificates; // Parsed once and kept for as long as the TLS client uses them
 PubSubClient client(net); // MQTT client using the secure WiFi client
+Backoff awsBackoff(RECONNECT_BASE_MS, RECONNECT_CAP_MS); // Random reconnect delays, so a fleet does not retry in lockstep
+
+// Deadband and heartbeat of each metric, in SensorField order
+const DeadbandConfig deadbandConfig[FIELD_COUNT] = {
+  { DEADBAND_ABSOLUTE, 0.5, 600000 }, // Temperature: 0.5 C
+  { DEADBAND_ABSOLUTE, 2.0, 600000 }, // Humidity: 2 %
+  { DEADBAND_ABSOLUTE, 1.0, 600000 }, // Pressure: 1 hPa
+  { DEADBAND_PERCENT, 10.0, 600000 }, // AirQuality: 10 %
+  { DEADBAND_ABSOLUTE, 50.0, 600000 }, // CO2: 50 ppm
+  { DEADBAND_PERCENT, 10.0, 600000 }, // VOC: 10 %
+  { DEADBAND_PERCENT, 20.0, 600000 }, // Light: 20 %
+  { DEADBAND_ABSOLUTE, 3.0, 600000 } // Noise: 3 dB
+};
+DeadbandFilter deadband[FIELD_COUNT]; // Last reported value and counters of each metric
+WindowStats windowStats[FIELD_COUNT]; // Aggregates of the current window for each metric
+uint32_t windowStartTime = 0; // Seconds since the Epoch of the first sample in the window
+SampleBuffer<WindowSummary, WINDOW_BUFFER_CAPACITY> windowBuffer; // Closed windows waiting to be published
+
+SampleBuffer<SensorSample, SAMPLE_BUFFER_CAPACITY> sampleBuffer; // Samples waiting to be published
+TelemetryLog<SensorSample> telemetryLog; // Samples taken while offline, waiting to be replayed
+SensorSample outgoing[PUBLISH_MAX_SAMPLES]; // Samples of the message being published
+char payloadBuffer[PAYLOAD_BUFFER_SIZE]; // Serialized payload, kept off the small loop stack
+TelemetryEncoder encoder(DEVICE_ID, DEADBAND_ENABLED); // Sparse batch rows while the deadbands drop fields
+
+const LinkTarget linkTargets[] = {
+  { "gateway", nullptr }, // The access point's router, shows the quality of the Wi-Fi hop alone
+  { "internet", "1.1.1.1" }, // A public resolver that answers pings
+};
+LinkMonitor<sizeof(linkTargets) / sizeof(linkTargets[0])> linkMonitor(linkTargets, LINK_PROBE_INTERVAL_MS, LINK_PROBE_TIMEOUT_MS);
+
+const DnsName dnsNames[] = {
+  { "aws", AWS_ENDPOINT },
+  { "ntp1", NTP_SERVER_1 },
+  { "ntp2", NTP_SERVER_2 },
+};
+const size_t DNS_AWS = 0; // Index of AWS_ENDPOINT in dnsNames
+DnsCache<sizeof(dnsNames) / sizeof(dnsNames[0])> dnsCache(dnsNames, DNS_CHECK_INTERVAL_MS);
+IPAddress awsAddress; // Last resolved address of the AWS IoT endpoint
+
+HeapHealth heapHealth; // Heap and stack figures of the current report period
+AllocCounters allocCounters = {}; // Heap calls since boot, counted by the allocator hook
+
+#if HEAP_HOOK_ENABLED
+// Allocator hook. The linker sends every malloc, calloc and realloc call of the sketch, the core
+// and the libraries here first (-Wl,--wrap=malloc ...), and __real_* is the allocator itself.
+// The SDK allocates through its own entry points and is not counted. In IRAM like the allocator.
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+IRAM_ATTR void* __wrap_malloc(size_t size) {
+  allocCounters.calls++;
+  allocCounters.bytes += size;
+  return __real_malloc(size);
+}
+
+IRAM_ATTR void* __wrap_calloc(size_t count, size_t size) {
+  allocCounters.calls++;
+  allocCounters.bytes += count * size;
+  return __real_calloc(count, size);
+}
+
+IRAM_ATTR void* __wrap_realloc(void* ptr, size_t size) {
+  if (size > 0) { // realloc(ptr, 0) only frees
+    allocCounters.calls++;
+    allocCounters.bytes += size;
+  }
+  return __real_realloc(ptr, size);
+}
+}
+#endif
 
 // Function to generate dummy temperature data
 float generateDummyTemperature() {
@@ -56,7 +272,7 @@ float generateDummyNoise() {
 // Function to synchronize time using NTP
 void NTPConnect() {
   Serial.print("Setting time using SNTP");
-  configTime(8 * 3600, 0, "my.pool.ntp.org", "time.nist.gov"); // UTC+8 timezone
+  configTime(8 * 3600, 0, NTP_SERVER_1, NTP_SERVER_2); // UTC+8 timezone
   time_t now = time(nullptr);
   while (now < 8 * 3600) {
     delay(500);
@@ -83,55 +299,343 @@ void connectToWiFi() {
   Serial.println(WiFi.localIP());
 }
 
-// Function to connect to AWS IoT
-void connectToAWS() {
-  // Set up certificates and keys
-  BearSSL::X509List cert(awsCert); // Replace with your AWS certificate
-  BearSSL::PrivateKey key(awsPrivateKey); // Replace with your AWS private key
-  BearSSL::X509List ca(awsRootCA); // Replace with your AWS root CA
+// Function to parse the certificates and key once at startup.
+// The TLS client only keeps pointers to them, so they must outlive every connection.
+void loadCertificates() {
+#ifdef AWS_CERTS_DER_H
+  // DER from aws_certs_der.h, no base64 decoding
+  awsCertificates.loadDer(awsCertDer, sizeof(awsCertDer), awsPrivateKeyDer, sizeof(awsPrivateKeyDer),
+                          awsRootCADer, sizeof(awsRootCADer));
+#else
+  awsCertificates.loadPem(awsCert, awsPrivateKey, awsRootCA);
+#endif
+  awsCertificates.attach(net);
+}
+
+// Function to connect the MQTT client and log whether the TLS session was resumed
+bool connectMQTT() {
+  bool connected = tlsSession.connect([]() { return client.connect("ESP8266Client"); }); // The TLS handshake happens in here
+  if (connected) {
+    Serial.println(tlsSession.summary());
+  }
+  return connected;
+}
 
-  net.setClientRSACert(&cert, &key); // Set RSA certificate and private key
-  net.setTrustAnchors(&ca); // Set trust anchors
+// Function to connect to AWS IoT
+bool connectToAWS() {
+  tlsSession.attach(net); // Offer the previous session, BearSSL falls back to a full handshake if refused
 
   client.setServer(AWS_ENDPOINT, 8883); // Replace with your AWS endpoint
 
+  // Try once and let loop() retry, so sampling keeps running while AWS IoT is unreachable
   Serial.println("Connecting to AWS IoT...");
-  while (!client.connect("ESP8266Client")) {
+  if (!connectMQTT()) {
     Serial.print("MQTT state: ");
     Serial.println(client.state());
-    delay(1000);
+    return false;
   }
 
-  if (!client.connected()) {
-    Serial.println("AWS IoT Timeout!");
-    return;
+  Serial.println("AWS IoT Connected!");
+  awsBackoff.reset(); // The next outage starts again from the shortest delay
+  return true;
+}
+
+// Function to read all sensors into a sample
+SensorSample takeSample() {
+  SensorSample sample;
+  sample.timestamp = time(nullptr); // Get the current time in seconds since the Epoch
+  sample.takenAtMs = millis();
+  sample.values[FIELD_TEMPERATURE] = dht.readTemperature();
+  sample.values[FIELD_HUMIDITY] = dht.readHumidity();
+  sample.values[FIELD_PRESSURE] = generateDummyPressure();
+  sample.values[FIELD_AIR_QUALITY] = generateDummyAirQuality();
+  sample.values[FIELD_CO2] = generateDummyCO2();
+  sample.values[FIELD_VOC] = generateDummyVOC();
+  sample.values[FIELD_LIGHT] = generateDummyLight();
+  sample.values[FIELD_NOISE] = generateDummyNoise();
+  sample.fieldMask = ALL_FIELDS;
+  return sample;
+}
+
+// Function to clear the fields of a sample that did not change enough to be reported.
+// The references stay where they are until acceptDeadband() is called for the buffered sample.
+void applyDeadband(SensorSample& sample) {
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    if (!deadband[i].due(deadbandConfig[i], sample.values[i], sample.takenAtMs)) {
+      sample.fieldMask &= ~(1 << i);
+    }
   }
+}
 
-  Serial.println("AWS IoT Connected!");
+// Function to make the fields of a buffered sample the new deadband references
+void acceptDeadband(const SensorSample& sample) {
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    if (sample.fieldMask & (1 << i)) {
+      deadband[i].accept(sample.values[i], sample.takenAtMs);
+    }
+  }
 }
 
-// Function to publish message to AWS IoT
-void publishMessage() {
+// Function to report the given fields again with the next sample, after samples carrying them were lost
+void invalidateDeadband(uint16_t fieldMask) {
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    if (fieldMask & (1 << i)) {
+      deadband[i].invalidate();
+    }
+  }
+}
+
+// Function to publish how many values each deadband sent and suppressed
+void publishDeadbandStats() {
   StaticJsonDocument<512> doc;
-  doc["device_id"] = "ESP8266-01";
-  doc["Temperature"] = dht.readTemperature();
-  doc["Humidity"] = dht.readHumidity();
-  doc["Pressure"] = generateDummyPressure();
-  doc["AirQuality"] = generateDummyAirQuality();
-  doc["CO2"] = generateDummyCO2();
-  doc["VOC"] = generateDummyVOC();
-  doc["Light"] = generateDummyLight();
-  doc["Noise"] = generateDummyNoise();
-  doc["timestamp"] = time(nullptr); // Get the current time in seconds since the Epoch
-
-  char jsonBuffer[512];
-  serializeJson(doc, jsonBuffer);
-
-  if (client.publish(AWS_IOT_PUBLISH_TOPIC, jsonBuffer)) {
-    Serial.print("Message published: ");
-    Serial.println(jsonBuffer);
+  doc["device_id"] = DEVICE_ID;
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    JsonObject counters = doc.createNestedObject(fieldInfo[i].name);
+    counters["sent"] = deadband[i].sent();
+    counters["suppressed"] = deadband[i].suppressed();
+  }
+
+  size_t len = serializeJson(doc, payloadBuffer, sizeof(payloadBuffer));
+  if (client.publish(DEADBAND_STATS_TOPIC, (const uint8_t*)payloadBuffer, len)) {
+    Serial.print("Deadband counters published: ");
+    Serial.println(payloadBuffer);
+  }
+}
+
+// Function to read the heap and the lowest free loop stack into the health figures
+void sampleHealth() {
+  heapHealth.sampleHeap(ESP.getFreeHeap(), ESP.getMaxFreeBlockSize(), ESP.getHeapFragmentation(),
+                        ESP.getFreeContStack());
+}
+
+// Function to publish the health figures of the last period and start a new one
+void publishHealth() {
+  StaticJsonDocument<JSON_OBJECT_SIZE(14)> doc;
+  doc["device_id"] = DEVICE_ID;
+  doc["uptime_s"] = millis() / 1000;
+  doc["free_heap"] = heapHealth.freeHeap();
+  doc["min_free_heap"] = heapHealth.minHeap(); // Lowest free heap of the period
+  doc["min_max_block"] = heapHealth.minBlock(); // Smallest largest free block of the period
+  doc["max_frag_pct"] = heapHealth.maxFragmentationPercent();
+  doc["min_free_stack"] = heapHealth.freeStack(); // Stack high-water mark since boot
+  doc["loops"] = heapHealth.loopCount();
+#if HEAP_HOOK_ENABLED
+  doc["allocs"] = heapHealth.allocCount();
+  doc["alloc_bytes"] = heapHealth.allocByteCount();
+  doc["max_allocs_per_loop"] = heapHealth.maxAllocsPerLoop();
+  doc["idle_alloc_loops"] = heapHealth.hotPathAllocLoops(); // Passes with nothing to do that still allocated
+  doc["idle_alloc_bytes"] = heapHealth.hotPathAllocBytes();
+#endif
+
+  size_t len = serializeJson(doc, payloadBuffer, sizeof(payloadBuffer));
+  if (client.publish(HEALTH_TOPIC, (const uint8_t*)payloadBuffer, len)) {
+    Serial.print("Health published: ");
+    Serial.println(payloadBuffer);
+  }
+  heapHealth.resetPeriod();
+  sampleHealth(); // Start the new period from the current figures
+}
+
+// Function to publish the link-quality summary of the last period and start a new one
+void publishLinkSummary() {
+  size_t len = linkMonitor.writeSummary(payloadBuffer, sizeof(payloadBuffer), LINK_REPORT_INTERVAL_MS);
+  if (len > 0 && client.publish(LINK_TOPIC, (const uint8_t*)payloadBuffer, len)) {
+    Serial.print("Link summary published: ");
+    Serial.println(payloadBuffer);
+  }
+  linkMonitor.resetPeriod();
+}
+
+// Function to publish the DNS cache summary of the last period and start a new one
+void publishDnsSummary() {
+  size_t len = dnsCache.writeSummary(payloadBuffer, sizeof(payloadBuffer));
+  if (len > 0 && client.publish(DNS_TOPIC, (const uint8_t*)payloadBuffer, len)) {
+    Serial.print("DNS summary published: ");
+    Serial.println(payloadBuffer);
+  }
+  dnsCache.resetPeriod();
+}
+
+// Function to fold one reading of every sensor into the current window
+void addWindowSample() {
+  SensorSample sample = takeSample();
+  if (windowStartTime == 0) {
+    windowStartTime = sample.timestamp;
+  }
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    if (isnan(sample.values[i])) {
+      continue; // Skip failed sensor reads
+    }
+    int32_t value = toFixed(i, sample.values[i]);
+    if (value < -WindowStats::INPUT_LIMIT || value > WindowStats::INPUT_LIMIT) {
+      continue; // Out of the aggregator's exact range, a broken reading for every field of the schema
+    }
+    windowStats[i].add(value);
+  }
+}
+
+// Function to keep the aggregates of the current window until they are published and start a new one
+void closeWindow() {
+  WindowSummary window;
+  window.start = windowStartTime;
+  window.seconds = STATS_WINDOW_MS / 1000;
+  bool empty = true;
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    const WindowStats& stats = windowStats[i];
+    FieldSummary& field = window.fields[i];
+    field.n = stats.count();
+    field.min = stats.min();
+    field.max = stats.max();
+    field.meanQ = stats.meanQ();
+    field.stddevQ = stats.stddevQ();
+    empty = empty && field.n == 0;
+    windowStats[i].reset();
+  }
+  windowStartTime = 0;
+
+  if (!empty && !windowBuffer.push(window)) {
+    Serial.println("Window buffer full, oldest window dropped.");
+  }
+}
+
+// Function to publish the oldest closed window, it stays buffered if the publish fails
+bool publishWindowStats() {
+  const WindowSummary& window = windowBuffer.peek(0);
+  size_t len;
+#if PAYLOAD_FORMAT == PAYLOAD_FORMAT_CBOR
+  len = encoder.windowCbor(window, (uint8_t*)payloadBuffer, sizeof(payloadBuffer));
+#else
+  len = encoder.windowJson(window, payloadBuffer, sizeof(payloadBuffer));
+#endif
+
+  if (len == 0) {
+    Serial.println("Payload buffer too small, dropping window.");
+    windowBuffer.drop(1); // Retrying would fail the same way
+    return true;
+  }
+
+  if (!client.publish(AWS_IOT_PUBLISH_TOPIC, (const uint8_t*)payloadBuffer, len)) {
+    Serial.println("Window statistics publish failed.");
+    return false;
+  }
+
+  windowBuffer.drop(1);
+  Serial.print("Window statistics published (");
+  Serial.print(len);
+  Serial.print(" bytes, ");
+  Serial.print(windowBuffer.size());
+  Serial.println(" windows left)");
+#if PAYLOAD_FORMAT == PAYLOAD_FORMAT_JSON
+  Serial.println(payloadBuffer);
+#endif
+  return true;
+}
+
+// Function to check whether the buffered samples should be published
+bool batchReady(unsigned long now) {
+  if (sampleBuffer.empty()) {
+    return false;
+  }
+  if (sampleBuffer.size() >= BATCH_MAX_SAMPLES) {
+    return true;
+  }
+  return now - sampleBuffer.peek(0).takenAtMs >= BATCH_MAX_AGE_MS;
+}
+
+// Function to publish samples to AWS IoT as one message, tagged with its PayloadShape.
+// A board that batches sends every message as a batch, also a lone sample that BATCH_MAX_AGE_MS
+// sends on its own, so its messages keep one shape. Only a board that never batches sends a lone
+// sample in the sample shape.
+bool publishSamples(const SensorSample* samples, size_t count) {
+  unsigned long encodeStart = micros();
+  size_t len;
+  PayloadShape shape = BATCH_MAX_SAMPLES == 1 && count == 1 ? SHAPE_SAMPLE : encoder.batchShape();
+#if PAYLOAD_FORMAT == PAYLOAD_FORMAT_CBOR
+  if (shape == SHAPE_SAMPLE) {
+    len = encoder.sampleCbor(samples[0], (uint8_t*)payloadBuffer, sizeof(payloadBuffer));
+  } else {
+    len = encoder.batchCbor(samples, count, (uint8_t*)payloadBuffer, sizeof(payloadBuffer));
+  }
+#else
+  if (shape == SHAPE_SAMPLE) {
+    len = encoder.sampleJson(samples[0], payloadBuffer, sizeof(payloadBuffer));
   } else {
+    len = encoder.batchJson(samples, count, payloadBuffer, sizeof(payloadBuffer));
+  }
+#endif
+  unsigned long encodeTime = micros() - encodeStart;
+
+  if (len == 0) {
+    Serial.println("Payload buffer too small, dropping samples.");
+    if (DEADBAND_ENABLED) {
+      uint16_t lost = 0;
+      for (size_t i = 0; i < count; i++) {
+        lost |= samples[i].fieldMask;
+      }
+      invalidateDeadband(lost);
+    }
+    return true; // Retrying would fail the same way
+  }
+
+  if (!client.publish(AWS_IOT_PUBLISH_TOPIC, (const uint8_t*)payloadBuffer, len)) {
     Serial.println("Message publish failed.");
+    return false;
+  }
+
+  Serial.print("Message published (");
+  Serial.print(shapeNames[shape]);
+  Serial.print(", ");
+  Serial.print(count);
+  Serial.print(" samples, ");
+  Serial.print(len);
+  Serial.print(" bytes, ");
+  Serial.print(len / count);
+  Serial.print(" bytes/sample, encoded in ");
+  Serial.print(encodeTime);
+  Serial.println(" us)");
+#if PAYLOAD_FORMAT == PAYLOAD_FORMAT_JSON
+  Serial.println(payloadBuffer);
+#endif
+  return true;
+}
+
+// Function to publish the oldest buffered samples, or log them to flash while offline
+void publishMessage() {
+  size_t count = sampleBuffer.size() < BATCH_MAX_SAMPLES ? sampleBuffer.size() : BATCH_MAX_SAMPLES;
+  for (size_t i = 0; i < count; i++) {
+    outgoing[i] = sampleBuffer.peek(i);
+  }
+
+  if (client.connected() && publishSamples(outgoing, count)) {
+    sampleBuffer.drop(count); // Only forget the samples once they have been sent
+    return;
+  }
+
+  // Offline: move the batch to flash so it survives a long outage or a reboot
+  uint32_t droppedBefore = telemetryLog.dropped();
+  size_t stored = 0;
+  while (stored < count && telemetryLog.append(outgoing[stored])) {
+    stored++;
+  }
+  if (DEADBAND_ENABLED && telemetryLog.dropped() != droppedBefore) {
+    invalidateDeadband(ALL_FIELDS); // The log made room by deleting samples whose fields are not known
+  }
+  sampleBuffer.drop(stored); // Anything not stored stays in RAM and is retried later
+  if (stored > 0) {
+    Serial.print("Offline, ");
+    Serial.print(stored);
+    Serial.print(" samples logged to flash, backlog ");
+    Serial.println(telemetryLog.pending());
+  }
+}
+
+// Function to replay one message worth of samples logged while offline
+void replayBacklog() {
+  size_t count = telemetryLog.read(outgoing, REPLAY_BATCH_SAMPLES);
+  if (count > 0 && publishSamples(outgoing, count)) {
+    telemetryLog.consume(count); // Advance the read cursor only after a successful publish
+    Serial.print("Backlog remaining: ");
+    Serial.println(telemetryLog.pending());
   }
 }
 
@@ -139,23 +643,163 @@ void publishMessage() {
 void setup() {
   Serial.begin(115200); // Start serial communication at 115200 baud
   dht.begin(); // Initialize DHT sensor
+  if (telemetryLog.begin()) { // Mount LittleFS and recover any backlog from before a reboot
+    Serial.print("Telemetry backlog: ");
+    Serial.println(telemetryLog.pending());
+  } else {
+    Serial.println("LittleFS mount failed, offline samples will only be kept in RAM.");
+  }
+  client.setBufferSize(PAYLOAD_BUFFER_SIZE + 128); // Leave room for the MQTT header and topic
   connectToWiFi(); // Connect to WiFi
+  linkMonitor.setGateway(WiFi.gatewayIP());
+  if (!linkMonitor.begin()) { // Probe the link in the background from loop()
+    Serial.println("ICMP probes unavailable, no link statistics");
+  }
   NTPConnect(); // Synchronize time using NTP
+  loadCertificates(); // Parse the certificates once, they are reused by every reconnect
   connectToAWS(); // Connect to AWS IoT
 }
 
 // Main loop function
 void loop() {
+  static unsigned long lastConnectAttempt = 0;
+  static unsigned long reconnectDelay = 0;
+  static bool wasConnected = false;
+  static unsigned long lastReplayTime = 0;
+  static unsigned long lastSampleTime = 0;
+  static unsigned long lastDeadbandReport = 0;
+  static unsigned long windowStartMs = 0;
+  static unsigned long lastWindowFailure = 0;
+  static unsigned long lastHealthSample = 0;
+  static unsigned long lastHealthReport = 0;
+  static unsigned long lastLinkReport = 0;
+  static unsigned long lastDnsReport = 0;
+  unsigned long now = millis();
+  bool idle = true; // Cleared by every branch below that does scheduled work
+  heapHealth.beginLoop(allocCounters);
+
   if (!client.connected()) {
-    Serial.println("Reconnecting to AWS IoT...");
-    connectToAWS(); // Reconnect to AWS IoT if disconnected
+    if (wasConnected) {
+      // Just dropped: wait a random delay before the first attempt too, every board saw the same outage
+      wasConnected = false;
+      reconnectDelay = awsBackoff.next(ESP.random());
+      lastConnectAttempt = now;
+    }
+    // An expired endpoint address is queried first without blocking, sampling goes on until it is known
+    DnsStatus dns = DNS_LOOKUP_PENDING;
+    if (now - lastConnectAttempt >= reconnectDelay) {
+      dns = dnsCache.lookup(DNS_AWS, now, awsAddress);
+    }
+    if (dns != DNS_LOOKUP_PENDING) {
+      idle = false;
+      Serial.println("Reconnecting to AWS IoT...");
+      if (dns == DNS_LOOKUP_FAILED) {
+        Serial.println("DNS lookup failed");
+      }
+      if (dns == DNS_LOOKUP_FAILED || !connectToAWS()) { // Reconnect to AWS IoT if disconnected
+        reconnectDelay = awsBackoff.next(ESP.random());
+        Serial.print("Next attempt in ");
+        Serial.print(reconnectDelay);
+        Serial.println(" ms");
+      }
+      lastConnectAttempt = millis(); // The attempt itself can take seconds
+    }
+  } else {
+    wasConnected = true;
+    client.loop(); // Maintain MQTT connection
   }
-  client.loop(); // Maintain MQTT connection
 
-  static unsigned long lastPublishTime = 0;
-  unsigned long now = millis();
-  if (now - lastPublishTime > 60000) { // Publish every 1 minute
-    publishMessage(); // Publish sensor data to AWS IoT
-    lastPublishTime = now; // Update the last publish time
+  if (WINDOW_STATS_ENABLED) {
+    if (now - lastSampleTime >= STATS_SAMPLE_INTERVAL_MS) {
+      idle = false;
+      addWindowSample(); // Fold the readings into the window aggregates
+      lastSampleTime = now;
+    }
+    if (now - windowStartMs >= STATS_WINDOW_MS) {
+      idle = false;
+      closeWindow(); // One summary per window, buffered until it is published
+      windowStartMs = now;
+    }
+    // One window per pass, so a backlog from an outage drains within a few passes.
+    // A failed publish is retried after REPLAY_INTERVAL_MS.
+    if (client.connected() && !windowBuffer.empty() && now - lastWindowFailure >= REPLAY_INTERVAL_MS) {
+      idle = false;
+      if (!publishWindowStats()) {
+        lastWindowFailure = now;
+      }
+    }
+  } else if (now - lastSampleTime >= SAMPLE_INTERVAL_MS) {
+    idle = false;
+    SensorSample sample = takeSample();
+    if (DEADBAND_ENABLED) {
+      applyDeadband(sample); // Keep only the fields worth reporting
+    }
+    if (sample.fieldMask != 0) {
+      if (sampleBuffer.full()) {
+        Serial.println("Sample buffer full, oldest sample dropped.");
+        if (DEADBAND_ENABLED) {
+          invalidateDeadband(sampleBuffer.peek(0).fieldMask); // Its values will never reach the cloud
+        }
+      }
+      sampleBuffer.push(sample); // Buffer the sensor readings
+      if (DEADBAND_ENABLED) {
+        acceptDeadband(sample); // Only now do the buffered values become the references
+      }
+    }
+    lastSampleTime = now; // Update the last sample time
+  }
+
+  if (DEADBAND_ENABLED && client.connected() && now - lastDeadbandReport >= DEADBAND_REPORT_INTERVAL_MS) {
+    idle = false;
+    publishDeadbandStats(); // Report the bandwidth saved by the deadbands
+    lastDeadbandReport = now;
+  }
+
+  if (batchReady(now)) {
+    idle = false;
+    publishMessage(); // Publish the buffered sensor data to AWS IoT
+  }
+
+  // Replay the offline backlog at a limited rate once the live data is out
+  if (client.connected() && telemetryLog.pending() > 0 && !batchReady(now) &&
+      now - lastReplayTime >= REPLAY_INTERVAL_MS) {
+    idle = false;
+    replayBacklog();
+    lastReplayTime = now;
+  }
+
+  if (linkMonitor.service(now, WiFi.RSSI(), WiFi.status() == WL_CONNECTED)) {
+    idle = false; // Sending a probe allocates a packet buffer
+  }
+  if (LINK_REPORT_INTERVAL_MS > 0 && client.connected() && now - lastLinkReport >= LINK_REPORT_INTERVAL_MS) {
+    idle = false;
+    publishLinkSummary(); // Report the link quality of the period
+    lastLinkReport = now;
+  }
+
+  if (dnsCache.service(now, WiFi.status() == WL_CONNECTED)) {
+    idle = false; // A query allocates its request
+  }
+  if (DNS_REPORT_INTERVAL_MS > 0 && client.connected() && now - lastDnsReport >= DNS_REPORT_INTERVAL_MS) {
+    idle = false;
+    publishDnsSummary(); // Report hit rates and resolve times of the period
+    lastDnsReport = now;
+  }
+
+  if (now - lastHealthSample >= HEALTH_SAMPLE_INTERVAL_MS) {
+    sampleHealth(); // Reads the heap without allocating, the pass stays idle
+    lastHealthSample = now;
+  }
+  if (HEALTH_REPORT_INTERVAL_MS > 0 && client.connected() && now - lastHealthReport >= HEALTH_REPORT_INTERVAL_MS) {
+    idle = false;
+    publishHealth(); // Report the heap and stack health of the period
+    lastHealthReport = now;
+  }
+
+  // Allocations in a pass that only kept the connection alive repeat thousands of times a second
+  if (heapHealth.endLoop(allocCounters, idle)) {
+    Serial.print("Heap allocation in an idle loop() pass: ");
+    Serial.print(heapHealth.hotPathAllocBytes());
+    Serial.println(" bytes");
   }
 }
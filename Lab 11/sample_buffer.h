@@ -0,0 +1,54 @@
+// sample_buffer.h
+#ifndef SAMPLE_BUFFER_H
+#define SAMPLE_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Fixed-capacity ring buffer that holds sensor samples in RAM until they are published.
+// When the buffer is full the oldest sample is overwritten, so memory use never grows.
+template <typename T, size_t Capacity>
+class SampleBuffer {
+public:
+  // Add an item to the buffer, returns false if the oldest item had to be overwritten
+  bool push(const T& item) {
+    bool overwrote = false;
+    if (count == Capacity) {
+      head = (head + 1) % Capacity; // Drop the oldest item to make room
+      count--;
+      overwrittenCount++;
+      overwrote = true;
+    }
+    items[(head + count) % Capacity] = item;
+    count++;
+    return !overwrote;
+  }
+
+  // Access the i-th oldest item (0 is the oldest)
+  const T& peek(size_t i) const {
+    return items[(head + i) % Capacity];
+  }
+
+  // Remove the n oldest items, typically after they have been published
+  void drop(size_t n) {
+    if (n > count) {
+      n = count;
+    }
+    head = (head + n) % Capacity;
+    count -= n;
+  }
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  bool full() const { return count == Capacity; }
+  static size_t capacity() { return Capacity; }
+  uint32_t overwritten() const { return overwrittenCount; } // Samples lost because the buffer was full
+
+private:
+  T items[Capacity];
+  size_t head = 0; // Index of the oldest item
+  size_t count = 0; // Number of items currently stored
+  uint32_t overwrittenCount = 0;
+};
+
+#endif // SAMPLE_BUFFER_H
@@ -0,0 +1,248 @@
+// telemetry_encoder.h
+// Needs ArduinoJson but no Arduino header, so Tools/payload-bench builds the same encoders
+// on the host.
+#ifndef TELEMETRY_ENCODER_H
+#define TELEMETRY_ENCODER_H
+
+#include <math.h>
+#include <stdio.h>
+#include <ArduinoJson.h>
+#include "telemetry_schema.h"
+#include "cbor_writer.h"
+#include "window_stats.h"
+
+// One reading of all sensors
+struct SensorSample {
+  uint32_t timestamp; // Seconds since the Epoch when the sample was taken
+  unsigned long takenAtMs; // millis() when the sample was taken, used for the batch age
+  uint16_t fieldMask; // Bit (1 << field) is set for every field to be published
+  float values[FIELD_COUNT];
+};
+
+// Aggregates of one metric over a window, in the field's fixed-point unit
+struct FieldSummary {
+  uint16_t n; // Samples in the window, 0 if every read failed
+  int32_t min;
+  int32_t max;
+  int32_t meanQ; // With WindowStats::FRACTION_BITS fraction bits
+  uint32_t stddevQ;
+};
+
+// One closed window of every metric, kept until it has been published
+struct WindowSummary {
+  uint32_t start; // Seconds since the Epoch of the first sample
+  uint32_t seconds; // Length of the window
+  FieldSummary fields[FIELD_COUNT];
+};
+
+// Function to convert a reading to the fixed-point integer defined by the schema
+inline int32_t toFixed(int field, float value) {
+  float scaled = value * fieldInfo[field].scale;
+  return (int32_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+}
+
+// Serializes samples in the payload shapes the cloud side decodes, as JSON or as CBOR.
+// Every function writes into the caller's buffer and returns the length, or 0 if it did not fit.
+// Every payload starts with the device ID and its PayloadShape.
+//
+// With sparse set (DEADBAND_ENABLED) a batch row only holds the fields whose bit is set in the
+// sample's fieldMask, preceded by the mask.
+class TelemetryEncoder {
+public:
+  TelemetryEncoder(const char* deviceId, bool sparse) : deviceId(deviceId), sparse(sparse) {}
+
+  // Shape of the batches this encoder writes
+  PayloadShape batchShape() const { return sparse ? SHAPE_SPARSE_BATCH : SHAPE_BATCH; }
+
+  // Single sample as a flat JSON object
+  size_t sampleJson(const SensorSample& sample, char* buffer, size_t size) const {
+    StaticJsonDocument<512> doc;
+    doc["device_id"] = deviceId;
+    doc["shape"] = shapeNames[SHAPE_SAMPLE];
+    for (int i = 0; i < FIELD_COUNT; i++) {
+      if (sample.fieldMask & (1 << i)) {
+        doc[fieldInfo[i].name] = sample.values[i];
+      }
+    }
+    doc["timestamp"] = sample.timestamp;
+    return serializeJson(doc, buffer, size);
+  }
+
+  // Several samples as one JSON document.
+  // The field names are sent once and every sample becomes a compact array row:
+  // {"device_id":"...","shape":"batch","fields":["timestamp","Temperature",...],"samples":[[...],[...]]}
+  // or when sparse
+  // {"device_id":"...","shape":"sparse_batch","fields":[...],"sparse_samples":[[timestamp, mask, changed fields...],...]}
+  size_t batchJson(const SensorSample* samples, size_t count, char* buffer, size_t size) const {
+    StaticJsonDocument<512> header;
+    header["device_id"] = deviceId;
+    header["shape"] = shapeNames[batchShape()];
+    JsonArray fields = header.createNestedArray("fields");
+    fields.add("timestamp");
+    for (int i = 0; i < FIELD_COUNT; i++) {
+      fields.add(fieldInfo[i].name);
+    }
+
+    // Write the header without its closing brace, then append the rows one by one
+    size_t len = serializeJson(header, buffer, size);
+    if (len == 0 || len + 21 >= size) {
+      return 0;
+    }
+    len--; // Drop the closing '}'
+    len += snprintf(buffer + len, size - len, sparse ? ",\"sparse_samples\":[" : ",\"samples\":[");
+
+    for (size_t i = 0; i < count; i++) {
+      const SensorSample& sample = samples[i];
+      StaticJsonDocument<JSON_ARRAY_SIZE(FIELD_COUNT + 2)> row;
+      row.add(sample.timestamp);
+      if (sparse) {
+        row.add(sample.fieldMask);
+      }
+      for (int f = 0; f < FIELD_COUNT; f++) {
+        if (sample.fieldMask & (1 << f)) {
+          row.add(sample.values[f]);
+        }
+      }
+      if (len + measureJson(row) + 3 >= size) {
+        return 0; // Not enough room for this batch
+      }
+      if (i > 0) {
+        buffer[len++] = ',';
+      }
+      len += serializeJson(row, buffer + len, size - len);
+    }
+
+    buffer[len++] = ']';
+    buffer[len++] = '}';
+    buffer[len] = '\0';
+    return len;
+  }
+
+  // Single sample as a CBOR map keyed by schema IDs
+  size_t sampleCbor(const SensorSample& sample, uint8_t* buffer, size_t size) const {
+    CborWriter writer(buffer, size);
+    writer.writeMap(3 + __builtin_popcount(sample.fieldMask));
+    writer.writeUInt(KEY_DEVICE_ID);
+    writer.writeText(deviceId);
+    writer.writeUInt(KEY_SHAPE);
+    writer.writeUInt(SHAPE_SAMPLE);
+    writer.writeUInt(KEY_TIMESTAMP);
+    writer.writeUInt(sample.timestamp);
+    for (int i = 0; i < FIELD_COUNT; i++) {
+      if (sample.fieldMask & (1 << i)) {
+        writer.writeUInt(fieldInfo[i].key);
+        writeCborValue(writer, i, sample.values[i]);
+      }
+    }
+    return writer.length();
+  }
+
+  // Several samples as a CBOR map with one array row per sample:
+  // {KEY_DEVICE_ID: "...", KEY_SHAPE: SHAPE_BATCH, KEY_SAMPLES: [[timestamp, field 0, field 1, ...], ...]}
+  // or when sparse
+  // {KEY_DEVICE_ID: "...", KEY_SHAPE: SHAPE_SPARSE_BATCH, KEY_SPARSE_SAMPLES: [[timestamp, mask, changed fields...], ...]}
+  size_t batchCbor(const SensorSample* samples, size_t count, uint8_t* buffer, size_t size) const {
+    CborWriter writer(buffer, size);
+    writer.writeMap(3);
+    writer.writeUInt(KEY_DEVICE_ID);
+    writer.writeText(deviceId);
+    writer.writeUInt(KEY_SHAPE);
+    writer.writeUInt(batchShape());
+    writer.writeUInt(sparse ? KEY_SPARSE_SAMPLES : KEY_SAMPLES);
+    writer.writeArray(count);
+    for (size_t i = 0; i < count; i++) {
+      const SensorSample& sample = samples[i];
+      if (sparse) {
+        writer.writeArray(2 + __builtin_popcount(sample.fieldMask));
+        writer.writeUInt(sample.timestamp);
+        writer.writeUInt(sample.fieldMask);
+      } else {
+        writer.writeArray(1 + FIELD_COUNT);
+        writer.writeUInt(sample.timestamp);
+      }
+      for (int f = 0; f < FIELD_COUNT; f++) {
+        if (sample.fieldMask & (1 << f)) {
+          writeCborValue(writer, f, sample.values[f]);
+        }
+      }
+    }
+    return writer.length();
+  }
+
+  // Window summary as JSON, in real units:
+  // {"device_id":"...","shape":"window","window_start":...,"window_s":...,"Temperature":{"n":..,"min":..,"max":..,"mean":..,"stddev":..},...}
+  size_t windowJson(const WindowSummary& window, char* buffer, size_t size) const {
+    StaticJsonDocument<JSON_OBJECT_SIZE(4 + FIELD_COUNT) + FIELD_COUNT * JSON_OBJECT_SIZE(5)> doc;
+    doc["device_id"] = deviceId;
+    doc["shape"] = shapeNames[SHAPE_WINDOW];
+    doc["window_start"] = window.start;
+    doc["window_s"] = window.seconds;
+    for (int i = 0; i < FIELD_COUNT; i++) {
+      const FieldSummary& field = window.fields[i];
+      if (field.n == 0) {
+        continue;
+      }
+      // Convert back to real units only here, once per window
+      float scale = fieldInfo[i].scale;
+      float fixedScale = scale * (1 << WindowStats::FRACTION_BITS);
+      JsonObject metric = doc.createNestedObject(fieldInfo[i].name);
+      metric["n"] = field.n;
+      metric["min"] = field.min / scale;
+      metric["max"] = field.max / scale;
+      metric["mean"] = field.meanQ / fixedScale;
+      metric["stddev"] = field.stddevQ / fixedScale;
+    }
+    return serializeJson(doc, buffer, size);
+  }
+
+  // Window summary as CBOR, mean and standard deviation rounded to the field unit like a sample:
+  // {KEY_DEVICE_ID: "...", KEY_SHAPE: SHAPE_WINDOW, KEY_WINDOW_START: ..., KEY_WINDOW_S: ..., KEY_WINDOW_STATS: {field key: [n, min, max, mean, stddev], ...}}
+  size_t windowCbor(const WindowSummary& window, uint8_t* buffer, size_t size) const {
+    int present = 0;
+    for (int i = 0; i < FIELD_COUNT; i++) {
+      present += window.fields[i].n > 0;
+    }
+    const int32_t half = 1 << (WindowStats::FRACTION_BITS - 1);
+    CborWriter writer(buffer, size);
+    writer.writeMap(5);
+    writer.writeUInt(KEY_DEVICE_ID);
+    writer.writeText(deviceId);
+    writer.writeUInt(KEY_SHAPE);
+    writer.writeUInt(SHAPE_WINDOW);
+    writer.writeUInt(KEY_WINDOW_START);
+    writer.writeUInt(window.start);
+    writer.writeUInt(KEY_WINDOW_S);
+    writer.writeUInt(window.seconds);
+    writer.writeUInt(KEY_WINDOW_STATS);
+    writer.writeMap(present);
+    for (int i = 0; i < FIELD_COUNT; i++) {
+      const FieldSummary& field = window.fields[i];
+      if (field.n == 0) {
+        continue;
+      }
+      writer.writeUInt(fieldInfo[i].key);
+      writer.writeArray(5);
+      writer.writeUInt(field.n);
+      writer.writeInt(field.min);
+      writer.writeInt(field.max);
+      writer.writeInt((field.meanQ + (field.meanQ < 0 ? -half : half)) / (1 << WindowStats::FRACTION_BITS));
+      writer.writeUInt((field.stddevQ + half) >> WindowStats::FRACTION_BITS);
+    }
+    return writer.length();
+  }
+
+private:
+  const char* deviceId;
+  bool sparse;
+
+  // Write a field value as the scaled integer defined by the schema
+  static void writeCborValue(CborWriter& writer, int field, float value) {
+    if (isnan(value)) {
+      writer.writeNull(); // Sensor read failed
+      return;
+    }
+    writer.writeInt(toFixed(field, value));
+  }
+};
+
+#endif // TELEMETRY_ENCODER_H
@@ -0,0 +1,300 @@
+// telemetry_log.h
+#ifndef TELEMETRY_LOG_H
+#define TELEMETRY_LOG_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+// Log parameters (can be overridden with -D build flags)
+#ifndef TLOG_DIR
+#define TLOG_DIR "/tlog" // Directory holding the segment files and the read cursor
+#endif
+#ifndef TLOG_SEGMENT_RECORDS
+#define TLOG_SEGMENT_RECORDS 256 // Records per segment file
+#endif
+#ifndef TLOG_MAX_SEGMENTS
+#define TLOG_MAX_SEGMENTS 64 // Oldest segment is discarded when the log grows past this
+#endif
+#ifndef TLOG_CURSOR_SAVE_RECORDS
+#define TLOG_CURSOR_SAVE_RECORDS 64 // The read cursor is saved after this many records, and at every segment change
+#endif
+
+// Append-only log of fixed-size records on LittleFS, used to keep telemetry while offline.
+//
+// Records are appended to numbered segment files (TLOG_DIR/0000002a.log). A segment is never
+// rewritten: once every record in it has been replayed the whole file is deleted, so writes
+// keep moving through the flash and LittleFS can spread the wear. The read cursor (segment and
+// record index) is stored in a small file whenever the read moves to another segment and after
+// every TLOG_CURSOR_SAVE_RECORDS records in between, rather than on every consume(), which would
+// rewrite the cursor once per replayed message. A reboot never loses a record; it can replay up
+// to TLOG_CURSOR_SAVE_RECORDS - 1 records that were already delivered.
+template <typename Record>
+class TelemetryLog {
+public:
+  // Mount the file system and recover the segments and cursor left by a previous run
+  bool begin() {
+    if (!LittleFS.begin()) {
+      return false;
+    }
+    if (!LittleFS.exists(TLOG_DIR)) {
+      LittleFS.mkdir(TLOG_DIR);
+    }
+
+    bool haveCursor = loadCursor();
+    if (haveCursor) {
+      removeSegmentsBefore(readSegment); // Left behind if a reset hit between delete and cursor save
+    }
+
+    // Find the oldest and newest segment files
+    bool found = false;
+    uint32_t oldest = 0;
+    size_t newestSize = 0;
+    Dir dir = LittleFS.openDir(TLOG_DIR);
+    while (dir.next()) {
+      uint32_t id;
+      if (!parseSegmentName(dir.fileName(), id)) {
+        continue;
+      }
+      if (!found || id < oldest) {
+        oldest = id;
+      }
+      if (!found || id > writeSegment) {
+        writeSegment = id;
+        newestSize = dir.fileSize();
+      }
+      found = true;
+    }
+
+    if (!found) {
+      // Empty log, keep counting segment numbers from where the cursor left off
+      writeSegment = haveCursor ? readSegment : 0;
+      writeCount = 0;
+      readSegment = writeSegment;
+      readIndex = 0;
+    } else {
+      writeCount = newestSize / sizeof(Record);
+      if (newestSize % sizeof(Record) != 0 || writeCount >= TLOG_SEGMENT_RECORDS) {
+        // The last record was torn by a reset or the segment is full, start a fresh one
+        writeSegment++;
+        writeCount = 0;
+      }
+      if (!haveCursor || readSegment < oldest) {
+        readSegment = oldest;
+        readIndex = 0;
+      }
+    }
+
+    pendingCount = countPending();
+    return true;
+  }
+
+  // Append a record at the end of the log
+  bool append(const Record& record) {
+    if (writeCount >= TLOG_SEGMENT_RECORDS) {
+      writeSegment++;
+      writeCount = 0;
+    }
+    while (writeSegment - readSegment >= TLOG_MAX_SEGMENTS) {
+      dropOldestSegment(); // Log is full, sacrifice the oldest data
+    }
+
+    if (!writeRecord(record)) {
+      // Most likely out of space, free the oldest segment and try once more
+      if (readSegment == writeSegment || !dropOldestSegment() || !writeRecord(record)) {
+        return false;
+      }
+    }
+    writeCount++;
+    pendingCount++;
+    return true;
+  }
+
+  // Copy up to max records starting at the read cursor, without consuming them.
+  // A read never crosses a segment boundary, so it may return fewer records than are pending.
+  size_t read(Record* out, size_t max) {
+    skipFinishedSegment();
+    if (pendingCount == 0) {
+      return 0;
+    }
+
+    File file = LittleFS.open(segmentPath(readSegment), "r");
+    if (!file) {
+      return 0;
+    }
+    size_t n = 0;
+    if (file.seek(readIndex * sizeof(Record), SeekSet)) {
+      while (n < max && file.read((uint8_t*)&out[n], sizeof(Record)) == sizeof(Record)) {
+        n++;
+      }
+    }
+    file.close();
+    return n;
+  }
+
+  // Mark n records returned by read() as delivered, the cursor is saved when it is due
+  void consume(size_t n) {
+    if (n > pendingCount) {
+      n = pendingCount;
+    }
+    readIndex += n;
+    pendingCount -= n;
+    skipFinishedSegment();
+    if (readSegment != savedSegment || readIndex - savedIndex >= TLOG_CURSOR_SAVE_RECORDS) {
+      saveCursor();
+    }
+  }
+
+  uint32_t pending() const { return pendingCount; } // Records waiting to be replayed
+  uint32_t dropped() const { return droppedCount; } // Records discarded because the log was full
+
+private:
+  struct Cursor {
+    uint32_t recordSize; // Detects a firmware change of the record layout
+    uint32_t segment;
+    uint32_t index;
+  };
+
+  uint32_t readSegment = 0; // Oldest segment still holding unread records
+  uint32_t readIndex = 0; // Next record to read within readSegment
+  uint32_t writeSegment = 0; // Segment receiving new records
+  uint32_t writeCount = 0; // Records already in writeSegment
+  uint32_t pendingCount = 0;
+  uint32_t droppedCount = 0;
+  uint32_t savedSegment = 0; // Cursor as last stored in the cursor file
+  uint32_t savedIndex = 0;
+
+  static String segmentPath(uint32_t id) {
+    char path[32];
+    snprintf(path, sizeof(path), TLOG_DIR "/%08lx.log", (unsigned long)id);
+    return String(path);
+  }
+
+  static bool parseSegmentName(const String& name, uint32_t& id) {
+    if (name.length() != 12 || !name.endsWith(".log")) {
+      return false;
+    }
+    char* end;
+    id = strtoul(name.c_str(), &end, 16);
+    return end == name.c_str() + 8;
+  }
+
+  // Number of complete records stored in a segment
+  static uint32_t recordsIn(uint32_t id) {
+    File file = LittleFS.open(segmentPath(id), "r");
+    if (!file) {
+      return 0;
+    }
+    uint32_t records = file.size() / sizeof(Record);
+    file.close();
+    return records;
+  }
+
+  uint32_t countPending() {
+    uint32_t total = 0;
+    for (uint32_t id = readSegment; id <= writeSegment; id++) {
+      total += recordsIn(id);
+    }
+    return total > readIndex ? total - readIndex : 0;
+  }
+
+  bool writeRecord(const Record& record) {
+    File file = LittleFS.open(segmentPath(writeSegment), "a");
+    if (!file) {
+      return false;
+    }
+    size_t written = file.write((const uint8_t*)&record, sizeof(Record));
+    file.close();
+    if (written != sizeof(Record)) {
+      writeSegment++; // Never append behind a partial record
+      writeCount = 0;
+      return false;
+    }
+    return true;
+  }
+
+  // Delete the segment under the read cursor once all of its records have been read
+  void skipFinishedSegment() {
+    while (readSegment < writeSegment && readIndex >= recordsIn(readSegment)) {
+      LittleFS.remove(segmentPath(readSegment));
+      readSegment++;
+      readIndex = 0;
+    }
+    if (pendingCount == 0 && readSegment == writeSegment && writeCount > 0) {
+      // Fully caught up, recycle the current segment right away
+      LittleFS.remove(segmentPath(readSegment));
+      writeSegment++;
+      writeCount = 0;
+      readSegment = writeSegment;
+      readIndex = 0;
+    }
+  }
+
+  bool dropOldestSegment() {
+    if (readSegment == writeSegment) {
+      return false;
+    }
+    uint32_t records = recordsIn(readSegment);
+    uint32_t lost = records > readIndex ? records - readIndex : 0;
+    LittleFS.remove(segmentPath(readSegment));
+    readSegment++;
+    readIndex = 0;
+    pendingCount -= lost;
+    droppedCount += lost;
+    saveCursor();
+    return true;
+  }
+
+  // Delete every segment file numbered below id. The directory is scanned again after each
+  // removal rather than deleting entries while iterating over them.
+  static void removeSegmentsBefore(uint32_t id) {
+    bool removed = true;
+    while (removed) {
+      removed = false;
+      Dir dir = LittleFS.openDir(TLOG_DIR);
+      while (dir.next()) {
+        uint32_t segment;
+        if (parseSegmentName(dir.fileName(), segment) && segment < id) {
+          LittleFS.remove(segmentPath(segment));
+          removed = true;
+          break;
+        }
+      }
+    }
+  }
+
+  bool loadCursor() {
+    File file = LittleFS.open(TLOG_DIR "/cursor", "r");
+    if (!file) {
+      return false;
+    }
+    Cursor cursor;
+    bool ok = file.read((uint8_t*)&cursor, sizeof(cursor)) == sizeof(cursor);
+    file.close();
+    if (!ok) {
+      return false;
+    }
+    if (cursor.recordSize != sizeof(Record)) {
+      // Records were written by a firmware with a different layout and cannot be decoded
+      removeSegmentsBefore(UINT32_MAX);
+      return false;
+    }
+    readSegment = cursor.segment;
+    readIndex = cursor.index;
+    savedSegment = readSegment;
+    savedIndex = readIndex;
+    return true;
+  }
+
+  void saveCursor() {
+    Cursor cursor = { sizeof(Record), readSegment, readIndex };
+    File file = LittleFS.open(TLOG_DIR "/cursor", "w");
+    if (file) {
+      file.write((const uint8_t*)&cursor, sizeof(cursor));
+      file.close();
+      savedSegment = readSegment;
+      savedIndex = readIndex;
+    }
+  }
+};
+
+#endif // TELEMETRY_LOG_H
@@ -0,0 +1,69 @@
+// telemetry_schema.h
+// Shared between the firmware and the host-side decoder (Tools/telemetry-decoder),
+// so it must not depend on any Arduino header.
+#ifndef TELEMETRY_SCHEMA_H
+#define TELEMETRY_SCHEMA_H
+
+#include <stdint.h>
+
+// Payload formats, selected with -D PAYLOAD_FORMAT=PAYLOAD_FORMAT_CBOR
+#define PAYLOAD_FORMAT_JSON 0 // Human readable JSON with string keys
+#define PAYLOAD_FORMAT_CBOR 1 // Compact CBOR with the integer keys below
+
+// Top-level CBOR map keys. Every key below 24 is encoded in a single byte.
+enum TelemetryKey {
+  KEY_DEVICE_ID = 0, // Text string
+  KEY_TIMESTAMP = 1, // Seconds since the Epoch
+  KEY_SAMPLES = 2, // Batch: array of rows [timestamp, field 0, field 1, ...]
+  KEY_SPARSE_SAMPLES = 11, // Deadband batch: rows [timestamp, field mask, fields whose bit is set...]
+  KEY_WINDOW_START = 12, // Window summary: seconds since the Epoch of the first sample
+  KEY_WINDOW_S = 13, // Window summary: length of the window in seconds
+  KEY_WINDOW_STATS = 14, // Window summary: map of field key to [n, min, max, mean, stddev], in field units
+  KEY_SHAPE = 15 // PayloadShape of the message, written right after the device ID
+};
+
+// Layout of a payload, sent in every message ("shape" in JSON) so a decoder reads it instead of
+// guessing from the keys or the batch size. Never renumber; a new layout gets a new value.
+enum PayloadShape {
+  SHAPE_SAMPLE = 0, // One sample, one key per field
+  SHAPE_BATCH = 1, // Rows of every field under KEY_SAMPLES
+  SHAPE_SPARSE_BATCH = 2, // Rows of the fields in their mask under KEY_SPARSE_SAMPLES
+  SHAPE_WINDOW = 3, // Window summary
+  SHAPE_COUNT
+};
+
+// JSON value of "shape", by PayloadShape
+const char* const shapeNames[SHAPE_COUNT] = { "sample", "batch", "sparse_batch", "window" };
+
+// Fields carried by every sample, in the order they appear in a batch row
+enum SensorField {
+  FIELD_TEMPERATURE,
+  FIELD_HUMIDITY,
+  FIELD_PRESSURE,
+  FIELD_AIR_QUALITY,
+  FIELD_CO2,
+  FIELD_VOC,
+  FIELD_LIGHT,
+  FIELD_NOISE,
+  FIELD_COUNT
+};
+
+// How each field is identified and encoded
+struct FieldInfo {
+  uint8_t key; // CBOR map key, never reuse a retired key
+  const char* name; // JSON key
+  int32_t scale; // CBOR carries round(value * scale) as an integer, no floats on the wire
+};
+
+const FieldInfo fieldInfo[FIELD_COUNT] = {
+  { 3, "Temperature", 100 }, // 0.01 C
+  { 4, "Humidity", 100 }, // 0.01 %
+  { 5, "Pressure", 100 }, // 0.01 hPa
+  { 6, "AirQuality", 1 }, // AQI
+  { 7, "CO2", 1 }, // ppm
+  { 8, "VOC", 1 }, // ppb
+  { 9, "Light", 1 }, // lux
+  { 10, "Noise", 1 } // dB
+};
+
+#endif // TELEMETRY_SCHEMA_H
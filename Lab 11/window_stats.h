@@ -0,0 +1,109 @@
+// window_stats.h
+#ifndef WINDOW_STATS_H
+#define WINDOW_STATS_H
+
+#include <stdint.h>
+
+// Streaming min/max/mean/variance of one metric, in integer arithmetic only.
+//
+// Values are fixed-point integers in the metric's own unit (e.g. 0.01 C for a temperature
+// scaled by 100). The mean is tracked with FRACTION_BITS extra fraction bits and the variance
+// with Welford's method, so every sample is folded in with a few 64-bit integer operations and
+// no float math, which the FPU-less ESP8266 would have to emulate. Memory use is constant:
+// about 40 bytes per metric whatever the window length.
+//
+// Inputs must stay within +/-INPUT_LIMIT (e.g. +/-5242.87 for a value scaled by 100) and a window
+// must hold at most MAX_SAMPLES samples, so the 64-bit accumulators cannot overflow.
+class WindowStats {
+public:
+  static const int FRACTION_BITS = 8;
+  static const uint32_t MAX_SAMPLES = 4095; // Longest window the accumulators are exact for
+  static const int32_t INPUT_LIMIT = (1 << 19) - 1; // Largest input magnitude, in either direction
+
+  void reset() {
+    n = 0;
+    sum = 0;
+    meanFixed = 0;
+    m2Fixed = 0;
+  }
+
+  void add(int32_t value) {
+    if (n == 0 || value < minValue) {
+      minValue = value;
+    }
+    if (n == 0 || value > maxValue) {
+      maxValue = value;
+    }
+    n++;
+    sum += value;
+
+    // Welford: M2 += (x - old mean) * (x - new mean). The mean is recomputed from the exact
+    // sum rather than stepped by (x - mean) / n, whose rounding errors would add up over a
+    // long window, to more than a whole input unit for a slowly drifting input.
+    int64_t x = (int64_t)value << FRACTION_BITS;
+    int64_t delta = x - meanFixed;
+    meanFixed = divideRounded(sum * (1 << FRACTION_BITS), n);
+    int64_t delta2 = x - meanFixed;
+    m2Fixed += (delta * delta2) >> FRACTION_BITS;
+  }
+
+  uint32_t count() const { return n; }
+  int32_t min() const { return minValue; }
+  int32_t max() const { return maxValue; }
+
+  // Mean with FRACTION_BITS fraction bits
+  int64_t meanQ() const { return meanFixed; }
+
+  // Mean rounded to the input unit
+  int32_t mean() const {
+    return (int32_t)divideRounded(meanFixed, 1 << FRACTION_BITS);
+  }
+
+  // Sample variance (divided by n - 1) in squared input units, with FRACTION_BITS fraction bits
+  uint64_t varianceQ() const {
+    if (n < 2 || m2Fixed <= 0) {
+      return 0;
+    }
+    return (uint64_t)m2Fixed / (n - 1);
+  }
+
+  // Sample standard deviation in input units, with FRACTION_BITS fraction bits
+  uint32_t stddevQ() const {
+    // sqrt(variance * 2^F * 2^F) = stddev * 2^F
+    return isqrt(varianceQ() << FRACTION_BITS);
+  }
+
+private:
+  uint32_t n = 0;
+  int32_t minValue = 0;
+  int32_t maxValue = 0;
+  int64_t sum = 0; // Exact sum of the inputs
+  int64_t meanFixed = 0; // Running mean, input units << FRACTION_BITS
+  int64_t m2Fixed = 0; // Sum of squared deviations, squared input units << FRACTION_BITS
+
+  static int64_t divideRounded(int64_t value, uint32_t divisor) {
+    int64_t half = divisor / 2;
+    return (value >= 0 ? value + half : value - half) / (int64_t)divisor;
+  }
+
+  // Integer square root, rounded down
+  static uint32_t isqrt(uint64_t value) {
+    uint64_t result = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > value) {
+      bit >>= 2;
+    }
+    while (bit != 0) {
+      if (value >= result + bit) {
+        value -= result + bit;
+        result = (result >> 1) + bit;
+      } else {
+        result >>= 1;
+      }
+      bit >>= 2;
+    }
+    return (uint32_t)result;
+  }
+};
+
+#endif // WINDOW_STATS_H
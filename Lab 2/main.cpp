@@ -1,5 +1,5 @@
 #include <ESP8266WiFi.h> // Include the WiFi library for ESP8266
-#include <ESP8266Ping.h> // Include the Ping library for ESP8266
+#include "link_monitor.h" // Background ICMP probes with round-trip, jitter, loss and RSSI statistics
 
 // WiFi parameters to be configured by the user
 const char* ssid = "your_SSID_here"; // Enter your WiFi SSID (network name)
@@ -8,9 +8,29 @@ const char* pingHost = "google.com"; // Host to ping for connectivity check
 
 const int ledPin = LED_BUILTIN; // Onboard LED pin for status indication
 
+// Link-quality monitor: every target is probed in the background, loop() never waits for a reply
+const LinkTarget linkTargets[] = {
+  { "gateway", nullptr }, // The access point's router, shows the quality of the Wi-Fi hop alone
+  { "dns", "1.1.1.1" }, // A public resolver that answers pings
+  { "host", pingHost },
+};
+const size_t HOST_TARGET = 2; // Index of pingHost in linkTargets
+const unsigned long PROBE_INTERVAL_MS = 2000; // Each target is probed this often
+const unsigned long PROBE_TIMEOUT_MS = 1000; // A probe without a reply after this long is lost
+const unsigned long SUMMARY_INTERVAL_MS = 60000; // How often the link summary is printed
+const unsigned long DETAILS_INTERVAL_MS = 10000; // How often the WiFi details are printed
+LinkMonitor<sizeof(linkTargets) / sizeof(linkTargets[0])> linkMonitor(linkTargets, PROBE_INTERVAL_MS, PROBE_TIMEOUT_MS);
+char summaryBuffer[1024]; // Link summary as JSON, up to about 700 bytes with three targets and every RSSI band
+
+unsigned long lastDetails = 0; // millis() value when the WiFi details were last printed
+unsigned long lastSummary = 0; // millis() value when the link summary was last printed
+unsigned long blinkStart = 0; // millis() value when the current status blink started
+bool blinking = false; // True while the LED blinks after the WiFi details
+
 // Function prototypes
 void displayWiFiDetails();
-void pingTest();
+void updateStatusLed();
+void printLinkSummary();
 
 void setup(void) {
   // Set the LED pin as an OUTPUT
@@ -36,15 +56,33 @@ void setup(void) {
   Serial.println("");
   Serial.println("WiFi connected");
 
+  // Start probing the link in the background
+  linkMonitor.setGateway(WiFi.gatewayIP());
+  if (!linkMonitor.begin()) {
+    Serial.println("ICMP probes unavailable, no link statistics");
+  }
+
   // Display WiFi details
   displayWiFiDetails();
+  lastDetails = millis();
+  lastSummary = millis();
 }
 
 void loop() {
-  // Continuously display WiFi details and perform ping test every 10 seconds
-  displayWiFiDetails();
-  pingTest();
-  delay(10000); // Wait for 10 seconds before repeating
+  // Every step only checks its timer, so loop() never blocks and other work can be added here
+  unsigned long now = millis();
+  bool connected = WiFi.status() == WL_CONNECTED;
+  linkMonitor.service(now, connected ? WiFi.RSSI() : 0, connected); // Send due probes, expire old ones
+
+  if (now - lastDetails >= DETAILS_INTERVAL_MS) {
+    displayWiFiDetails(); // Display WiFi details every 10 seconds
+    lastDetails = now;
+  }
+  if (now - lastSummary >= SUMMARY_INTERVAL_MS) {
+    printLinkSummary(); // Round trip, jitter and loss per target, set against the RSSI
+    lastSummary = now;
+  }
+  updateStatusLed();
 }
 
 void displayWiFiDetails() {
@@ -70,28 +108,46 @@ void displayWiFiDetails() {
   Serial.print("RSSI: ");
   Serial.println(WiFi.RSSI());
 
+  // Print the last round trip to the host, in place of the old blocking ping test
+  const RttStats& host = linkMonitor.targetStats(HOST_TARGET);
+  Serial.print("Ping ");
+  Serial.print(pingHost);
+  Serial.print(": ");
+  Serial.print(host.received());
+  Serial.print(" of ");
+  Serial.print(host.sent());
+  Serial.print(" replies this period, mean ");
+  Serial.print(host.mean() / 1000.0);
+  Serial.println(" ms");
+
   Serial.println("---------");
 
-  // Blink LED to indicate status
-  for (int i = 0; i < 2; i++) {
-    digitalWrite(ledPin, HIGH);
-    delay(250); // Wait 250 milliseconds
+  // Blink LED to indicate status, updateStatusLed() times the blinks
+  blinking = true;
+  blinkStart = millis();
+}
+
+// Function to blink the LED twice after the WiFi details, 250 ms on and 250 ms off, without delay()
+void updateStatusLed() {
+  if (!blinking) {
+    return;
+  }
+  unsigned long elapsed = millis() - blinkStart;
+  if (elapsed >= 1000) {
     digitalWrite(ledPin, LOW);
-    delay(250); // Wait another 250 milliseconds
+    blinking = false;
+    return;
   }
+  digitalWrite(ledPin, (elapsed / 250) % 2 == 0 ? HIGH : LOW);
 }
 
-void pingTest() {
-  // Print message indicating start of ping test
-  Serial.print("Pinging ");
-  Serial.print(pingHost);
-  Serial.println("...");
-
-  // Perform the ping test
-  if (Ping.ping(pingHost)) {
-    Serial.println("Ping successful"); // Print message if ping is successful
+// Function to print the link summary of the last period and start a new one
+void printLinkSummary() {
+  if (linkMonitor.writeSummary(summaryBuffer, sizeof(summaryBuffer), SUMMARY_INTERVAL_MS) > 0) {
+    Serial.print("Link: ");
+    Serial.println(summaryBuffer);
   } else {
-    Serial.println("Ping failed"); // Print message if ping fails
+    Serial.println("Link summary does not fit in summaryBuffer, make it larger");
   }
-  Serial.println("---------");
+  linkMonitor.resetPeriod();
 }
@@ -2,6 +2,12 @@
 #include <PubSubClient.h> // Library for MQTT communication, allowing the ESP8266 to publish and subscribe to topics
 #include <WiFiClientSecureBearSSL.h> // Library for secure WiFi connections using BearSSL, enabling secure communication with AWS IoT Core
 #include <time.h> // Library for time functions, used for NTP (Network Time Protocol) to synchronize the device's clock
+#include "backoff.h" // Exponential backoff with jitter for reconnects
+#include "tls_session.h" // TLS session resumption, with the handshake time of every connect
+#include "aws_certs.h" // Device certificate, key and root CA, parsed once at startup
+#if __has_include("aws_certs_der.h")
+#include "aws_certs_der.h" // Certificates precompiled to DER by Tools/cert-compiler
+#endif
 
 // WiFi parameters
 const char* ssid = "your-ssid"; // Replace with your WiFi SSID
@@ -36,7 +42,10 @@ YOUR_ROOT_CA_CONTENT_HERE
 
 // Global variables for secure WiFi and MQTT clients
 BearSSL::WiFiClientSecure wifiClient;
+TlsSession tlsSession; // Kept between connections so reconnects can skip the full handshake
+AwsCertificates awsCertificates; // Parsed once and kept for as long as the TLS client uses them
 PubSubClient client(wifiClient);
+Backoff awsBackoff(1000, 60000); // Reconnect delays: up to 1 s after the first failure, doubling to at most a minute
 
 // Callback function to handle incoming messages
 void messageReceived(char* topic, byte* payload, unsigned int length) {
@@ -85,16 +94,31 @@ void NTPConnect() {
   Serial.print(asctime(&timeinfo));
 }
 
+// Function to parse the certificates and key once at startup.
+// The TLS client only keeps pointers to them, so they must outlive every connection.
+void loadCertificates() {
+#ifdef AWS_CERTS_DER_H
+  // DER from aws_certs_der.h, no base64 decoding
+  awsCertificates.loadDer(awsCertDer, sizeof(awsCertDer), awsPrivateKeyDer, sizeof(awsPrivateKeyDer),
+                          awsRootCADer, sizeof(awsRootCADer));
+#else
+  awsCertificates.loadPem(awsCert, awsPrivateKey, awsRootCA);
+#endif
+  awsCertificates.attach(wifiClient);
+}
+
+// Function to connect the MQTT client and log whether the TLS session was resumed
+bool connectMQTT() {
+  bool connected = tlsSession.connect([]() { return client.connect("ESP8266Client"); }); // The TLS handshake happens in here
+  if (connected) {
+    Serial.println(tlsSession.summary());
+  }
+  return connected;
+}
+
 // Function to connect to AWS IoT Core
 void connectAWS() {
-  // Convert the certificate strings to BearSSL types
-  BearSSL::X509List cert(awsCert);
-  BearSSL::PrivateKey key(awsPrivateKey);
-  BearSSL::X509List ca(awsRootCA);
-
-  // Set the certificates and key
-  wifiClient.setClientRSACert(&cert, &key);
-  wifiClient.setTrustAnchors(&ca);
+  tlsSession.attach(wifiClient); // Offer the previous session, BearSSL falls back to a full handshake if refused
   
   client.setServer(awsEndpoint, awsPort); // Set the AWS IoT endpoint and port
   client.setCallback(messageReceived); // Set the callback function for incoming messages
@@ -103,15 +127,19 @@ void connectAWS() {
   while (!client.connected()) {
     Serial.print("Connecting to AWS IoT...");
 
-    if (client.connect("ESP8266Client")) {
+    if (connectMQTT()) {
+      awsBackoff.reset(); // The next outage starts again from the shortest delay
       Serial.println("connected");
       // Subscribe to the topic
       client.subscribe(subscribeTopic);
     } else {
       Serial.print("failed, rc=");
       Serial.print(client.state()); // Print the error code
-      Serial.println(" try again in 5 seconds");
-      delay(5000); // Wait 5 seconds before retrying
+      unsigned long wait = awsBackoff.next(ESP.random()); // Random delay, so a fleet does not retry in lockstep
+      Serial.print(" try again in ");
+      Serial.print(wait);
+      Serial.println(" ms");
+      delay(wait); // Wait before retrying
     }
   }
 }
@@ -120,6 +148,7 @@ void setup() {
   Serial.begin(115200); // Initialize serial communication at 115200 baud
   setupWiFi(); // Setup WiFi connection
   NTPConnect(); // Synchronize time using NTP
+  loadCertificates(); // Parse the certificates once, they are reused by every reconnect
   connectAWS(); // Connect to AWS IoT Core
 }
 
@@ -0,0 +1,61 @@
+// index_html_gz.h
+// Generated by Tools/web-compiler from web/index.html. Do not edit, regenerate it instead.
+#ifndef INDEX_HTML_GZ_H
+#define INDEX_HTML_GZ_H
+
+#include <pgmspace.h>
+
+// 2039 bytes of HTML, 1655 minified, 764 gzipped
+#define INDEX_HTML_ETAG "\"b43239b9\""
+const uint8_t indexHtmlGz[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x95, 0x55, 0x51, 0x4f, 0xdb, 0x30,
+  0x10, 0x7e, 0xcf, 0xaf, 0xb8, 0xb1, 0x07, 0xa7, 0x82, 0x26, 0x5b, 0x8b, 0x50, 0xd5, 0xa6, 0x7d,
+  0x60, 0x2b, 0x63, 0x52, 0x81, 0x69, 0xf0, 0xb0, 0x37, 0xe4, 0x3a, 0x4e, 0x6a, 0xe1, 0xda, 0x99,
+  0xed, 0x00, 0x1d, 0xf0, 0xdf, 0x77, 0x8e, 0xd3, 0x52, 0x06, 0x54, 0x5a, 0x95, 0x26, 0xf1, 0xdd,
+  0xf9, 0xbb, 0xef, 0xee, 0xb3, 0x9d, 0x6c, 0xe1, 0x96, 0x72, 0x12, 0x65, 0x0b, 0x4e, 0x73, 0x7c,
+  0x38, 0xe1, 0x24, 0x9f, 0x4c, 0x2f, 0x7f, 0x0c, 0x7a, 0x47, 0x47, 0xf0, 0x45, 0x2b, 0x67, 0xb4,
+  0xcc, 0xd2, 0x60, 0x8e, 0x32, 0xeb, 0x56, 0xfe, 0x39, 0xd7, 0xf9, 0x0a, 0x1e, 0xa0, 0x40, 0x77,
+  0xb7, 0xa0, 0x4b, 0x21, 0x57, 0x43, 0x58, 0x6a, 0xa5, 0x6d, 0x45, 0x19, 0x1f, 0x81, 0xe3, 0xf7,
+  0xae, 0x4b, 0xa5, 0x28, 0xd5, 0x10, 0x18, 0x57, 0x8e, 0x9b, 0x11, 0xcc, 0x29, 0xbb, 0x29, 0x8d,
+  0xae, 0x55, 0xde, 0x65, 0x5a, 0x6a, 0x33, 0x84, 0x8f, 0xbd, 0x41, 0x8f, 0xf5, 0x0f, 0x47, 0xd0,
+  0x8e, 0xef, 0x16, 0xc2, 0xe1, 0xe4, 0xa7, 0x68, 0x5e, 0x3b, 0xa7, 0x15, 0xe2, 0x57, 0x34, 0xcf,
+  0x85, 0x2a, 0x87, 0xf0, 0xf9, 0x53, 0x75, 0x0f, 0x3d, 0xbc, 0x8d, 0x60, 0x49, 0x4d, 0x29, 0x54,
+  0x30, 0x8d, 0x02, 0x03, 0x2b, 0xfe, 0x70, 0x34, 0x1c, 0x79, 0x03, 0xab, 0x8d, 0xf5, 0x60, 0x95,
+  0x16, 0xef, 0xe6, 0x3d, 0x3c, 0x7c, 0x95, 0x74, 0xae, 0x4d, 0xce, 0x71, 0xa8, 0xb4, 0xda, 0xa2,
+  0x90, 0x50, 0xe6, 0xc4, 0x2d, 0x47, 0x26, 0x6f, 0xa0, 0x0c, 0x06, 0x03, 0x1f, 0x99, 0x50, 0xcb,
+  0x84, 0xe8, 0x52, 0xe3, 0xd6, 0x0d, 0x69, 0xe9, 0xf4, 0x3c, 0x1d, 0x29, 0x14, 0xef, 0x2e, 0xb8,
+  0x28, 0x17, 0x0e, 0x4d, 0x4d, 0x3c, 0xd3, 0xca, 0x6a, 0xe9, 0x41, 0x43, 0x29, 0x5d, 0xa7, 0xab,
+  0x61, 0x5b, 0xdc, 0x8b, 0x82, 0xdf, 0xe4, 0xde, 0xef, 0xf7, 0xd7, 0x6c, 0xbb, 0x86, 0xe6, 0xa2,
+  0xb6, 0xeb, 0xe0, 0xed, 0xa6, 0x4b, 0x5e, 0x38, 0x9f, 0x2c, 0x4b, 0x5b, 0xc1, 0xb2, 0xb4, 0xd5,
+  0xd7, 0x2b, 0xe7, 0xd5, 0xfe, 0xfc, 0x5a, 0x63, 0xb4, 0x45, 0x59, 0x65, 0x38, 0x30, 0x49, 0xad,
+  0x1d, 0x93, 0x4d, 0x61, 0x64, 0x02, 0xf8, 0xbb, 0xc6, 0x2b, 0xc2, 0xff, 0x23, 0x3c, 0xe2, 0x75,
+  0x0d, 0x91, 0xbf, 0xc1, 0xf5, 0x75, 0x63, 0x6a, 0x1c, 0xef, 0x79, 0x70, 0xf8, 0x88, 0x17, 0xbe,
+  0x64, 0x29, 0xe2, 0xfb, 0x2c, 0x20, 0xf2, 0x31, 0xb1, 0x8e, 0xba, 0xda, 0x92, 0xc9, 0x6c, 0xfa,
+  0x15, 0x84, 0x85, 0x24, 0x49, 0xd0, 0xef, 0x39, 0x06, 0xfd, 0x7d, 0x88, 0x56, 0xc7, 0xcd, 0x80,
+  0x80, 0x56, 0x4c, 0x0a, 0x76, 0x33, 0xde, 0x73, 0xba, 0x2c, 0x25, 0xc7, 0x39, 0x31, 0x7a, 0x49,
+  0x67, 0x6f, 0x72, 0x55, 0x1b, 0x05, 0x17, 0xe7, 0x59, 0x1a, 0xe6, 0xfd, 0x03, 0x50, 0x14, 0x3b,
+  0x11, 0x8a, 0xe2, 0x19, 0xe2, 0xe4, 0x64, 0x0b, 0x23, 0x17, 0xb7, 0xeb, 0x46, 0xb4, 0x8a, 0x91,
+  0x06, 0xb0, 0x1d, 0xcc, 0x74, 0x49, 0x26, 0x59, 0x8a, 0x51, 0x7e, 0x57, 0x30, 0x23, 0x2a, 0x37,
+  0x89, 0x8a, 0x5a, 0xe1, 0x82, 0xc1, 0xcc, 0xcf, 0x19, 0x68, 0x63, 0xe8, 0xc0, 0x43, 0x74, 0x4b,
+  0x0d, 0xdc, 0x2f, 0x0c, 0x8c, 0x41, 0xf1, 0x3b, 0xf8, 0x75, 0x36, 0x3b, 0x75, 0xae, 0xfa, 0xc9,
+  0x7f, 0xd7, 0xdc, 0xba, 0xb8, 0x33, 0x8a, 0xd0, 0x97, 0xe8, 0x8a, 0xab, 0x98, 0x7c, 0x9b, 0x5e,
+  0x91, 0x03, 0x20, 0x29, 0x81, 0x7d, 0x08, 0xf3, 0x0f, 0xc0, 0x99, 0x9a, 0xb7, 0x41, 0x96, 0xab,
+  0x1c, 0x27, 0x40, 0x9a, 0xc2, 0xd5, 0x82, 0x37, 0x68, 0xbe, 0x93, 0xa8, 0x9b, 0x5e, 0x72, 0xdb,
+  0x2c, 0x1a, 0xa0, 0x16, 0x28, 0x84, 0xfe, 0x02, 0xbf, 0xc5, 0x2d, 0x18, 0x3d, 0x3d, 0xb3, 0xb3,
+  0x0b, 0x7d, 0x77, 0xd9, 0xf8, 0x62, 0xbf, 0x68, 0x3c, 0xb9, 0x5c, 0xb3, 0x7a, 0x89, 0x61, 0x49,
+  0xc9, 0xdd, 0x54, 0x72, 0xff, 0x7a, 0xbc, 0xfa, 0x9e, 0xc7, 0x6b, 0x8d, 0x3a, 0x89, 0x50, 0x8a,
+  0x9b, 0xd3, 0xab, 0xb3, 0x19, 0x16, 0xe0, 0x67, 0x8d, 0x9a, 0x82, 0xda, 0x14, 0xc1, 0x84, 0x31,
+  0x4c, 0xd6, 0x39, 0xb7, 0x31, 0xb9, 0x38, 0x27, 0xc8, 0xf6, 0x5d, 0xd4, 0x8d, 0xac, 0x9d, 0xa4,
+  0xe9, 0xf1, 0x4c, 0x58, 0x97, 0x84, 0xa6, 0xc5, 0x24, 0x6c, 0x3a, 0xec, 0x40, 0x00, 0xdf, 0x89,
+  0xb3, 0x51, 0x77, 0x27, 0xd0, 0x87, 0x0d, 0xd2, 0x53, 0xc3, 0xba, 0xe9, 0x88, 0x6d, 0x95, 0x98,
+  0xfa, 0xc1, 0xa5, 0xae, 0x0d, 0xc3, 0x29, 0x69, 0x70, 0x79, 0xf2, 0xe1, 0x2d, 0xc1, 0x53, 0x0d,
+  0x45, 0xc1, 0xd8, 0x4d, 0xfb, 0xe2, 0x9d, 0x0d, 0xdb, 0x5a, 0x1f, 0x2f, 0x9b, 0x46, 0xc8, 0x46,
+  0xb2, 0xa2, 0x96, 0x12, 0xa4, 0x2e, 0xfd, 0xaa, 0x47, 0x35, 0x1d, 0xd0, 0x92, 0x0a, 0x85, 0x0b,
+  0xd4, 0x33, 0x33, 0x2b, 0x88, 0x0d, 0xef, 0x20, 0x8e, 0xe2, 0x0c, 0x75, 0xdb, 0x30, 0xc1, 0xb3,
+  0xa1, 0xe1, 0xea, 0x6b, 0xe4, 0x88, 0xbb, 0x11, 0xe7, 0x60, 0x8b, 0x1b, 0xf7, 0xe4, 0xb6, 0x04,
+  0xe6, 0x49, 0x4e, 0x1d, 0xf5, 0x95, 0x77, 0x76, 0x00, 0xad, 0x57, 0xf8, 0x2b, 0xa4, 0xff, 0x2d,
+  0x73, 0x7f, 0x0c, 0x21, 0x63, 0x48, 0x88, 0xe7, 0x4f, 0xbb, 0x35, 0x70, 0x67, 0x85, 0x93, 0x27,
+  0x0d, 0xdf, 0x9b, 0xbf, 0xbd, 0xaa, 0x2c, 0x6c, 0x77, 0x06, 0x00, 0x00,
+};
+
+#endif // INDEX_HTML_GZ_H
@@ -8,6 +8,18 @@
 #include <ESP8266WebServer.h>           // Library for creating a web server on the ESP8266
 #include <ArduinoJson.h>                // Library for parsing JSON data
 #include <time.h>                       // Library for time functions, used for NTP synchronization
+#include "index_html_gz.h"              // Gzipped control page generated by Tools/web-compiler
+#include "console_log.h"                // Fixed-size console log with sequence numbers
+#include "event_stream.h"               // Server-Sent Events streams of the open pages
+#include "perfect_hash.h"               // Compile-time lookup tables for MQTT topics
+#include "outbox_client.h"              // TLS client with a queue of outbound QoS1 publishes
+#include "connection_manager.h"         // WiFi, NTP, DNS, TLS and MQTT stages with backoff
+#include "dns_cache.h"                  // Background refresh of the broker and NTP names, with hit rates and resolve times
+#include "tls_session.h"                // TLS session resumption, with the handshake time of every connect
+#include "aws_certs.h"                  // Device certificate, key and root CA, parsed once at startup
+#if __has_include("aws_certs_der.h")
+#include "aws_certs_der.h"              // Certificates precompiled to DER by Tools/cert-compiler
+#endif
 
 // Blynk authentication token
 char auth[] = "YourBlynkAuthToken";     // Replace with your Blynk authentication token
@@ -19,8 +31,15 @@ char pass[] = "YourPassword";           // Replace with your WiFi password
 // AWS IoT Core parameters
 const char* awsEndpoint = "YourAWSEndpoint"; // Replace with your AWS IoT endpoint
 const int awsPort = 8883;
-const char* controlTopic = "ESP8266/control/led";
+const char* ntpServer1 = "pool.ntp.org"; // NTP servers, resolved through dnsCache like the endpoint
+const char* ntpServer2 = "time.nist.gov";
+constexpr const char* controlTopic = "ESP8266/control/led";
 const char* statusTopic = "ESP8266/status/led";
+constexpr const char* shadowDeltaTopic = "$aws/things/ESP8266-01/shadow/update/delta"; // Device Shadow delta topic, replace ESP8266-01 with your thing name
+const char* shadowUpdateTopic = "$aws/things/ESP8266-01/shadow/update"; // Device Shadow update topic, the reported state goes here
+const char* shadowGetTopic = "$aws/things/ESP8266-01/shadow/get"; // An empty message here asks for the full shadow document
+constexpr const char* shadowGetAcceptedTopic = "$aws/things/ESP8266-01/shadow/get/accepted"; // The full shadow document, with its current version
+constexpr const char* shadowDeleteAcceptedTopic = "$aws/things/ESP8266-01/shadow/delete/accepted"; // Sent when the shadow is deleted
 
 // Certificates and keys
 const char* awsCert = R"EOF(
@@ -42,206 +61,253 @@ YOUR_ROOT_CA_CONTENT_HERE
 )EOF";
 
 // Global variables
-BearSSL::WiFiClientSecure wifiClient;
+const size_t OUTBOX_CAPACITY = 8; // Messages waiting for the broker, queued or in flight
+const size_t OUTBOX_MAX_PAYLOAD = 128; // Longest payload that can be queued
+const uint8_t OUTBOX_WINDOW = 2; // QoS1 messages sent before waiting for their PUBACK
+const unsigned long PUBACK_TIMEOUT_MS = 5000; // Send again with DUP if the PUBACK takes longer
+const uint8_t PUBLISH_MAX_ATTEMPTS = 5; // Drop a message after this many sends
+OutboxClient<OUTBOX_CAPACITY, OUTBOX_MAX_PAYLOAD> wifiClient(OUTBOX_WINDOW, PUBACK_TIMEOUT_MS, PUBLISH_MAX_ATTEMPTS); // Secure WiFi client, queues the status messages
+TlsSession tlsSession; // Kept between connections so reconnects can skip the full handshake
+AwsCertificates awsCertificates; // Parsed once and kept for as long as the TLS client uses them
 PubSubClient mqttClient(wifiClient);
 ESP8266WebServer server(80);
+const char* cacheHeaders[] = { "If-None-Match" }; // Request headers the web server keeps for handleRoot()
+const int MAX_EVENT_CLIENTS = 5; // Open pages that can receive pushed updates at the same time
+const unsigned long EVENT_KEEPALIVE_MS = 15000; // Idle streams get a comment this often, so dead ones are noticed
+EventStream<MAX_EVENT_CLIENTS> events(EVENT_KEEPALIVE_MS); // Server-Sent Events streams of the open pages
+uint32_t consolePushed = 0; // Sequence number of the first console line not yet pushed to the event streams
+bool ledStatePushed = false; // LED state last pushed to the event streams
 const int ledPin = LED_BUILTIN;          // GPIO pin to control the built-in LED
 bool ledState = false;                   // Track the LED state
-String consoleLog = "";                  // Track the console log for the webpage
-
-void messageReceived(char* topic, byte* payload, unsigned int length) {
-  // Function to handle incoming MQTT messages
-  Serial.print("Message arrived [");
-  Serial.print(topic);
-  Serial.print("]: ");
-  String message;
-  for (unsigned int i = 0; i < length; i++) {
-    Serial.print((char)payload[i]);
-    message += (char)payload[i];
-  }
-  Serial.println();
-
-  // Add to console log
-  consoleLog += "Message arrived [" + String(topic) + "]: " + message + "<br>";
-
-  // Parse the JSON payload
+uint32_t shadowVersion = 0; // Version of the shadow the board last saw, older deltas are dropped
+bool shadowReportedLed = false; // LED state last reported to the shadow
+bool shadowResync = true; // Report the LED even if unchanged, set on every connect
+const size_t CONSOLE_LINES = 32;         // Lines kept for the web console, older ones are overwritten
+const size_t CONSOLE_LINE_LENGTH = 96;   // Longer lines are truncated
+ConsoleLog<CONSOLE_LINES, CONSOLE_LINE_LENGTH> consoleLog; // Track the console log for the webpage
+
+// DNS cache: the names are refreshed from loop(), so a reconnect finds the endpoint's address without a query
+const DnsName dnsNames[] = {
+  { "aws", awsEndpoint },
+  { "ntp1", ntpServer1 },
+  { "ntp2", ntpServer2 },
+};
+const size_t DNS_AWS = 0; // Index of awsEndpoint in dnsNames
+const unsigned long DNS_CHECK_INTERVAL_MS = 1000; // Each name is checked this often, an expired one is queried again
+DnsCache<sizeof(dnsNames) / sizeof(dnsNames[0])> dnsCache(dnsNames, DNS_CHECK_INTERVAL_MS);
+
+// Connection to AWS IoT, advanced from loop() by connection.service()
+ConnectionManager<decltype(wifiClient), decltype(dnsCache)> connection(
+  { ssid, pass, ntpServer1, ntpServer2, awsEndpoint, awsPort, "ESP8266Client", DNS_AWS }, wifiClient, mqttClient, dnsCache, tlsSession);
+
+void handleControlMessage(byte* payload, unsigned int length) {
+  // Function to handle a message on controlTopic
+  char line[CONSOLE_LINE_LENGTH]; // For the error message
+
+  // Parse the JSON payload in place: the strings in doc point into payload, so nothing is copied or allocated
   StaticJsonDocument<200> doc;
-  DeserializationError error = deserializeJson(doc, message);
+  DeserializationError error = deserializeJson(doc, (char*)payload, length);
 
   if (error) {
     Serial.print("deserializeJson() failed: ");
     Serial.println(error.f_str());
-    consoleLog += "deserializeJson() failed: " + String(error.f_str()) + "<br>";
+    snprintf(line, sizeof(line), "deserializeJson() failed: %s", error.c_str());
+    consoleLog.add(line);
     return;
   }
 
   const char* msg = doc["state"]["reported"]["message"];
 
   // Handle control message
-  if (String(topic) == controlTopic) {
-    if (String(msg) == "ON") {
+  if (msg != nullptr) {
+    if (strcmp(msg, "ON") == 0) {
       digitalWrite(ledPin, LOW); // LOW turns the LED on for the built-in LED
       ledState = true;
       Serial.println("LED turned ON via MQTT");
-      consoleLog += "LED turned ON via MQTT<br>";
+      consoleLog.add("LED turned ON via MQTT");
       StaticJsonDocument<200> doc;
       doc["state"]["reported"]["message"] = "ON";
-      char buffer[256];
-      size_t n = serializeJson(doc, buffer);
-      mqttClient.publish(statusTopic, buffer, n);
+      char buffer[OUTBOX_MAX_PAYLOAD];
+      serializeJson(doc, buffer);
+      wifiClient.queue(statusTopic, buffer, PRIORITY_ACK);
       Blynk.virtualWrite(V1, 1); // Sync with Blynk
-    } else if (String(msg) == "OFF") {
+    } else if (strcmp(msg, "OFF") == 0) {
       digitalWrite(ledPin, HIGH); // HIGH turns the LED off for the built-in LED
       ledState = false;
       Serial.println("LED turned OFF via MQTT");
-      consoleLog += "LED turned OFF via MQTT<br>";
+      consoleLog.add("LED turned OFF via MQTT");
       StaticJsonDocument<200> doc;
       doc["state"]["reported"]["message"] = "OFF";
-      char buffer[256];
-      size_t n = serializeJson(doc, buffer);
-      mqttClient.publish(statusTopic, buffer, n);
+      char buffer[OUTBOX_MAX_PAYLOAD];
+      serializeJson(doc, buffer);
+      wifiClient.queue(statusTopic, buffer, PRIORITY_ACK);
       Blynk.virtualWrite(V1, 0); // Sync with Blynk
     }
   }
 }
 
-void setupWiFi() {
-  // Function to connect to WiFi
-  delay(10);
-  Serial.println();
-  Serial.print("Connecting to ");
-  Serial.println(ssid);
+void handleShadowDelta(byte* payload, unsigned int length) {
+  // Function to apply a device shadow delta. It only holds the fields whose desired value differs
+  // from the reported one, and its version tells a late or repeated delta from a new one.
+  StaticJsonDocument<32> filter; // Keep version and state, skip the metadata
+  filter["version"] = true;
+  filter["state"] = true;
+  StaticJsonDocument<200> doc;
+  DeserializationError error = deserializeJson(doc, (char*)payload, length, DeserializationOption::Filter(filter));
+  if (error) {
+    Serial.print("Shadow delta not parsed: ");
+    Serial.println(error.c_str());
+    return;
+  }
+
+  uint32_t version = doc["version"];
+  if (version <= shadowVersion) {
+    Serial.println("Stale shadow delta dropped");
+    return;
+  }
+  shadowVersion = version;
 
-  WiFi.begin(ssid, pass);
+  const char* led = doc["state"]["led"];
+  if (led == nullptr || (strcmp(led, "ON") != 0 && strcmp(led, "OFF") != 0)) {
+    return; // No LED field, or a value that is neither ON nor OFF
+  }
+  bool on = strcmp(led, "ON") == 0;
+  digitalWrite(ledPin, on ? LOW : HIGH); // LOW turns the LED on for the built-in LED
+  ledState = on;
+  Serial.println(on ? "LED turned ON via shadow" : "LED turned OFF via shadow");
+  consoleLog.add(on ? "LED turned ON via shadow" : "LED turned OFF via shadow");
+  Blynk.virtualWrite(V1, on ? 1 : 0); // Sync with Blynk
+}
 
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(500);
-    Serial.print(".");
+void handleShadowDocument(byte* payload, unsigned int length) {
+  // Function to take the version of the full shadow document, requested on every connect. A shadow
+  // that was deleted and created again counts its versions from 1, so the version is taken even
+  // when it is lower than the last one seen.
+  StaticJsonDocument<16> filter; // Only the version, the state is reported again after a connect
+  filter["version"] = true;
+  StaticJsonDocument<32> doc;
+  DeserializationError error = deserializeJson(doc, (char*)payload, length, DeserializationOption::Filter(filter));
+  if (error) {
+    Serial.print("Shadow document not parsed: ");
+    Serial.println(error.c_str());
+    return;
   }
+  shadowVersion = doc["version"];
+}
 
-  Serial.println("");
-  Serial.println("WiFi connected");
-  Serial.print("IP address: ");
-  Serial.println(WiFi.localIP());
-  Serial.print("Access web interface via http://");
-  Serial.println(WiFi.localIP());
-
-  // Add to console log
-  consoleLog += "WiFi connected<br>";
-  consoleLog += "IP address: " + WiFi.localIP().toString() + "<br>";
-  consoleLog += "Access web interface via http://" + WiFi.localIP().toString() + "<br>";
+void handleShadowDeleted(byte* payload, unsigned int length) {
+  // Function to forget the shadow version when the shadow is deleted, the next one starts again
+  // from version 1. The state is reported again so the new shadow has it.
+  shadowVersion = 0;
+  shadowResync = true;
+  Serial.println("Shadow deleted, reporting the state again");
 }
 
-// Time synchronization function using NTP
-void NTPConnect() {
-  Serial.print("Setting time using SNTP");
-  configTime(0, 0, "pool.ntp.org", "time.nist.gov"); // Configure time using NTP servers
-  time_t now = time(nullptr);
-  while (now < 8 * 3600) { // Wait for time to be set
-    delay(500);
-    Serial.print(".");
-    now = time(nullptr);
+void reportShadow() {
+  // Function to report the LED to the device shadow when it changed, called from loop().
+  // After a connect the state is reported once, and the shadow answers with a delta if the desired state differs.
+  if (connection.state != CONN_READY || (!shadowResync && ledState == shadowReportedLed)) {
+    return;
+  }
+  wifiClient.queue(shadowUpdateTopic, ledState ? "{\"state\": {\"reported\": {\"led\": \"ON\"}}}" : "{\"state\": {\"reported\": {\"led\": \"OFF\"}}}", PRIORITY_REPORT);
+  shadowReportedLed = ledState;
+  shadowResync = false;
+}
+
+// MQTT topics the board handles, one row per topic. Every topic in the table is subscribed on
+// connect, and messageReceived() finds the row through topicRouter, built by the compiler.
+typedef void (*TopicHandler)(byte* payload, unsigned int length);
+struct TopicRoute {
+  const char* name; // MQTT topic
+  TopicHandler handler; // Function called with the payload of each message on the topic
+};
+constexpr TopicRoute topicRoutes[] = {
+  { controlTopic, handleControlMessage },
+  { shadowDeltaTopic, handleShadowDelta },
+  { shadowGetAcceptedTopic, handleShadowDocument },
+  { shadowDeleteAcceptedTopic, handleShadowDeleted },
+};
+constexpr PerfectHash<TopicRoute, sizeof(topicRoutes) / sizeof(topicRoutes[0])> topicRouter(topicRoutes);
+static_assert(topicRouter.valid(), "MQTT topics must be unique");
+
+void messageReceived(char* topic, byte* payload, unsigned int length) {
+  // Function to handle incoming MQTT messages
+  Serial.print("Message arrived [");
+  Serial.print(topic);
+  Serial.print("]: ");
+  Serial.write(payload, length);
+  Serial.println();
+
+  // Add to console log, before parsing changes the payload
+  char line[CONSOLE_LINE_LENGTH];
+  snprintf(line, sizeof(line), "Message arrived [%s]: %.*s", topic, (int)length, (const char*)payload);
+  consoleLog.add(line);
+
+  // One hash of the topic finds its handler, topics nobody subscribed to are dropped here
+  int route = topicRouter.find(topic);
+  if (route < 0) {
+    Serial.println("No handler for this topic");
+    return;
   }
-  Serial.println(" done!");
-  struct tm timeinfo;
-  localtime_r(&now, &timeinfo);
-  Serial.print("Current time: ");
-  Serial.print(asctime(&timeinfo));
+  topicRoutes[route].handler(payload, length);
+}
+
+void loadCertificates() {
+  // Function to parse the certificates and key once at startup
+  // The TLS client only keeps pointers to them, so they must outlive every connection
+#ifdef AWS_CERTS_DER_H
+  // DER from aws_certs_der.h, no base64 decoding
+  awsCertificates.loadDer(awsCertDer, sizeof(awsCertDer), awsPrivateKeyDer, sizeof(awsPrivateKeyDer),
+                          awsRootCADer, sizeof(awsRootCADer));
+#else
+  awsCertificates.loadPem(awsCert, awsPrivateKey, awsRootCA);
+#endif
+  awsCertificates.attach(wifiClient);
+}
+
+void logConnection(const String& message) {
+  // Function to log a connection event to the serial port and the web console
+  Serial.println(message);
+  consoleLog.add(message);
 }
 
-void connectAWS() {
-  // Function to connect to AWS IoT Core
-  // Convert the certificate strings to BearSSL types
-  BearSSL::X509List cert(awsCert);
-  BearSSL::PrivateKey key(awsPrivateKey);
-  BearSSL::X509List ca(awsRootCA);
-
-  // Set the certificates and key
-  wifiClient.setClientRSACert(&cert, &key);
-  wifiClient.setTrustAnchors(&ca);
-  
+void setupAWS() {
+  // Function to configure the MQTT client, connection.service() makes the actual connection
   mqttClient.setServer(awsEndpoint, awsPort);
   mqttClient.setCallback(messageReceived);
+  mqttClient.setBufferSize(512); // The shadow document carries metadata, more than the default 256 bytes
+}
 
-  while (!mqttClient.connected()) {
-    Serial.print("Connecting to AWS IoT...");
-    consoleLog += "Connecting to AWS IoT...<br>";
-
-    if (mqttClient.connect("ESP8266Client")) {
-      Serial.println("connected");
-      consoleLog += "Connected to AWS IoT<br>";
-      // Subscribe to the control topic
-      mqttClient.subscribe(controlTopic);
-    } else {
-      Serial.print("failed, rc=");
-      Serial.print(mqttClient.state());
-      Serial.println(" try again in 5 seconds");
-      consoleLog += "failed, rc=" + String(mqttClient.state()) + " try again in 5 seconds<br>";
-      delay(5000);
-    }
+void onAwsConnected() {
+  // Function to subscribe once the broker has accepted the connection, and ask for the shadow
+  for (const TopicRoute& route : topicRoutes) {
+    mqttClient.subscribe(route.name);
   }
+  shadowResync = true; // Deltas sent while offline were missed
+  shadowVersion = 0; // Until the shadow document says otherwise, the shadow may have been recreated meanwhile
+  wifiClient.queue(shadowGetTopic, "", PRIORITY_REPORT);
+}
+
+void setupWiFi() {
+  // Function to start the WiFi connection, connection.service() waits for it without blocking
+  Serial.println();
+  Serial.print("Connecting to ");
+  Serial.println(ssid);
+
+  connection.begin({ logConnection, onAwsConnected, nullptr });
 }
 
 void handleRoot() {
-  // Function to handle the root web page
-  String html = "<html><head><title>ESP8266 Control</title>";
-  html += "<style>body { font-family: monospace; text-align: center; background-color: #282c34; color: white; }";
-  html += "button { padding: 10px 20px; margin: 10px; font-size: 16px; cursor: pointer; background-color: #444; color: white; border: none; }";
-  html += "button.active { background-color: #888; }";
-  html += ".ascii-art { font-size: 12px; line-height: 1; }";
-  html += ".console { margin-top: 20px; padding: 10px; background-color: #333; border-radius: 10px; text-align: left; }";
-  html += "</style></head><body>";
-  html += "<h1>ESP8266 Control</h1>";
-  html += "<pre class='ascii-art'>    _  _\n";
-  html += "  _| || |_ \n";
-  html += " |_  __  _| \n";
-  html += "  _|| || |_ \n";
-  html += " |_  __  _| \n";
-  html += "   |_||_|   </pre>";
-  html += "<p id='status'>LED is " + String(ledState ? "ON" : "OFF") + "</p>";
-  html += "<button id='onButton' onclick=\"toggleLED('on')\">Turn ON</button>";
-  html += "<button id='offButton' onclick=\"toggleLED('off')\">Turn OFF</button>";
-  html += "<div class='console' id='consoleLog'>" + consoleLog + "</div>";
-  html += "<script>";
-  html += "function toggleLED(action) {";
-  html += "  var xhr = new XMLHttpRequest();";
-  html += "  xhr.open('GET', '/' + action, true);";
-  html += "  xhr.onreadystatechange = function () {";
-  html += "    if (xhr.readyState == 4 && xhr.status == 200) {";
-  html += "      updateStatus();";
-  html += "      updateConsole();";
-  html += "    }";
-  html += "  };";
-  html += "  xhr.send();";
-  html += "}";
-  html += "function updateStatus() {";
-  html += "  var xhr = new XMLHttpRequest();";
-  html += "  xhr.open('GET', '/status', true);";
-  html += "  xhr.onreadystatechange = function () {";
-  html += "    if (xhr.readyState == 4 && xhr.status == 200) {";
-  html += "      document.getElementById('status').innerHTML = xhr.responseText;";
-  html += "      var status = xhr.responseText.includes('ON');";
-  html += "      document.getElementById('onButton').classList.toggle('active', status);";
-  html += "      document.getElementById('offButton').classList.toggle('active', !status);";
-  html += "    }";
-  html += "  };";
-  html += "  xhr.send();";
-  html += "}";
-  html += "function updateConsole() {";
-  html += "  var xhr = new XMLHttpRequest();";
-  html += "  xhr.open('GET', '/console', true);";
-  html += "  xhr.onreadystatechange = function () {";
-  html += "    if (xhr.readyState == 4 && xhr.status == 200) {";
-  html += "      document.getElementById('consoleLog').innerHTML = xhr.responseText;";
-  html += "    }";
-  html += "  };";
-  html += "  xhr.send();";
-  html += "}";
-  html += "setInterval(updateStatus, 1000);"; // Update status every second
-  html += "setInterval(updateConsole, 1000);"; // Update console log every second
-  html += "</script>";
-  html += "</body></html>";
-  server.send(200, "text/html", html);
+  // Function to serve the control page, stored gzipped in flash by Tools/web-compiler.
+  // Nothing is built on the heap, and a browser that already has the page gets a 304.
+  server.sendHeader("ETag", INDEX_HTML_ETAG);
+  if (server.header("If-None-Match") == INDEX_HTML_ETAG) {
+    server.send(304); // The browser's copy is current
+  } else {
+    server.sendHeader("Cache-Control", "no-cache"); // Revalidate on every load so a reflashed page is picked up
+    server.sendHeader("Content-Encoding", "gzip");
+    server.send_P(200, "text/html", (const char*)indexHtmlGz, sizeof(indexHtmlGz));
+  }
 }
 
 void handleOn() {
@@ -249,12 +315,12 @@ void handleOn() {
   digitalWrite(ledPin, LOW); // LOW turns the LED on for the built-in LED
   ledState = true;
   Serial.println("LED turned ON");
-  consoleLog += "LED turned ON<br>";
+  consoleLog.add("LED turned ON");
   StaticJsonDocument<200> doc;
   doc["state"]["reported"]["message"] = "ON";
-  char buffer[256];
-  size_t n = serializeJson(doc, buffer);
-  mqttClient.publish(statusTopic, buffer, n);
+  char buffer[OUTBOX_MAX_PAYLOAD];
+  serializeJson(doc, buffer);
+  wifiClient.queue(statusTopic, buffer, PRIORITY_REPORT);
   Blynk.virtualWrite(V1, 1); // Sync with Blynk
   server.send(200, "text/plain", "LED is ON");
 }
@@ -264,24 +330,81 @@ void handleOff() {
   digitalWrite(ledPin, HIGH); // HIGH turns the LED off for the built-in LED
   ledState = false;
   Serial.println("LED turned OFF");
-  consoleLog += "LED turned OFF<br>";
+  consoleLog.add("LED turned OFF");
   StaticJsonDocument<200> doc;
   doc["state"]["reported"]["message"] = "OFF";
-  char buffer[256];
-  size_t n = serializeJson(doc, buffer);
-  mqttClient.publish(statusTopic, buffer, n);
+  char buffer[OUTBOX_MAX_PAYLOAD];
+  serializeJson(doc, buffer);
+  wifiClient.queue(statusTopic, buffer, PRIORITY_REPORT);
   Blynk.virtualWrite(V1, 0); // Sync with Blynk
   server.send(200, "text/plain", "LED is OFF");
 }
 
+String statusText() {
+  // Function to describe the LED state, for /status and the event streams
+  return "LED is " + String(ledState ? "ON" : "OFF");
+}
+
 void handleStatus() {
   // Function to handle status requests
-  server.send(200, "text/plain", "LED is " + String(ledState ? "ON" : "OFF"));
+  server.send(200, "text/plain", statusText());
 }
 
 void handleConsole() {
-  // Function to handle console log requests
-  server.send(200, "text/plain", consoleLog);
+  // Function to handle console log requests, /console?since=N only returns the lines numbered N and up.
+  // X-Console-Next tells the page which number to ask for next.
+  uint32_t since = server.hasArg("since") ? strtoul(server.arg("since").c_str(), nullptr, 10) : 0;
+  if (since > consoleLog.next()) {
+    since = 0; // The board restarted since the page last asked
+  }
+  String lines;
+  consoleLog.appendTo(lines, since, consoleLog.next());
+  server.sendHeader("X-Console-Next", String(consoleLog.next()));
+  server.send(200, "text/plain", lines);
+}
+
+void handleConnection() {
+  // Function to report the current connection stage
+  server.send(200, "text/plain", connection.stateName());
+}
+
+void handleDns() {
+  // Function to report the DNS cache: address, hit rate and resolve times of each name since boot
+  char json[1024];
+  if (dnsCache.writeSummary(json, sizeof(json)) == 0) {
+    server.send(500, "text/plain", "DNS summary too long");
+    return;
+  }
+  server.send(200, "application/json", json);
+}
+
+void handleOutbox() {
+  // Function to report the outbox counters
+  server.send(200, "application/json", wifiClient.countersJson());
+}
+
+void handleEvents() {
+  // Function to open an event stream for a page, or answer 503 if too many are open
+  // Bring the page up to date, afterwards it only receives changes
+  String lines;
+  consoleLog.appendTo(lines, 0, consolePushed); // Later lines follow with the next push
+  events.open(server, events.format("status", statusText()) + events.format("console", lines));
+}
+
+void pushEvents() {
+  // Function to push state changes and new console lines to the open pages, called from loop().
+  // Nothing is sent while nothing changes, however many pages are open.
+  if (ledState != ledStatePushed) {
+    ledStatePushed = ledState;
+    events.broadcast("status", statusText());
+  }
+  if (consoleLog.next() != consolePushed) {
+    String lines;
+    consoleLog.appendTo(lines, consolePushed, consoleLog.next());
+    events.broadcast("console", lines);
+    consolePushed = consoleLog.next();
+  }
+  events.service(millis()); // Keepalive comment on idle streams
 }
 
 void setup() {
@@ -292,16 +415,13 @@ void setup() {
   pinMode(ledPin, OUTPUT);
   digitalWrite(ledPin, HIGH); // Initialize LED as off
 
-  // Initialize WiFi and connect to Blynk
+  // Start WiFi, Blynk connects from Blynk.run() once WiFi is up
   setupWiFi();
-  Blynk.begin(auth, ssid, pass);
-  Serial.println("Connected to Blynk");
+  Blynk.config(auth); // Blynk.begin() would block until WiFi and Blynk are connected
 
-  // Synchronize time using NTP
-  NTPConnect();
-
-  // Connect to AWS IoT
-  connectAWS();
+  // Prepare AWS IoT, the connection is made from loop()
+  loadCertificates(); // Parse the certificates once, they are reused by every reconnect
+  setupAWS();
 
   // Initialize web server
   server.on("/", handleRoot);
@@ -309,14 +429,26 @@ void setup() {
   server.on("/off", handleOff);
   server.on("/status", handleStatus);
   server.on("/console", handleConsole);
+  server.on("/connection", handleConnection);
+  server.on("/dns", handleDns);
+  server.on("/outbox", handleOutbox);
+  server.on("/events", handleEvents);
+  server.collectHeaders(cacheHeaders, 1); // Keep If-None-Match so handleRoot() can answer 304
   server.begin();
 }
 
 void loop() {
   // Main loop to run Blynk and MQTT client
+  connection.service(); // Advance or maintain the connection to AWS IoT
+  dnsCache.service(millis(), WiFi.status() == WL_CONNECTED); // Query the names that have expired, without waiting
   Blynk.run();
   mqttClient.loop();
+  reportShadow(); // Queue a shadow report if the LED changed
+  if (connection.state == CONN_READY) {
+    wifiClient.service(); // Publish queued status messages
+  }
   server.handleClient();
+  pushEvents(); // Push changes to the open pages
 }
 
 // Blynk function to control the LED
@@ -330,17 +462,23 @@ BLYNK_WRITE(V1) {
     Serial.println("LED turned ON via Blynk");
     StaticJsonDocument<200> doc;
     doc["state"]["reported"]["message"] = "ON";
-    char buffer[256];
-    size_t n = serializeJson(doc, buffer);
-    mqttClient.publish(statusTopic, buffer, n);
+    char buffer[OUTBOX_MAX_PAYLOAD];
+    serializeJson(doc, buffer);
+    wifiClient.queue(statusTopic, buffer, PRIORITY_REPORT);
   } else {
     digitalWrite(ledPin, HIGH); // Turn the LED off
     ledState = false;
     Serial.println("LED turned OFF via Blynk");
     StaticJsonDocument<200> doc;
     doc["state"]["reported"]["message"] = "OFF";
-    char buffer[256];
-    size_t n = serializeJson(doc, buffer);
-    mqttClient.publish(statusTopic, buffer, n);
+    char buffer[OUTBOX_MAX_PAYLOAD];
+    serializeJson(doc, buffer);
+    wifiClient.queue(statusTopic, buffer, PRIORITY_REPORT);
   }
 }
+
+// Blynk function called on every connect to the Blynk server. Writes made while it was offline
+// were dropped, so the widget gets the current LED state.
+BLYNK_CONNECTED() {
+  Blynk.virtualWrite(V1, ledState ? 1 : 0);
+}
@@ -0,0 +1,81 @@
+// index_html_gz.h
+// Generated by Tools/web-compiler from web/index.html. Do not edit, regenerate it instead.
+#ifndef INDEX_HTML_GZ_H
+#define INDEX_HTML_GZ_H
+
+#include <pgmspace.h>
+
+// 3560 bytes of HTML, 2754 minified, 1087 gzipped
+#define INDEX_HTML_ETAG "\"df7c59b2\""
+const uint8_t indexHtmlGz[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xb5, 0x56, 0x6d, 0x6f, 0xdb, 0x36,
+  0x10, 0xfe, 0xae, 0x5f, 0x71, 0x75, 0x81, 0x52, 0x46, 0xe2, 0x97, 0x3a, 0x59, 0x10, 0xd8, 0xb2,
+  0x0b, 0x34, 0x68, 0x96, 0x0c, 0x69, 0x32, 0x24, 0xf9, 0x50, 0x60, 0x1d, 0x02, 0x59, 0xa2, 0x25,
+  0x22, 0x32, 0xa9, 0x92, 0x54, 0x62, 0xaf, 0xc9, 0x7f, 0xdf, 0x9d, 0x48, 0x3b, 0xb6, 0x63, 0x77,
+  0x58, 0x81, 0x1a, 0xb2, 0x65, 0x1e, 0x8f, 0xcf, 0xdd, 0x3d, 0xcf, 0x91, 0x52, 0x94, 0xdb, 0x69,
+  0x31, 0x0a, 0xa2, 0x9c, 0xc7, 0x29, 0xde, 0xac, 0xb0, 0x05, 0x1f, 0x7d, 0xba, 0xf9, 0xf3, 0xb8,
+  0x77, 0x74, 0x04, 0x27, 0x4a, 0x5a, 0xad, 0x8a, 0xa8, 0xe3, 0xcc, 0x41, 0x64, 0xec, 0x9c, 0xee,
+  0x63, 0x95, 0xce, 0xe1, 0x3b, 0x4c, 0x70, 0xba, 0x35, 0x89, 0xa7, 0xa2, 0x98, 0xf7, 0x61, 0xaa,
+  0xa4, 0x32, 0x65, 0x9c, 0xf0, 0x01, 0x58, 0x3e, 0xb3, 0xad, 0xb8, 0x10, 0x99, 0xec, 0x43, 0xc2,
+  0xa5, 0xe5, 0x7a, 0x00, 0xe3, 0x38, 0xb9, 0xcf, 0xb4, 0xaa, 0x64, 0xda, 0x4a, 0x54, 0xa1, 0x74,
+  0x1f, 0xde, 0xf6, 0x8e, 0x7b, 0xc9, 0xc1, 0xe1, 0x00, 0xfc, 0xf8, 0x31, 0x17, 0x16, 0x17, 0x3f,
+  0x07, 0x6d, 0xcd, 0x8b, 0x78, 0xde, 0x1a, 0xab, 0x19, 0xc6, 0x18, 0x2b, 0x9d, 0x72, 0x9c, 0xed,
+  0x95, 0x33, 0x30, 0xaa, 0x10, 0x29, 0xbc, 0x3d, 0x3c, 0xc4, 0x45, 0xce, 0xde, 0xd2, 0x71, 0x2a,
+  0x2a, 0xd3, 0x87, 0xf7, 0xdd, 0x72, 0x36, 0x80, 0x32, 0x4e, 0x53, 0x21, 0x33, 0xf4, 0xae, 0x87,
+  0xd3, 0x58, 0x67, 0x42, 0x2e, 0x46, 0xa9, 0x30, 0x25, 0xe2, 0xf6, 0x41, 0xc8, 0x42, 0x48, 0xde,
+  0x1a, 0x17, 0x2a, 0xb9, 0xa7, 0x78, 0xe3, 0xca, 0x5a, 0x25, 0x31, 0xd6, 0x72, 0x39, 0xa1, 0x6d,
+  0x60, 0xb8, 0x00, 0x75, 0xc5, 0x46, 0xfc, 0xc3, 0xd1, 0x70, 0x44, 0x86, 0xa4, 0xd2, 0x86, 0x92,
+  0x2f, 0x95, 0xd8, 0x59, 0x67, 0x9d, 0xef, 0x7a, 0x91, 0x8b, 0xaa, 0xa4, 0x92, 0xfc, 0x55, 0x2d,
+  0xbf, 0x11, 0xf0, 0x22, 0xad, 0x76, 0x9c, 0x58, 0xf1, 0xc0, 0x89, 0x89, 0xd7, 0xc8, 0xc7, 0xc7,
+  0xc7, 0x35, 0x61, 0xb1, 0x49, 0x84, 0x68, 0xc5, 0xda, 0x2e, 0x44, 0xf1, 0x29, 0xf6, 0x08, 0xa9,
+  0x2e, 0x36, 0xe7, 0x22, 0xcb, 0x2d, 0x9a, 0x6a, 0xff, 0x44, 0x49, 0xe4, 0x92, 0x40, 0x5d, 0x79,
+  0x2d, 0xab, 0xca, 0x05, 0x4d, 0x6b, 0x24, 0x6c, 0xad, 0xe7, 0xe0, 0xe0, 0x60, 0x07, 0xff, 0xab,
+  0xc2, 0x17, 0x7c, 0x62, 0x29, 0x58, 0xd4, 0xf1, 0x4d, 0x13, 0x75, 0x7c, 0x8f, 0x51, 0xf7, 0x50,
+  0xc7, 0xbd, 0x7f, 0xdd, 0x67, 0x68, 0x0b, 0xa2, 0x52, 0x73, 0x48, 0x8a, 0xd8, 0x98, 0x21, 0x5b,
+  0x16, 0xc6, 0x46, 0x80, 0x9f, 0x3b, 0xbc, 0x02, 0xfc, 0x3e, 0xc1, 0x13, 0x5e, 0x77, 0x10, 0xd0,
+  0x0f, 0xdc, 0xdd, 0xd5, 0xa6, 0x7a, 0x62, 0xd7, 0x0c, 0x0e, 0x9f, 0xf0, 0xc2, 0x3f, 0x51, 0x07,
+  0xf1, 0x31, 0x4a, 0x2a, 0x1e, 0x40, 0xa4, 0x43, 0x56, 0x37, 0x9b, 0x61, 0xa3, 0xa8, 0x83, 0x16,
+  0x6f, 0xf7, 0xd1, 0x3d, 0x4d, 0xac, 0xf6, 0xf3, 0x83, 0x0b, 0x95, 0xbd, 0xf8, 0x9a, 0x44, 0x8b,
+  0xd2, 0x8e, 0x82, 0x49, 0x25, 0x51, 0x25, 0xec, 0x21, 0xab, 0xb2, 0xac, 0xe0, 0xd7, 0x04, 0x19,
+  0xd6, 0xc0, 0xfb, 0x10, 0xd7, 0x33, 0x4d, 0xf8, 0x1e, 0x3c, 0xc4, 0x1a, 0x66, 0xb9, 0x86, 0x21,
+  0x48, 0xfe, 0x08, 0x5f, 0x3e, 0x5f, 0x9c, 0x59, 0x5b, 0x5e, 0xf3, 0x6f, 0x15, 0x37, 0x36, 0x6c,
+  0x0e, 0x02, 0x9c, 0x6b, 0xab, 0x92, 0xcb, 0x90, 0xfd, 0xfe, 0xe9, 0x96, 0xed, 0x03, 0xeb, 0x30,
+  0xd8, 0x83, 0x1a, 0x06, 0xef, 0x6e, 0xe4, 0xd0, 0xf6, 0xc1, 0xea, 0x8a, 0x2f, 0x96, 0x48, 0x8d,
+  0xbc, 0xce, 0x8d, 0x8d, 0x2d, 0x4f, 0xf2, 0x58, 0x66, 0x1c, 0x23, 0x2c, 0x33, 0x0a, 0x29, 0xb2,
+  0x98, 0x40, 0x48, 0xae, 0xb5, 0xe3, 0x0d, 0x39, 0xc2, 0x70, 0x08, 0x87, 0xf0, 0xee, 0x1d, 0x25,
+  0xd4, 0xa6, 0xa5, 0x95, 0x21, 0x53, 0xaf, 0xdb, 0x25, 0xff, 0xaa, 0x4c, 0xd1, 0xe7, 0xa6, 0x36,
+  0x53, 0x66, 0x6e, 0x7c, 0xe2, 0x18, 0x20, 0xc3, 0x73, 0xf0, 0xec, 0x82, 0x1b, 0x2e, 0x53, 0x67,
+  0x58, 0x46, 0xac, 0x13, 0xfe, 0xa8, 0x66, 0x8e, 0x80, 0x45, 0xe1, 0xb4, 0x9b, 0x87, 0x90, 0xaa,
+  0xa4, 0x9a, 0xe2, 0x89, 0xd0, 0xce, 0xb8, 0xfd, 0x54, 0x70, 0xfa, 0xfb, 0x71, 0x7e, 0x9e, 0x7a,
+  0xd7, 0x41, 0x9d, 0xe8, 0x1b, 0x74, 0xa5, 0x55, 0x1b, 0x2b, 0x12, 0x4c, 0xde, 0x72, 0xbf, 0x28,
+  0x64, 0x28, 0x00, 0xc3, 0x05, 0xe8, 0xd4, 0xc6, 0x33, 0x61, 0xe8, 0xa2, 0xba, 0x71, 0xad, 0xde,
+  0x65, 0x3c, 0x25, 0x1e, 0xd8, 0xf2, 0x2c, 0x61, 0xde, 0x59, 0x4a, 0xae, 0xcf, 0x6e, 0x3f, 0x5f,
+  0xe0, 0x64, 0x23, 0x2a, 0x51, 0xca, 0x72, 0xd4, 0x80, 0xbd, 0xa0, 0x11, 0xf9, 0x63, 0xc0, 0x6b,
+  0xaf, 0x24, 0x03, 0x25, 0x93, 0x42, 0x24, 0xf7, 0xc3, 0xaf, 0x8d, 0x55, 0x5d, 0x59, 0x63, 0x45,
+  0x95, 0x06, 0xe9, 0x84, 0xbe, 0xcd, 0xaf, 0x8d, 0xd1, 0x6d, 0xa5, 0x25, 0x5c, 0x5d, 0xc2, 0xda,
+  0x7c, 0xd4, 0x71, 0xb8, 0xdb, 0x83, 0x4c, 0x26, 0xff, 0x23, 0x0a, 0x3a, 0xbf, 0x84, 0x39, 0x3d,
+  0xdd, 0x15, 0x67, 0x10, 0xec, 0x62, 0x79, 0xd1, 0xeb, 0xcd, 0x76, 0x5c, 0x62, 0x9f, 0xa5, 0x27,
+  0xb9, 0x28, 0xd2, 0x90, 0xe8, 0x26, 0x01, 0x35, 0xb7, 0x84, 0x8c, 0xc3, 0x35, 0x39, 0x4d, 0xae,
+  0x1e, 0x7d, 0x27, 0xb8, 0x3e, 0x21, 0x6d, 0x26, 0x4a, 0x43, 0x48, 0xb2, 0xba, 0xf8, 0x02, 0xdd,
+  0x96, 0x73, 0x2f, 0x6a, 0x6f, 0x74, 0x82, 0x13, 0x00, 0xdb, 0x5d, 0xcf, 0x6f, 0x78, 0xc1, 0x13,
+  0xab, 0x74, 0xc8, 0x4a, 0xcc, 0x66, 0x55, 0x93, 0x65, 0xbb, 0x83, 0x30, 0x40, 0x1d, 0xef, 0xa3,
+  0xfe, 0x55, 0x4f, 0xfc, 0x0d, 0x1f, 0x80, 0x5d, 0x5d, 0x32, 0xe8, 0xe3, 0xed, 0xf4, 0x94, 0x6d,
+  0xc7, 0x6c, 0x93, 0x20, 0xae, 0x0d, 0x2e, 0x84, 0xb1, 0x6d, 0xc7, 0x6b, 0xc8, 0xdc, 0x51, 0x8a,
+  0x5c, 0xae, 0x41, 0xee, 0xc2, 0x20, 0xba, 0x7f, 0x04, 0xf2, 0x66, 0x13, 0xe5, 0x79, 0x95, 0xb6,
+  0xf5, 0x2d, 0xf4, 0x53, 0xbb, 0xdf, 0xe1, 0xb3, 0x5f, 0xbd, 0xd9, 0x57, 0x04, 0xfe, 0xe3, 0xe6,
+  0xea, 0xb2, 0x5d, 0xc6, 0xda, 0x70, 0x8f, 0x60, 0x4a, 0xdc, 0xf3, 0xfc, 0x16, 0x8f, 0xf5, 0xe6,
+  0xf6, 0x5d, 0x4f, 0x55, 0xf9, 0x93, 0xf1, 0x12, 0xbd, 0x30, 0x99, 0xee, 0x60, 0x93, 0x84, 0xe5,
+  0xb9, 0xf1, 0x53, 0x2c, 0x78, 0xf4, 0x0f, 0x46, 0xc8, 0x84, 0x0f, 0xa9, 0x23, 0x56, 0xe2, 0xfd,
+  0x6a, 0x6e, 0x28, 0x5d, 0xe9, 0xea, 0xaa, 0x69, 0x39, 0xc7, 0xa3, 0x87, 0x1c, 0x71, 0x63, 0x5d,
+  0x7b, 0x72, 0xce, 0x10, 0x8a, 0x63, 0xc3, 0x7c, 0x69, 0xf9, 0x3a, 0x5b, 0x94, 0x18, 0x6b, 0xee,
+  0xe3, 0x33, 0x11, 0x13, 0x23, 0x84, 0x42, 0x65, 0x3f, 0x38, 0xfb, 0x56, 0x9f, 0x2c, 0xfe, 0x08,
+  0xac, 0x43, 0x46, 0xab, 0x85, 0x52, 0x32, 0x08, 0xb3, 0xb6, 0x55, 0x18, 0x1b, 0x40, 0xa7, 0x03,
+  0xb7, 0x39, 0xc7, 0xfd, 0x16, 0xeb, 0x14, 0xf7, 0x0e, 0x16, 0xa0, 0x2d, 0x4f, 0x91, 0x16, 0x34,
+  0x2e, 0xe4, 0x83, 0x5c, 0x15, 0xa9, 0x01, 0x61, 0x0d, 0xbe, 0x7e, 0xd0, 0x63, 0x1f, 0x81, 0x50,
+  0xba, 0x75, 0xb8, 0xbd, 0x21, 0x6c, 0x4a, 0x3e, 0x08, 0xd6, 0x95, 0x95, 0xb5, 0x6d, 0x4b, 0x13,
+  0xfc, 0xe7, 0xe3, 0xc2, 0x70, 0x7b, 0x4e, 0xaf, 0x47, 0x0f, 0x71, 0x11, 0xae, 0x3a, 0x13, 0x47,
+  0xdd, 0xee, 0x56, 0x07, 0xbf, 0x7a, 0xe9, 0x81, 0xaf, 0x11, 0xfe, 0x61, 0x8b, 0x27, 0x9d, 0x7b,
+  0x81, 0xe8, 0xb8, 0x57, 0xd7, 0x7f, 0x01, 0xc4, 0x58, 0xba, 0x7b, 0xc2, 0x0a, 0x00, 0x00,
+};
+
+#endif // INDEX_HTML_GZ_H
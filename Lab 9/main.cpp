@@ -1,154 +1,126 @@
 #include <ESP8266WiFi.h>      // Library for managing WiFi connections on the ESP8266
 #include <ESP8266WebServer.h> // Library for creating a web server on the ESP8266
+#include <uri/UriBraces.h>    // Route patterns with a {} placeholder, used for the relay routes
+#include "index_html_gz.h"    // Gzipped control page generated by Tools/web-compiler
+#include "console_log.h"      // Fixed-size console log with sequence numbers
+#include "perfect_hash.h"     // Compile-time lookup table for the relay names
 
 // WiFi credentials
 char ssid[] = "YourSSID";      // Replace with your WiFi SSID
 char pass[] = "YourPassword";  // Replace with your WiFi password
 
-// Relay pins
-const int relay1Pin = D6;      // GPIO pin for relay 1
-const int relay2Pin = D7;      // GPIO pin for relay 2
+// Relay table, one row per channel. Adding a row is all it takes to add a relay:
+// the web routes, /status and the page are all driven by this table.
+struct Relay {
+  uint8_t pin;                 // GPIO pin the relay is wired to
+  uint8_t activeLevel;         // Level that turns the relay on, LOW for the usual active-low modules
+  const char* name;            // Name used in the URL and in /status
+};
+constexpr Relay relays[] = {
+  { D6, LOW, "relay1" },
+  { D7, LOW, "relay2" },
+};
+const uint8_t RELAY_COUNT = sizeof(relays) / sizeof(relays[0]);
+static_assert(RELAY_COUNT <= 16, "relayStates has one bit per relay");
+constexpr PerfectHash<Relay, RELAY_COUNT> relayIndex(relays); // Finds a relay by name without comparing against every row
+static_assert(relayIndex.valid(), "relay names must be unique");
 
 // Relay states
-bool relay1State = false;      // State of relay 1 (false = off, true = on)
-bool relay2State = false;      // State of relay 2 (false = off, true = on)
+uint16_t relayStates = 0;      // Bit i is set while relay i is on
 
 // Web server
 ESP8266WebServer server(80);
-String consoleLog = "";        // Log for tracking web interface actions
+const char* cacheHeaders[] = { "If-None-Match" }; // Request headers the web server keeps for handleRoot()
+const size_t CONSOLE_LINES = 32;       // Lines kept for the web console, older ones are overwritten
+const size_t CONSOLE_LINE_LENGTH = 96; // Longer lines are truncated
+ConsoleLog<CONSOLE_LINES, CONSOLE_LINE_LENGTH> consoleLog; // Log for tracking web interface actions
 
-// Handle the root web page
+// Function to serve the control page, stored gzipped in flash by Tools/web-compiler.
+// Nothing is built on the heap, and a browser that already has the page gets a 304.
 void handleRoot() {
-  String html = "<html><head><title>ESP8266 Control</title>";
-  html += "<style>";
-  html += "body { font-family: monospace; text-align: center; background-color: #282c34; color: white; }";
-  html += ".relay-box { border: 2px solid #444; border-radius: 10px; padding: 20px; margin: 20px; display: inline-block; }";
-  html += "button { padding: 10px 20px; margin: 10px; font-size: 16px; cursor: pointer; background-color: #444; color: white; border: none; border-radius: 5px; }";
-  html += "button.active { background-color: #888; }";
-  html += ".ascii-art { font-size: 12px; line-height: 1; }";
-  html += ".console { margin-top: 20px; padding: 10px; background-color: #333; border-radius: 10px; text-align: left; }";
-  html += "</style></head><body>";
-  html += "<h1>ESP8266 Control</h1>";
-  html += "<pre class='ascii-art'>    _  _\n";
-  html += "  _| || |_ \n";
-  html += " |_  __  _| \n";
-  html += "  _|| || |_ \n";
-  html += " |_  __  _| \n";
-  html += "   |_||_|   </pre>";
-
-  // Relay 1 control
-  html += "<div class='relay-box'>";
-  html += "<p id='relay1Status'>Relay 1 is " + String(relay1State ? "ON" : "OFF") + "</p>";
-  html += "<button id='onButton1' onclick=\"toggleRelay('relay1', 'on')\">Turn ON Relay 1</button>";
-  html += "<button id='offButton1' onclick=\"toggleRelay('relay1', 'off')\">Turn OFF Relay 1</button>";
-  html += "</div>";
-
-  // Relay 2 control
-  html += "<div class='relay-box'>";
-  html += "<p id='relay2Status'>Relay 2 is " + String(relay2State ? "ON" : "OFF") + "</p>";
-  html += "<button id='onButton2' onclick=\"toggleRelay('relay2', 'on')\">Turn ON Relay 2</button>";
-  html += "<button id='offButton2' onclick=\"toggleRelay('relay2', 'off')\">Turn OFF Relay 2</button>";
-  html += "</div>";
-
-  html += "<div class='console' id='consoleLog'>" + consoleLog + "</div>";
-  html += "<script>";
-  html += "function toggleRelay(relay, action) {";
-  html += "  var xhr = new XMLHttpRequest();";
-  html += "  xhr.open('GET', '/' + relay + '/' + action, true);";
-  html += "  xhr.onreadystatechange = function () {";
-  html += "    if (xhr.readyState == 4 && xhr.status == 200) {";
-  html += "      updateStatus(relay, action);";
-  html += "      updateConsole();";
-  html += "    }";
-  html += "  };";
-  html += "  xhr.send();";
-  html += "}";
-  html += "function updateStatus(relay, action) {";
-  html += "  if (relay === 'relay1') {";
-  html += "    document.getElementById('relay1Status').innerHTML = 'Relay 1 is ' + (action === 'on' ? 'ON' : 'OFF');";
-  html += "    document.getElementById('onButton1').classList.toggle('active', action === 'on');";
-  html += "    document.getElementById('offButton1').classList.toggle('active', action === 'off');";
-  html += "  } else if (relay === 'relay2') {";
-  html += "    document.getElementById('relay2Status').innerHTML = 'Relay 2 is ' + (action === 'on' ? 'ON' : 'OFF');";
-  html += "    document.getElementById('onButton2').classList.toggle('active', action === 'on');";
-  html += "    document.getElementById('offButton2').classList.toggle('active', action === 'off');";
-  html += "  }";
-  html += "}";
-  html += "function updateConsole() {";
-  html += "  var xhr = new XMLHttpRequest();";
-  html += "  xhr.open('GET', '/console', true);";
-  html += "  xhr.onreadystatechange = function () {";
-  html += "    if (xhr.readyState == 4 && xhr.status == 200) {";
-  html += "      document.getElementById('consoleLog').innerHTML = xhr.responseText;";
-  html += "    }";
-  html += "  };";
-  html += "  xhr.send();";
-  html += "}";
-  html += "setInterval(function() { updateStatus('relay1', relay1State ? 'on' : 'off'); }, 1000);";
-  html += "setInterval(function() { updateStatus('relay2', relay2State ? 'on' : 'off'); }, 1000);";
-  html += "setInterval(updateConsole, 1000);"; // Update console log every second
-  html += "</script>";
-  html += "</body></html>";
-  server.send(200, "text/html", html);
+  server.sendHeader("ETag", INDEX_HTML_ETAG);
+  if (server.header("If-None-Match") == INDEX_HTML_ETAG) {
+    server.send(304); // The browser's copy is current
+  } else {
+    server.sendHeader("Cache-Control", "no-cache"); // Revalidate on every load so a reflashed page is picked up
+    server.sendHeader("Content-Encoding", "gzip");
+    server.send_P(200, "text/html", (const char*)indexHtmlGz, sizeof(indexHtmlGz));
+  }
+}
+
+// Check whether a relay is on
+bool relayOn(uint8_t index) {
+  return relayStates & (1u << index);
 }
 
-// Handle turning relay 1 on
-void handleRelay1On() {
-  digitalWrite(relay1Pin, LOW); // LOW turns the relay on
-  relay1State = true;
-  Serial.println("Relay 1 turned ON");
-  consoleLog += "Relay 1 turned ON<br>";
-  server.send(200, "text/plain", "Relay 1 is ON");
+// Switch a relay and record its state
+void setRelay(uint8_t index, bool on) {
+  digitalWrite(relays[index].pin, on ? relays[index].activeLevel : !relays[index].activeLevel);
+  if (on) {
+    relayStates |= 1u << index;
+  } else {
+    relayStates &= ~(1u << index);
+  }
+  String message = String(relays[index].name) + " turned " + (on ? "ON" : "OFF");
+  Serial.println(message);
+  consoleLog.add(message);
 }
 
-// Handle turning relay 1 off
-void handleRelay1Off() {
-  digitalWrite(relay1Pin, HIGH); // HIGH turns the relay off
-  relay1State = false;
-  Serial.println("Relay 1 turned OFF");
-  consoleLog += "Relay 1 turned OFF<br>";
-  server.send(200, "text/plain", "Relay 1 is OFF");
+// Handle /<relay>/on and /<relay>/off for every relay in the table
+void handleRelay(bool on) {
+  int index = relayIndex.find(server.pathArg(0).c_str());
+  if (index < 0) {
+    server.send(404, "text/plain", "No such relay");
+    return;
+  }
+  setRelay(index, on);
+  server.send(200, "text/plain", String(relays[index].name) + " is " + (on ? "ON" : "OFF"));
 }
 
-// Handle turning relay 2 on
-void handleRelay2On() {
-  digitalWrite(relay2Pin, LOW); // LOW turns the relay on
-  relay2State = true;
-  Serial.println("Relay 2 turned ON");
-  consoleLog += "Relay 2 turned ON<br>";
-  server.send(200, "text/plain", "Relay 2 is ON");
+// Handle turning a relay on
+void handleRelayOn() {
+  handleRelay(true);
 }
 
-// Handle turning relay 2 off
-void handleRelay2Off() {
-  digitalWrite(relay2Pin, HIGH); // HIGH turns the relay off
-  relay2State = false;
-  Serial.println("Relay 2 turned OFF");
-  consoleLog += "Relay 2 turned OFF<br>";
-  server.send(200, "text/plain", "Relay 2 is OFF");
+// Handle turning a relay off
+void handleRelayOff() {
+  handleRelay(false);
 }
 
 // Handle status request
 void handleStatus() {
-  String status = "Relay 1 is " + String(relay1State ? "ON" : "OFF") + "<br>";
-  status += "Relay 2 is " + String(relay2State ? "ON" : "OFF");
-  server.send(200, "text/html", status);
+  String json = "{";
+  for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+    json += i == 0 ? "\"" : ", \"";
+    json += relays[i].name;
+    json += relayOn(i) ? "\": true" : "\": false";
+  }
+  json += "}";
+  server.send(200, "application/json", json);
 }
 
-// Handle console log request
+// Handle console log request, /console?since=N only returns the lines numbered N and up.
+// X-Console-Next tells the page which number to ask for next.
 void handleConsole() {
-  server.send(200, "text/plain", consoleLog);
+  uint32_t since = server.hasArg("since") ? strtoul(server.arg("since").c_str(), nullptr, 10) : 0;
+  if (since > consoleLog.next()) {
+    since = 0; // The board restarted since the page last asked
+  }
+  String lines;
+  consoleLog.appendTo(lines, since, consoleLog.next());
+  server.sendHeader("X-Console-Next", String(consoleLog.next()));
+  server.send(200, "text/plain", lines);
 }
 
 void setup() {
   // Initialize serial communication
   Serial.begin(115200);
 
-  // Initialize the relay pins
-  pinMode(relay1Pin, OUTPUT);
-  digitalWrite(relay1Pin, HIGH); // Initialize relay 1 as off
-  pinMode(relay2Pin, OUTPUT);
-  digitalWrite(relay2Pin, HIGH); // Initialize relay 2 as off
+  // Initialize the relay pins, all relays start off
+  for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+    pinMode(relays[i].pin, OUTPUT);
+    digitalWrite(relays[i].pin, !relays[i].activeLevel);
+  }
 
   // Initialize WiFi
   WiFi.begin(ssid, pass);
@@ -163,12 +135,11 @@ void setup() {
 
   // Initialize web server
   server.on("/", handleRoot);
-  server.on("/relay1/on", handleRelay1On);
-  server.on("/relay1/off", handleRelay1Off);
-  server.on("/relay2/on", handleRelay2On);
-  server.on("/relay2/off", handleRelay2Off);
   server.on("/status", handleStatus);
   server.on("/console", handleConsole);
+  server.on(UriBraces("/{}/on"), handleRelayOn); // After the fixed routes, {} is the relay name
+  server.on(UriBraces("/{}/off"), handleRelayOff);
+  server.collectHeaders(cacheHeaders, 1); // Keep If-None-Match so handleRoot() can answer 304
   server.begin();
 }
 
@@ -0,0 +1,118 @@
+// Converts the AWS IoT PEM files into DER blobs stored in PROGMEM, so the firmware does not
+// have to base64-decode the PEM text every time it starts. The labs pick up the generated
+// header automatically when it sits next to their main.cpp.
+//
+// Build:  g++ -std=c++11 -O2 main.cpp -o cert-compiler
+// Usage:  cert-compiler device-certificate.pem.crt private.pem.key AmazonRootCA1.pem > aws_certs_der.h
+//
+// The generated header contains your private key: keep it out of version control
+// (it is listed in .gitignore).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+static void fail(const std::string& message) {
+  fprintf(stderr, "cert-compiler: %s\n", message.c_str());
+  exit(1);
+}
+
+static int base64Value(char c) {
+  if (c >= 'A' && c <= 'Z') return c - 'A';
+  if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+  if (c >= '0' && c <= '9') return c - '0' + 52;
+  if (c == '+') return 62;
+  if (c == '/') return 63;
+  return -1;
+}
+
+// Decode the first PEM block of a file, returning its DER bytes and its label
+static std::vector<uint8_t> readPem(const char* path, std::string& label) {
+  FILE* file = fopen(path, "r");
+  if (!file) {
+    fail(std::string("cannot open ") + path);
+  }
+
+  std::vector<uint8_t> der;
+  bool inBlock = false;
+  uint32_t bits = 0;
+  int bitCount = 0;
+  char line[1024];
+  while (fgets(line, sizeof(line), file)) {
+    if (strncmp(line, "-----BEGIN ", 11) == 0) {
+      label = std::string(line + 11);
+      label = label.substr(0, label.find("-----"));
+      inBlock = true;
+      continue;
+    }
+    if (strncmp(line, "-----END ", 9) == 0) {
+      break;
+    }
+    if (!inBlock) {
+      continue;
+    }
+    if (strchr(line, ':')) {
+      fail(std::string(path) + ": encrypted PEM headers are not supported");
+    }
+    for (const char* p = line; *p; p++) {
+      int value = base64Value(*p);
+      if (value < 0) {
+        continue; // Skip line breaks and '=' padding
+      }
+      bits = (bits << 6) | value;
+      bitCount += 6;
+      if (bitCount >= 8) {
+        bitCount -= 8;
+        der.push_back((uint8_t)(bits >> bitCount));
+      }
+    }
+  }
+  fclose(file);
+
+  if (der.empty()) {
+    fail(std::string(path) + ": no PEM block found");
+  }
+  return der;
+}
+
+static void printArray(const char* name, const char* path, const std::string& label, const std::vector<uint8_t>& der) {
+  printf("// %s (%s, %zu bytes)\n", path, label.c_str(), der.size());
+  printf("const uint8_t %s[] PROGMEM = {", name);
+  for (size_t i = 0; i < der.size(); i++) {
+    printf("%s0x%02x,", i % 16 == 0 ? "\n  " : " ", der[i]);
+  }
+  printf("\n};\n\n");
+}
+
+int main(int argc, char** argv) {
+  if (argc != 4) {
+    fprintf(stderr, "usage: cert-compiler DEVICE_CERT.pem PRIVATE_KEY.pem ROOT_CA.pem > aws_certs_der.h\n");
+    return 2;
+  }
+
+  std::string certLabel, keyLabel, caLabel;
+  std::vector<uint8_t> cert = readPem(argv[1], certLabel);
+  std::vector<uint8_t> key = readPem(argv[2], keyLabel);
+  std::vector<uint8_t> ca = readPem(argv[3], caLabel);
+
+  if (certLabel != "CERTIFICATE" || caLabel != "CERTIFICATE") {
+    fail("the device certificate and root CA must be CERTIFICATE blocks");
+  }
+  if (keyLabel != "RSA PRIVATE KEY" && keyLabel != "PRIVATE KEY") {
+    fail("the private key must be an unencrypted RSA PRIVATE KEY or PRIVATE KEY block");
+  }
+
+  printf("// aws_certs_der.h\n");
+  printf("// Generated by Tools/cert-compiler. Do not edit and do not commit: it holds the private key.\n");
+  printf("#ifndef AWS_CERTS_DER_H\n");
+  printf("#define AWS_CERTS_DER_H\n\n");
+  printf("#include <pgmspace.h>\n\n");
+  printArray("awsCertDer", argv[1], certLabel, cert);
+  printArray("awsPrivateKeyDer", argv[2], keyLabel, key);
+  printArray("awsRootCADer", argv[3], caLabel, ca);
+  printf("#endif // AWS_CERTS_DER_H\n");
+  return 0;
+}
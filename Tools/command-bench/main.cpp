@@ -0,0 +1,138 @@
+// Host-side microbenchmark of the MQTT command path of Lab 10.
+// Builds Lab 10's main.cpp on the native shims and feeds relay commands straight to its own
+// messageReceived(), the callback PubSubClient calls, so the "after" line measures the code the
+// board runs: routing, in-place parse, handleControlMessage() and setRelay(). The "before" line
+// is the handler Lab 10 had before the in-place parse, rebuilt here on the same lab globals: it
+// copied the payload into a String one char at a time, printing each one, and parsed the copy.
+// Reports commands per second and heap allocations per command for both.
+//
+// Allocations are counted by wrapping malloc, so the String copies, the ArduinoJson copy of the
+// payload and anything else that reaches the heap are all seen. The shims' String sits on top of
+// std::string, which grows geometrically while Arduino's String reallocates on most appends, so
+// the "before" count is a lower bound of what the board did.
+//
+// Serial output is written to stdout as on the board, where it costs UART time. The results go
+// to stderr, so run it with stdout sent to /dev/null.
+//
+// Build (from this folder, with PubSubClient and ArduinoJson checked out next to the repository):
+//   g++ -std=gnu++17 -O2 -D ARDUINOJSON_ENABLE_PROGMEM=0 -I ../native-shims -I ../../Common
+//       -I "../../Lab 10" -I ../../../pubsubclient/src -I ../../../ArduinoJson/src main.cpp
+//       ../native-shims/*.cpp ../../../pubsubclient/src/PubSubClient.cpp -o command-bench
+// Usage:  command-bench > /dev/null
+//         COMMAND_BENCH_ITERATIONS changes the number of commands per handler (default 200000)
+
+#include <chrono>
+
+// The lab's setup() would bring up WiFi and AWS IoT. The bench only needs its globals and
+// handlers, and it exits from its own setup() before loop() ever runs.
+#define setup labSetup
+#include "../../Lab 10/main.cpp"
+#undef setup
+
+// Count every heap allocation, from the sketch, the shims and the C++ runtime
+static uint64_t allocations = 0;
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* block, size_t size);
+
+extern "C" void* malloc(size_t size) {
+  allocations++;
+  return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+  allocations++;
+  return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* block, size_t size) {
+  allocations++;
+  return __libc_realloc(block, size);
+}
+
+// The handler as Lab 10 had it before the in-place parse
+void messageReceivedBefore(char* topic, byte* payload, unsigned int length) {
+  Serial.print("Message arrived [");
+  Serial.print(topic);
+  Serial.print("]: ");
+  String message;
+  for (unsigned int i = 0; i < length; i++) {
+    Serial.print((char)payload[i]);
+    message += (char)payload[i];
+  }
+  Serial.println();
+
+  consoleLog.add("Message arrived [" + String(topic) + "]: " + message);
+
+  StaticJsonDocument<200> doc;
+  DeserializationError error = deserializeJson(doc, message);
+  if (error) {
+    Serial.print("deserializeJson() failed: ");
+    Serial.println(error.f_str());
+    consoleLog.add("deserializeJson() failed: " + String(error.f_str()));
+    return;
+  }
+
+  int index = relayIndex.find(doc["relay"].as<const char*>());
+  const char* state = doc["status"];
+  if (index < 0 || state == nullptr) {
+    return;
+  }
+  if (strcmp(state, "ON") == 0) {
+    setRelay(index, true, FROM_MQTT);
+  } else if (strcmp(state, "OFF") == 0) {
+    setRelay(index, false, FROM_MQTT);
+  }
+}
+
+struct BenchResult {
+  double commandsPerSecond;
+  double allocationsPerCommand;
+};
+
+// Feed the handler a fresh copy of each command, like PubSubClient does from its receive buffer
+static BenchResult runBench(void (*handler)(char*, byte*, unsigned int), uint32_t iterations) {
+  static const char* commands[] = {
+    "{\"relay\": \"relay1\", \"status\": \"ON\"}",
+    "{\"relay\": \"relay2\", \"status\": \"ON\"}",
+    "{\"relay\": \"relay1\", \"status\": \"OFF\"}",
+    "{\"relay\": \"relay2\", \"status\": \"OFF\"}",
+  };
+  char topic[64];
+  strcpy(topic, controlTopic);
+  byte payload[256];
+
+  uint64_t allocationsBefore = allocations;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; i++) {
+    const char* command = commands[i % 4];
+    size_t length = strlen(command);
+    memcpy(payload, command, length);
+    handler(topic, payload, length);
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  BenchResult result;
+  result.commandsPerSecond = iterations / elapsed.count();
+  result.allocationsPerCommand = (double)(allocations - allocationsBefore) / iterations;
+  return result;
+}
+
+void setup() {
+  const char* text = getenv("COMMAND_BENCH_ITERATIONS");
+  uint32_t iterations = text ? strtoul(text, nullptr, 10) : 200000;
+
+  BenchResult before = runBench(messageReceivedBefore, iterations);
+  uint16_t statesBefore = relayStates;
+  BenchResult after = runBench(messageReceived, iterations);
+  fflush(stdout);
+
+  fprintf(stderr, "%u commands each\n\n", iterations);
+  fprintf(stderr, "%-8s %14s %18s\n", "", "commands/s", "allocations/cmd");
+  fprintf(stderr, "%-8s %14.0f %18.2f\n", "before", before.commandsPerSecond, before.allocationsPerCommand);
+  fprintf(stderr, "%-8s %14.0f %18.2f\n", "after", after.commandsPerSecond, after.allocationsPerCommand);
+  fprintf(stderr, "\nrelay changes via MQTT %u, relay states %x before and %x after\n", relayChanges[FROM_MQTT],
+          statesBefore, relayStates);
+  exit(0);
+}
@@ -0,0 +1,468 @@
+// Round-trip benchmark of the Lab 10 relay commands over MQTT.
+// Sends commands with an "id" on ESP8266/control/relay at a fixed rate and waits for the reply
+// Lab 10 publishes on ESP8266/status/relay with the same id. Each rate runs for a few seconds
+// and reports the latency histogram and the commands that never got a reply. The rates are
+// tried in increasing order until the board falls behind: too many replies lost, or the p99
+// latency above the limit.
+//
+// Runs against any MQTT 3.1.1 broker the board is also connected to, such as a local Mosquitto
+// standing in for AWS IoT. Commands are sent open loop: a slow reply does not delay the next
+// command, so the queues on the board fill up the way they would with several senders.
+//
+// Build:  g++ -std=c++11 -O2 -pthread main.cpp -o command-rtt
+//         g++ -std=c++11 -O2 -pthread -D WITH_TLS main.cpp -lssl -lcrypto -o command-rtt    (with TLS)
+// Usage:  command-rtt [-r RATES] [-d SECONDS] [-w DRAIN_S] [-n RELAY] [-x] [-l LOSS_PERCENT] [-p P99_MS]
+//                     [-C CA_FILE -E CERT_FILE -K KEY_FILE] HOST[:PORT]
+//         (defaults: rates 1,2,5,10,20,50,100 per second, 20 s each, 5 s drain, relay1, always ON,
+//          stop above 1 % loss or 1000 ms p99, port 1883 or 8883 with -C)
+//
+// -x alternates ON and OFF. It exercises the relay change path but clicks a real relay at the
+// command rate, so only use it on a board without a load attached.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef WITH_TLS
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+static const char* controlTopic = "ESP8266/control/relay"; // Same topics as Lab 10
+static const char* statusTopic = "ESP8266/status/relay";
+static const uint16_t KEEPALIVE_S = 60;
+
+// Upper bounds of the histogram buckets in milliseconds, a last bucket takes everything slower
+static const double BUCKET_MS[] = { 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000 };
+static const size_t BUCKETS = sizeof(BUCKET_MS) / sizeof(BUCKET_MS[0]) + 1;
+
+struct Options {
+  std::vector<double> rates = { 1, 2, 5, 10, 20, 50, 100 };
+  double seconds = 20;
+  double drainSeconds = 5;
+  std::string relay = "relay1";
+  bool toggle = false;
+  double lossLimitPercent = 1;
+  double p99LimitMs = 1000;
+  std::string caFile, certFile, keyFile;
+  std::string host;
+  std::string port;
+};
+
+struct StepResult {
+  double rate;
+  uint32_t sent = 0;
+  uint32_t replied = 0;
+  uint32_t lost = 0; // No reply within the drain time
+  double lateMs = 0; // Worst delay of the sender behind its schedule
+  std::vector<double> latenciesMs;
+  uint32_t histogram[BUCKETS] = {};
+};
+
+static void fail(const std::string& message) {
+  fprintf(stderr, "command-rtt: %s\n", message.c_str());
+  exit(1);
+}
+
+static void usage() {
+  fprintf(stderr, "Usage: command-rtt [-r RATES] [-d SECONDS] [-w DRAIN_S] [-n RELAY] [-x] [-l LOSS_PERCENT] "
+                  "[-p P99_MS] [-C CA_FILE -E CERT_FILE -K KEY_FILE] HOST[:PORT]\n");
+  exit(1);
+}
+
+// TCP connection to the broker, through TLS when built with WITH_TLS and given a CA file
+class Connection {
+public:
+  void open(const Options& options) {
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* address = nullptr;
+    int error = getaddrinfo(options.host.c_str(), options.port.c_str(), &hints, &address);
+    if (error != 0) {
+      fail(options.host + ": " + gai_strerror(error));
+    }
+    fd = socket(address->ai_family, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, address->ai_addr, address->ai_addrlen) < 0) {
+      fail(options.host + ":" + options.port + ": " + strerror(errno));
+    }
+    freeaddrinfo(address);
+    if (options.caFile.empty()) {
+      return;
+    }
+#ifdef WITH_TLS
+    SSL_CTX* context = SSL_CTX_new(TLS_client_method());
+    if (SSL_CTX_load_verify_locations(context, options.caFile.c_str(), nullptr) != 1 ||
+        (!options.certFile.empty() && SSL_CTX_use_certificate_chain_file(context, options.certFile.c_str()) != 1) ||
+        (!options.keyFile.empty() && SSL_CTX_use_PrivateKey_file(context, options.keyFile.c_str(), SSL_FILETYPE_PEM) != 1)) {
+      fail("cannot load the certificates");
+    }
+    SSL_CTX_set_verify(context, SSL_VERIFY_PEER, nullptr);
+    tls = SSL_new(context);
+    SSL_set_fd(tls, fd);
+    SSL_set_tlsext_host_name(tls, options.host.c_str());
+    if (SSL_connect(tls) != 1) {
+      ERR_print_errors_fp(stderr);
+      fail("TLS handshake failed");
+    }
+#else
+    fail("built without TLS, rebuild with -D WITH_TLS");
+#endif
+  }
+
+  bool readExact(uint8_t* buffer, size_t length) {
+    while (length > 0) {
+      ssize_t received;
+#ifdef WITH_TLS
+      received = tls ? SSL_read(tls, buffer, (int)length) : recv(fd, buffer, length, 0);
+#else
+      received = recv(fd, buffer, length, 0);
+#endif
+      if (received <= 0) {
+        return false;
+      }
+      buffer += received;
+      length -= received;
+    }
+    return true;
+  }
+
+  // Writes come from the sender and from the reader (PUBACKs), one at a time
+  void writeAll(const std::string& data) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    const char* next = data.data();
+    size_t length = data.size();
+    while (length > 0) {
+      ssize_t written;
+#ifdef WITH_TLS
+      written = tls ? SSL_write(tls, next, (int)length) : send(fd, next, length, MSG_NOSIGNAL);
+#else
+      written = send(fd, next, length, MSG_NOSIGNAL);
+#endif
+      if (written <= 0) {
+        fail("connection to the broker lost");
+      }
+      next += written;
+      length -= written;
+    }
+    lastWrite = Clock::now();
+  }
+
+  Clock::time_point lastWrite;
+
+private:
+  int fd = -1;
+  std::mutex writeMutex;
+#ifdef WITH_TLS
+  SSL* tls = nullptr;
+#endif
+};
+
+// MQTT 3.1.1 packets, only what the benchmark needs
+static std::string mqttString(const std::string& text) {
+  return std::string(1, (char)(text.size() >> 8)) + (char)(text.size() & 0xFF) + text;
+}
+
+static std::string mqttPacket(uint8_t header, const std::string& body) {
+  std::string packet(1, (char)header);
+  size_t length = body.size();
+  do {
+    uint8_t digit = length % 128;
+    length /= 128;
+    packet += (char)(digit | (length > 0 ? 0x80 : 0));
+  } while (length > 0);
+  return packet + body;
+}
+
+// Read one packet, returns false when the connection is closed
+static bool readPacket(Connection& connection, uint8_t& header, std::string& body) {
+  uint8_t byte;
+  if (!connection.readExact(&header, 1)) {
+    return false;
+  }
+  size_t length = 0;
+  for (int shift = 0; shift < 28; shift += 7) {
+    if (!connection.readExact(&byte, 1)) {
+      return false;
+    }
+    length |= (size_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      break;
+    }
+  }
+  body.resize(length);
+  return length == 0 || connection.readExact((uint8_t*)&body[0], length);
+}
+
+// Commands waiting for their reply, and the replies matched to them
+class Tracker {
+public:
+  void sent(uint64_t id, Clock::time_point at) {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending[id] = at;
+  }
+
+  // Called by the reader for every reply with an id
+  void replied(uint64_t id, Clock::time_point at) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto command = pending.find(id);
+    if (command == pending.end()) {
+      unmatched++; // Duplicate, a reply to a command given up on, or another sender
+      return;
+    }
+    latenciesMs.push_back(std::chrono::duration<double, std::milli>(at - command->second).count());
+    pending.erase(command);
+  }
+
+  size_t waiting() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending.size();
+  }
+
+  // Close a step: take its latencies and give up on the commands still waiting
+  std::vector<double> finish(uint32_t& lost) {
+    std::lock_guard<std::mutex> lock(mutex);
+    lost = pending.size();
+    pending.clear();
+    std::vector<double> result;
+    result.swap(latenciesMs);
+    return result;
+  }
+
+  std::atomic<uint32_t> unmatched{ 0 };
+
+private:
+  std::mutex mutex;
+  std::map<uint64_t, Clock::time_point> pending;
+  std::vector<double> latenciesMs;
+};
+
+// Reader thread: answer pings and QoS1 deliveries, hand every reply with an id to the tracker
+static void readReplies(Connection& connection, Tracker& tracker) {
+  uint8_t header;
+  std::string body;
+  while (readPacket(connection, header, body)) {
+    Clock::time_point now = Clock::now();
+    if ((header & 0xF0) != 0x30 || body.size() < 2) {
+      continue; // CONNACK, SUBACK and PINGRESP need nothing
+    }
+    uint8_t qos = (header >> 1) & 3;
+    size_t topicLength = ((uint8_t)body[0] << 8) | (uint8_t)body[1];
+    size_t payloadStart = 2 + topicLength + (qos > 0 ? 2 : 0);
+    if (payloadStart > body.size()) {
+      continue;
+    }
+    if (qos == 1) {
+      connection.writeAll(mqttPacket(0x40, body.substr(2 + topicLength, 2)));
+    }
+    std::string payload = body.substr(payloadStart);
+    size_t key = payload.find("\"id\":");
+    if (body.compare(2, topicLength, statusTopic) == 0 && key != std::string::npos) {
+      tracker.replied(strtoull(payload.c_str() + key + 5, nullptr, 10), now);
+    }
+  }
+  fail("connection to the broker closed");
+}
+
+static void connectBroker(Connection& connection, const Options& options) {
+  connection.open(options);
+  char clientId[32];
+  snprintf(clientId, sizeof(clientId), "command-rtt-%d", (int)getpid());
+  std::string connect = mqttString("MQTT") + (char)4 + (char)0x02 + (char)(KEEPALIVE_S >> 8) + (char)(KEEPALIVE_S & 0xFF) +
+                        mqttString(clientId);
+  connection.writeAll(mqttPacket(0x10, connect));
+  uint8_t header;
+  std::string body;
+  if (!readPacket(connection, header, body) || header != 0x20 || body.size() < 2 || body[1] != 0) {
+    fail("broker refused the connection");
+  }
+  connection.writeAll(mqttPacket(0x82, std::string("\x00\x01", 2) + mqttString(statusTopic) + (char)0));
+  if (!readPacket(connection, header, body) || header != 0x90) {
+    fail("subscription failed");
+  }
+}
+
+// Wait until the given time, keeping the connection alive
+static void waitUntil(Connection& connection, Clock::time_point at) {
+  while (Clock::now() < at) {
+    if (Clock::now() - connection.lastWrite > std::chrono::seconds(KEEPALIVE_S / 2)) {
+      connection.writeAll(mqttPacket(0xC0, ""));
+    }
+    std::this_thread::sleep_until(std::min(at, Clock::now() + std::chrono::milliseconds(100)));
+  }
+}
+
+static double percentile(const std::vector<double>& sorted, double p) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  size_t rank = (size_t)(p / 100 * sorted.size() + 0.999999);
+  return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+// Send commands at one rate for the step duration, then wait for the last replies
+static StepResult runStep(Connection& connection, Tracker& tracker, const Options& options, double rate,
+                          uint64_t& nextId) {
+  StepResult result;
+  result.rate = rate;
+  Clock::duration interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1 / rate));
+  Clock::time_point start = Clock::now();
+  Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.seconds));
+  for (Clock::time_point due = start; due < end; due += interval) {
+    waitUntil(connection, due);
+    char payload[128];
+    const char* state = options.toggle && (nextId & 1) ? "OFF" : "ON";
+    snprintf(payload, sizeof(payload), "{\"relay\": \"%s\", \"status\": \"%s\", \"id\": %llu}", options.relay.c_str(),
+             state, (unsigned long long)nextId);
+    Clock::time_point now = Clock::now();
+    tracker.sent(nextId++, now);
+    connection.writeAll(mqttPacket(0x30, mqttString(controlTopic) + payload));
+    result.sent++;
+    result.lateMs = std::max(result.lateMs, std::chrono::duration<double, std::milli>(now - due).count());
+  }
+
+  Clock::time_point drainEnd = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.drainSeconds));
+  while (tracker.waiting() > 0 && Clock::now() < drainEnd) {
+    waitUntil(connection, std::min(drainEnd, Clock::now() + std::chrono::milliseconds(50)));
+  }
+
+  result.latenciesMs = tracker.finish(result.lost);
+  std::sort(result.latenciesMs.begin(), result.latenciesMs.end());
+  result.replied = result.latenciesMs.size();
+  for (double latency : result.latenciesMs) {
+    size_t bucket = 0;
+    while (bucket < BUCKETS - 1 && latency > BUCKET_MS[bucket]) {
+      bucket++;
+    }
+    result.histogram[bucket]++;
+  }
+  return result;
+}
+
+static std::vector<double> parseRates(const char* text) {
+  std::vector<double> rates;
+  for (const char* next = text; *next;) {
+    char* end;
+    double rate = strtod(next, &end);
+    if (end == next || rate <= 0) {
+      usage();
+    }
+    rates.push_back(rate);
+    next = *end == ',' ? end + 1 : end;
+  }
+  std::sort(rates.begin(), rates.end());
+  return rates;
+}
+
+int main(int argc, char** argv) {
+  Options options;
+  int option;
+  while ((option = getopt(argc, argv, "r:d:w:n:xl:p:C:E:K:")) != -1) {
+    switch (option) {
+    case 'r': options.rates = parseRates(optarg); break;
+    case 'd': options.seconds = atof(optarg); break;
+    case 'w': options.drainSeconds = atof(optarg); break;
+    case 'n': options.relay = optarg; break;
+    case 'x': options.toggle = true; break;
+    case 'l': options.lossLimitPercent = atof(optarg); break;
+    case 'p': options.p99LimitMs = atof(optarg); break;
+    case 'C': options.caFile = optarg; break;
+    case 'E': options.certFile = optarg; break;
+    case 'K': options.keyFile = optarg; break;
+    default: usage();
+    }
+  }
+  if (argc - optind != 1 || options.rates.empty() || options.seconds <= 0) {
+    usage();
+  }
+  options.host = argv[optind];
+  options.port = options.caFile.empty() ? "1883" : "8883";
+  size_t colon = options.host.rfind(':');
+  if (colon != std::string::npos) {
+    options.port = options.host.substr(colon + 1);
+    options.host.resize(colon);
+  }
+
+  Connection connection;
+  connectBroker(connection, options);
+  Tracker tracker;
+  std::thread reader(readReplies, std::ref(connection), std::ref(tracker));
+  reader.detach();
+
+  // Ids start at a random value, so replies to an earlier run cannot be matched to this one
+  uint64_t nextId = std::random_device()() % 1000000000 * 1000;
+  printf("Commands on %s, replies on %s, %s, %.0f s per rate\n\n", controlTopic, statusTopic, options.relay.c_str(),
+         options.seconds);
+  printf("%8s %7s %7s %7s %9s %9s %9s %9s %9s\n", "rate/s", "sent", "replied", "lost %", "p50 ms", "p95 ms", "p99 ms",
+         "max ms", "late ms");
+
+  std::vector<StepResult> results;
+  double sustained = 0;
+  bool fellBehind = false;
+  for (double rate : options.rates) {
+    StepResult result = runStep(connection, tracker, options, rate, nextId);
+    results.push_back(result);
+    double lossPercent = 100.0 * result.lost / result.sent;
+    double p99 = percentile(result.latenciesMs, 99);
+    printf("%8g %7u %7u %7.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", rate, result.sent, result.replied, lossPercent,
+           percentile(result.latenciesMs, 50), percentile(result.latenciesMs, 95), p99,
+           result.latenciesMs.empty() ? 0 : result.latenciesMs.back(), result.lateMs);
+    fflush(stdout);
+    if (lossPercent > options.lossLimitPercent || p99 > options.p99LimitMs) {
+      fellBehind = true;
+      break;
+    }
+    sustained = rate;
+  }
+
+  printf("\nLatency histogram (replies per bucket)\n%10s", "ms");
+  for (const StepResult& result : results) {
+    printf(" %7g/s", result.rate);
+  }
+  printf("\n");
+  for (size_t bucket = 0; bucket < BUCKETS; bucket++) {
+    char bound[16];
+    if (bucket < BUCKETS - 1) {
+      snprintf(bound, sizeof(bound), "<= %g", BUCKET_MS[bucket]);
+    } else {
+      snprintf(bound, sizeof(bound), "> %g", BUCKET_MS[BUCKETS - 2]);
+    }
+    printf("%10s", bound);
+    for (const StepResult& result : results) {
+      printf(" %9u", result.histogram[bucket]);
+    }
+    printf("\n");
+  }
+
+  printf("\n");
+  if (tracker.unmatched > 0) {
+    printf("%u replies matched no waiting command (duplicates or after the drain time)\n", tracker.unmatched.load());
+  }
+  if (fellBehind) {
+    printf("Falls behind at %g commands/s, ", results.back().rate);
+    if (sustained > 0) {
+      printf("sustained %g commands/s\n", sustained);
+    } else {
+      printf("no rate sustained\n");
+    }
+  } else {
+    printf("Sustained every rate up to %g commands/s\n", sustained);
+  }
+  return 0;
+}
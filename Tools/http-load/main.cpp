@@ -0,0 +1,424 @@
+// HTTP load generator for the web servers of Labs 5, 7, 8, 9 and 10.
+// Several workers replay a weighted mix of requests from a scenario file against a board or a
+// native build, each one like a browser or script that sends a request, waits for the answer
+// and sends the next. Reports throughput, latency percentiles and every kind of failure, in
+// total and per scenario line.
+//
+// The ESP8266 web server answers one client at a time and closes the connection after every
+// response, so the workers open a new connection per request. A connection the board cannot
+// accept yet waits in its small backlog, one it cannot queue is refused.
+//
+// Build:  g++ -std=c++11 -O2 -pthread main.cpp -o http-load
+// Usage:  http-load [-c WORKERS] [-d SECONDS] [-n REQUESTS] [-t TIMEOUT_MS] [-w THINK_MS]
+//                   [-e MAX_FAILURES] [-l P99_LIMIT_MS] HOST[:PORT] SCENARIO
+//         (defaults: 4 workers, 30 s, no request limit, 5000 ms timeout, no think time, port 80)
+// With -e or -l the run is also a check: it exits with 2 if more requests failed than allowed,
+// or if the p99 latency of all complete responses is over the limit.
+//
+// Scenario file, one request per line:  WEIGHT METHOD PATH [cached]
+// A line is picked with a probability proportional to its weight. With "cached" the worker
+// sends back the ETag it last got for the line in If-None-Match, as a browser revalidating
+// its cache does. Empty lines and lines starting with # are skipped.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+struct ScenarioLine {
+  uint32_t weight;
+  std::string method;
+  std::string path;
+  bool cached;
+};
+
+enum Outcome {
+  OUTCOME_OK, // 2xx or 3xx response, including 304 Not Modified
+  OUTCOME_HTTP_ERROR, // Complete response with a 4xx or 5xx status
+  OUTCOME_REFUSED, // Connection refused, the board could not queue another client
+  OUTCOME_TIMEOUT, // No complete response within the timeout
+  OUTCOME_BROKEN, // Reset, closed before the end of the response, or not HTTP
+  OUTCOME_COUNT
+};
+
+static const char* outcomeNames[OUTCOME_COUNT] = { "ok", "http-err", "refused", "timeout", "broken" };
+
+struct Sample {
+  uint16_t line; // Index of the scenario line
+  uint8_t outcome;
+  uint32_t latencyUs; // From the start of connect() to the last byte of the response
+};
+
+struct Options {
+  unsigned workers = 4;
+  double seconds = 30;
+  uint64_t requests = 0; // 0 means no limit, run for the duration
+  int timeoutMs = 5000;
+  int thinkMs = 0;
+  long maxFailures = -1; // -1 means no check
+  double p99LimitMs = 0; // 0 means no check
+  std::string host;
+  std::string port = "80";
+  std::string scenarioFile;
+};
+
+static void fail(const std::string& message) {
+  fprintf(stderr, "http-load: %s\n", message.c_str());
+  exit(1);
+}
+
+static void usage() {
+  fprintf(stderr, "Usage: http-load [-c WORKERS] [-d SECONDS] [-n REQUESTS] [-t TIMEOUT_MS] [-w THINK_MS] "
+                  "[-e MAX_FAILURES] [-l P99_LIMIT_MS] HOST[:PORT] SCENARIO\n");
+  exit(1);
+}
+
+static std::vector<ScenarioLine> loadScenario(const std::string& fileName) {
+  FILE* file = fopen(fileName.c_str(), "r");
+  if (!file) {
+    fail("cannot open " + fileName);
+  }
+  std::vector<ScenarioLine> lines;
+  char text[512];
+  int number = 0;
+  while (fgets(text, sizeof(text), file)) {
+    number++;
+    char method[16], path[400], flag[16] = "";
+    unsigned weight;
+    char* start = text + strspn(text, " \t");
+    if (*start == '#' || *start == '\n' || *start == '\r' || *start == 0) {
+      continue;
+    }
+    int fields = sscanf(start, "%u %15s %399s %15s", &weight, method, path, flag);
+    if (fields < 3 || weight == 0 || path[0] != '/' || (fields == 4 && strcmp(flag, "cached") != 0)) {
+      fail(fileName + ":" + std::to_string(number) + ": expected WEIGHT METHOD PATH [cached]");
+    }
+    lines.push_back({ weight, method, path, fields == 4 });
+  }
+  fclose(file);
+  if (lines.empty()) {
+    fail(fileName + " has no requests");
+  }
+  return lines;
+}
+
+// Connect with a timeout. Returns the socket, or -1 with the outcome set.
+static int openConnection(const addrinfo* address, Clock::time_point deadline, Outcome& outcome) {
+  int fd = socket(address->ai_family, SOCK_STREAM, 0);
+  if (fd < 0) {
+    fail(std::string("socket: ") + strerror(errno));
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  int result = connect(fd, address->ai_addr, address->ai_addrlen);
+  if (result < 0 && errno == EINPROGRESS) {
+    int waitMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+    pollfd poller = { fd, POLLOUT, 0 };
+    if (waitMs <= 0 || poll(&poller, 1, waitMs) == 0) {
+      close(fd);
+      outcome = OUTCOME_TIMEOUT;
+      return -1;
+    }
+    socklen_t length = sizeof(result);
+    getsockopt(fd, SOL_SOCKET, SO_ERROR, &result, &length);
+    errno = result;
+    result = result == 0 ? 0 : -1;
+  }
+  if (result < 0) {
+    outcome = errno == ECONNREFUSED ? OUTCOME_REFUSED : OUTCOME_BROKEN;
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Value of a response header, empty if it is missing. headers holds the status line and headers.
+static std::string headerValue(const std::string& headers, const char* name) {
+  std::string lower = headers;
+  std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+  std::string key = std::string("\r\n") + name + ":";
+  std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+  size_t at = lower.find(key);
+  if (at == std::string::npos) {
+    return "";
+  }
+  size_t start = headers.find_first_not_of(' ', at + key.size());
+  size_t end = headers.find("\r\n", start);
+  return headers.substr(start, end - start);
+}
+
+// Send one request on a new connection and read the whole response
+static Outcome runRequest(const addrinfo* address, const Options& options, const ScenarioLine& line,
+                          std::string& etag) {
+  Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(options.timeoutMs);
+  Outcome outcome = OUTCOME_BROKEN;
+  int fd = openConnection(address, deadline, outcome);
+  if (fd < 0) {
+    return outcome;
+  }
+
+  std::string request = line.method + " " + line.path + " HTTP/1.1\r\nHost: " + options.host +
+                        "\r\nUser-Agent: http-load\r\nConnection: close\r\n";
+  if (line.cached && !etag.empty()) {
+    request += "If-None-Match: " + etag + "\r\n";
+  }
+  request += "\r\n";
+
+  size_t sent = 0;
+  std::string response;
+  size_t headerEnd = std::string::npos;
+  long long contentLength = -1;
+  char buffer[4096];
+  bool complete = false;
+  while (!complete) {
+    int waitMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+    pollfd poller = { fd, (short)(sent < request.size() ? POLLOUT : POLLIN), 0 };
+    if (waitMs <= 0 || poll(&poller, 1, waitMs) == 0) {
+      outcome = OUTCOME_TIMEOUT;
+      break;
+    }
+    if (sent < request.size()) {
+      ssize_t written = send(fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+      if (written < 0 && errno != EAGAIN) {
+        break;
+      }
+      sent += written > 0 ? written : 0;
+      continue;
+    }
+    ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+    if (received < 0 && errno == EAGAIN) {
+      continue;
+    }
+    if (received <= 0) {
+      // Closed by the server: the end of the response unless a Content-Length says otherwise
+      complete = headerEnd != std::string::npos && received == 0 && contentLength < 0;
+      break;
+    }
+    response.append(buffer, received);
+    if (headerEnd == std::string::npos) {
+      headerEnd = response.find("\r\n\r\n");
+      if (headerEnd != std::string::npos) {
+        std::string headers = response.substr(0, headerEnd);
+        std::string length = headerValue(headers, "Content-Length");
+        contentLength = length.empty() ? -1 : atoll(length.c_str());
+        if (line.method == "HEAD") {
+          contentLength = 0;
+        }
+      }
+    }
+    if (headerEnd != std::string::npos && contentLength >= 0 &&
+        response.size() >= headerEnd + 4 + (size_t)contentLength) {
+      complete = true;
+    }
+  }
+  close(fd);
+
+  int status = 0;
+  if (!complete || sscanf(response.c_str(), "HTTP/%*d.%*d %d", &status) != 1) {
+    return outcome;
+  }
+  std::string newTag = headerValue(response.substr(0, headerEnd), "ETag");
+  if (!newTag.empty()) {
+    etag = newTag;
+  }
+  return status < 400 ? OUTCOME_OK : OUTCOME_HTTP_ERROR;
+}
+
+static std::atomic<bool> stopping(false);
+
+static void onInterrupt(int) { stopping = true; }
+
+// One worker: pick a line by weight, send it, wait the think time, repeat until told to stop
+static void runWorker(unsigned id, const addrinfo* address, const Options& options,
+                      const std::vector<ScenarioLine>& scenario, Clock::time_point end,
+                      std::atomic<uint64_t>& remaining, std::vector<Sample>& samples) {
+  std::mt19937 random(id * 7919 + 1);
+  std::vector<uint32_t> weights;
+  for (const ScenarioLine& line : scenario) {
+    weights.push_back(line.weight);
+  }
+  std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+  std::vector<std::string> etags(scenario.size());
+
+  while (!stopping && Clock::now() < end) {
+    if (options.requests > 0) {
+      uint64_t left = remaining.load();
+      do {
+        if (left == 0) {
+          return;
+        }
+      } while (!remaining.compare_exchange_weak(left, left - 1));
+    }
+    size_t line = pick(random);
+    Clock::time_point start = Clock::now();
+    Outcome outcome = runRequest(address, options, scenario[line], etags[line]);
+    uint32_t latencyUs = (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+    samples.push_back({ (uint16_t)line, (uint8_t)outcome, latencyUs });
+    if (options.thinkMs > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(options.thinkMs));
+    }
+  }
+}
+
+// Latency at a percentile, 0 to 100, of sorted values in microseconds
+static uint32_t percentile(const std::vector<uint32_t>& sorted, double p) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  size_t rank = (size_t)(p / 100 * sorted.size() + 0.999999);
+  return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+static void printRow(const char* name, const std::vector<Sample>& samples, int line, double seconds) {
+  uint64_t counts[OUTCOME_COUNT] = {};
+  std::vector<uint32_t> latencies; // Of complete responses, failures have no meaningful latency
+  for (const Sample& sample : samples) {
+    if (line >= 0 && sample.line != line) {
+      continue;
+    }
+    counts[sample.outcome]++;
+    if (sample.outcome == OUTCOME_OK || sample.outcome == OUTCOME_HTTP_ERROR) {
+      latencies.push_back(sample.latencyUs);
+    }
+  }
+  std::sort(latencies.begin(), latencies.end());
+  uint64_t total = 0;
+  for (uint64_t count : counts) {
+    total += count;
+  }
+  printf("%-28s %8llu %8.1f %8.1f %8.1f %8.1f %8.1f", name, (unsigned long long)total, total / seconds,
+         percentile(latencies, 50) / 1000.0, percentile(latencies, 95) / 1000.0, percentile(latencies, 99) / 1000.0,
+         (latencies.empty() ? 0 : latencies.back()) / 1000.0);
+  for (int i = OUTCOME_HTTP_ERROR; i < OUTCOME_COUNT; i++) {
+    printf(" %8llu", (unsigned long long)counts[i]);
+  }
+  printf("\n");
+}
+
+// Compare the run with the -e and -l limits, print what is over and return false if anything is
+static bool checkLimits(const Options& options, const std::vector<Sample>& samples) {
+  long failures = 0;
+  std::vector<uint32_t> latencies;
+  for (const Sample& sample : samples) {
+    if (sample.outcome != OUTCOME_OK) {
+      failures++;
+    }
+    if (sample.outcome == OUTCOME_OK || sample.outcome == OUTCOME_HTTP_ERROR) {
+      latencies.push_back(sample.latencyUs);
+    }
+  }
+  std::sort(latencies.begin(), latencies.end());
+  double p99Ms = percentile(latencies, 99) / 1000.0;
+
+  bool passed = true;
+  if (options.maxFailures >= 0 && failures > options.maxFailures) {
+    printf("FAIL %ld failed requests, at most %ld allowed\n", failures, options.maxFailures);
+    passed = false;
+  }
+  if (options.p99LimitMs > 0 && (latencies.empty() || p99Ms > options.p99LimitMs)) {
+    printf("FAIL p99 %.1f ms, limit %.1f ms\n", p99Ms, options.p99LimitMs);
+    passed = false;
+  }
+  return passed;
+}
+
+int main(int argc, char** argv) {
+  Options options;
+  int option;
+  while ((option = getopt(argc, argv, "c:d:n:t:w:e:l:")) != -1) {
+    switch (option) {
+    case 'c': options.workers = atoi(optarg); break;
+    case 'd': options.seconds = atof(optarg); break;
+    case 'n': options.requests = strtoull(optarg, nullptr, 10); break;
+    case 't': options.timeoutMs = atoi(optarg); break;
+    case 'w': options.thinkMs = atoi(optarg); break;
+    case 'e': options.maxFailures = atol(optarg); break;
+    case 'l': options.p99LimitMs = atof(optarg); break;
+    default: usage();
+    }
+  }
+  if (argc - optind != 2 || options.workers == 0 || options.timeoutMs <= 0) {
+    usage();
+  }
+  options.host = argv[optind];
+  size_t colon = options.host.rfind(':');
+  if (colon != std::string::npos) {
+    options.port = options.host.substr(colon + 1);
+    options.host.resize(colon);
+  }
+  options.scenarioFile = argv[optind + 1];
+  std::vector<ScenarioLine> scenario = loadScenario(options.scenarioFile);
+
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* address = nullptr;
+  int error = getaddrinfo(options.host.c_str(), options.port.c_str(), &hints, &address);
+  if (error != 0) {
+    fail(options.host + ": " + gai_strerror(error));
+  }
+
+  signal(SIGINT, onInterrupt); // Ctrl+C stops the run and still prints the report
+  printf("%u workers against %s:%s, %zu scenario lines, ", options.workers, options.host.c_str(),
+         options.port.c_str(), scenario.size());
+  if (options.requests > 0) {
+    printf("%llu requests\n", (unsigned long long)options.requests);
+  } else {
+    printf("%.0f s\n", options.seconds);
+  }
+  fflush(stdout);
+
+  Clock::time_point start = Clock::now();
+  Clock::time_point end = Clock::time_point::max(); // With -n the run ends after the requests
+  if (options.requests == 0) {
+    end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.seconds));
+  }
+  std::atomic<uint64_t> remaining(options.requests);
+  std::vector<std::vector<Sample>> perWorker(options.workers);
+  std::vector<std::thread> workers;
+  for (unsigned i = 0; i < options.workers; i++) {
+    workers.emplace_back(runWorker, i, address, std::cref(options), std::cref(scenario), end, std::ref(remaining),
+                         std::ref(perWorker[i]));
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  freeaddrinfo(address);
+
+  std::vector<Sample> samples;
+  for (const std::vector<Sample>& worker : perWorker) {
+    samples.insert(samples.end(), worker.begin(), worker.end());
+  }
+
+  printf("\n%-28s %8s %8s %8s %8s %8s %8s", "request", "count", "req/s", "p50 ms", "p95 ms", "p99 ms", "max ms");
+  for (int i = OUTCOME_HTTP_ERROR; i < OUTCOME_COUNT; i++) {
+    printf(" %8s", outcomeNames[i]);
+  }
+  printf("\n");
+  for (size_t i = 0; i < scenario.size(); i++) {
+    std::string name = scenario[i].method + " " + scenario[i].path + (scenario[i].cached ? " (cached)" : "");
+    if (name.size() > 28) {
+      name = name.substr(0, 25) + "...";
+    }
+    printRow(name.c_str(), samples, (int)i, seconds);
+  }
+  printRow("total", samples, -1, seconds);
+  printf("\n%.1f s, latency from connect to the last byte of complete responses\n", seconds);
+  return checkLimits(options, samples) ? 0 : 2;
+}
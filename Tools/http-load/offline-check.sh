@@ -0,0 +1,59 @@
+#!/bin/sh
+# Checks that a lab's web server keeps answering while AWS IoT is out of reach.
+# Starts the native build of the lab with the broker port closed, so the connection fails and
+# retries with backoff for the whole run, then runs http-load with the lab's scenario against it.
+# Fails if any request fails or if the p99 latency is over the limit.
+#
+# Build the lab (`pio run -e native` in its folder) and http-load (see main.cpp) first, then from
+# the repository root:
+#   Tools/http-load/offline-check.sh [LAB [P99_LIMIT_MS [SECONDS]]]   (defaults: 10, 100 ms, 20 s)
+# LAB is 5, 7, 8 or 10, the labs with both a web server and an AWS IoT connection.
+# PROGRAM and HTTP_LOAD override the paths of the two binaries.
+
+LAB=${1:-10}
+P99_LIMIT_MS=${2:-100}
+DURATION=${3:-20}
+WEB_PORT=18080
+PROGRAM=${PROGRAM:-"Lab $LAB/.pio/build/native/program"}
+HTTP_LOAD=${HTTP_LOAD:-Tools/http-load/http-load}
+SCENARIO="Tools/http-load/scenarios/lab$LAB.txt"
+LOG="${TMPDIR:-/tmp}/lab$LAB-offline.log" # Output of the lab
+ENDPOINT=$(sed -n 's/.*awsEndpoint = "\([^"]*\)".*/\1/p' "Lab $LAB/main.cpp")
+
+for file in "$PROGRAM" "$HTTP_LOAD" "$SCENARIO"; do
+  if [ ! -f "$file" ]; then
+    echo "offline-check: $file not found" >&2
+    exit 1
+  fi
+done
+
+# Port 9 (discard) is closed, so every TLS attempt is refused at once
+NATIVE_HOSTS=$ENDPOINT=127.0.0.1 NATIVE_PORTS=8883=9,80=$WEB_PORT NATIVE_REAL_DELAY=1 \
+  "$PROGRAM" < /dev/null > "$LOG" 2>&1 &
+LAB_PID=$!
+trap 'kill $LAB_PID 2> /dev/null' EXIT
+
+# Wait for the web server to answer a first request
+for attempt in 1 2 3 4 5 6 7 8 9 10; do
+  if "$HTTP_LOAD" -c 1 -n 1 -e 0 "127.0.0.1:$WEB_PORT" "$SCENARIO" > /dev/null 2>&1; then
+    break
+  fi
+  if [ $attempt = 10 ]; then
+    echo "offline-check: the web server of Lab $LAB did not answer, see $LOG" >&2
+    exit 1
+  fi
+  sleep 1
+done
+
+"$HTTP_LOAD" -c 4 -d "$DURATION" -e 0 -l "$P99_LIMIT_MS" "127.0.0.1:$WEB_PORT" "$SCENARIO"
+STATUS=$?
+
+RETRIES=$(grep -c "TLS connection failed" "$LOG")
+if [ "$RETRIES" = 0 ]; then
+  echo "FAIL the lab never tried the broker, see $LOG"
+  STATUS=2
+fi
+if [ $STATUS = 0 ]; then
+  echo "ok   Lab $LAB served every request while $RETRIES connections to AWS IoT failed"
+fi
+exit $STATUS
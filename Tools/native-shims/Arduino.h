@@ -0,0 +1,129 @@
+// Arduino.h
+// Host stand-in for the parts of the ESP8266 Arduino core the labs use, so a lab's main.cpp
+// builds and runs unchanged on Linux. See native_main.cpp for how the program is driven.
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef unsigned int word;
+
+using std::max;
+using std::min;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x00
+#define INPUT_PULLUP 0x02
+#define OUTPUT 0x01
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define PI 3.1415926535897932384626433832795
+#define constrain(value, low, high) ((value) < (low) ? (low) : ((value) > (high) ? (high) : (value)))
+
+// NodeMCU pin names, same GPIO numbers as the board
+#define D0 16
+#define D1 5
+#define D2 4
+#define D3 0
+#define D4 2
+#define D5 14
+#define D6 12
+#define D7 13
+#define D8 15
+#define LED_BUILTIN 2
+#define A0 17
+
+#include "pgmspace.h"
+
+#define IRAM_ATTR // Everything runs from RAM on the host
+#define ICACHE_RAM_ATTR
+
+class __FlashStringHelper;
+#define FPSTR(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+#define F(s) FPSTR(s)
+
+// Clock. millis() and micros() count real time plus every delay(), which returns at once
+// unless NATIVE_REAL_DELAY is set, so timers run as fast as the loop can go.
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// GPIO, kept in an array. NATIVE_TRACE_PINS prints every change to stderr.
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+// Timezone and NTP come from the host, the clock is already set
+void configTime(int timezone, int daylightOffsetSec, const char* server1, const char* server2 = nullptr,
+                const char* server3 = nullptr);
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "IPAddress.h"
+
+// Serial port, written to stdout. Nothing is ever received.
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  void end() {}
+  void setDebugOutput(bool enable) { (void)enable; }
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  void flush() override;
+  operator bool() const { return true; }
+};
+extern HardwareSerial Serial;
+
+// Chip functions. The heap figures are those of an idle board, measure the host
+// process with heaptrack or valgrind instead.
+class EspClass {
+public:
+  uint32_t random();
+  uint32_t getFreeHeap() { return 50000; }
+  uint32_t getMaxFreeBlockSize() { return 40000; }
+  uint8_t getHeapFragmentation() { return 0; }
+  uint32_t getFreeContStack() { return 4096; }
+  uint32_t getChipId() { return 0x00E5B266; }
+  uint32_t getCycleCount();
+  uint32_t getCpuFreqMHz() { return 80; }
+  const char* getResetReason() { return "Native start"; }
+  void restart();
+  void reset() { restart(); }
+  void deepSleep(uint64_t us) { (void)us; restart(); }
+};
+extern EspClass ESP;
+
+// The lab's sketch, called by native_main.cpp
+void setup();
+void loop();
+
+#endif // ARDUINO_H
@@ -0,0 +1,103 @@
+// BlynkSimpleEsp8266.h
+// Blynk without the cloud. Handlers are registered as on the board. virtualWrite() is
+// printed to stderr, and Blynk.run() reads lines such as "V1 1" from stdin and calls the
+// handler of that virtual pin, standing in for a tap in the app.
+#ifndef BLYNKSIMPLEESP8266_H
+#define BLYNKSIMPLEESP8266_H
+
+#include "ESP8266WiFi.h"
+
+#define V0 0
+#define V1 1
+#define V2 2
+#define V3 3
+#define V4 4
+#define V5 5
+#define V6 6
+#define V7 7
+#define V8 8
+#define V9 9
+#define V10 10
+#define V11 11
+#define V12 12
+#define V13 13
+#define V14 14
+#define V15 15
+
+struct BlynkReq {
+  uint8_t pin;
+};
+
+class BlynkParam {
+public:
+  explicit BlynkParam(const String& value) : value(value) {}
+  int asInt() const { return value.toInt(); }
+  long asLong() const { return value.toInt(); }
+  float asFloat() const { return value.toFloat(); }
+  double asDouble() const { return value.toDouble(); }
+  const char* asStr() const { return value.c_str(); }
+  const char* asString() const { return value.c_str(); }
+
+private:
+  String value;
+};
+
+typedef void (*BlynkWriteHandler)(BlynkReq& request, const BlynkParam& param);
+typedef void (*BlynkConnectedHandler)();
+
+// Collects the handlers defined with the macros below before setup() runs
+struct BlynkRegistration {
+  BlynkRegistration(int pin, BlynkWriteHandler handler);
+  BlynkRegistration(BlynkConnectedHandler handler);
+};
+
+#define BLYNK_WRITE(pin)                                                               \
+  void BlynkWidgetWrite##pin(BlynkReq& request, const BlynkParam& param);              \
+  static BlynkRegistration blynkRegistration##pin(pin, BlynkWidgetWrite##pin);         \
+  void BlynkWidgetWrite##pin(BlynkReq& request __attribute__((unused)), const BlynkParam& param __attribute__((unused)))
+#define BLYNK_WRITE_DEFAULT()                                                          \
+  void BlynkWidgetWriteDefault(BlynkReq& request, const BlynkParam& param);            \
+  static BlynkRegistration blynkRegistrationDefault(-1, BlynkWidgetWriteDefault);      \
+  void BlynkWidgetWriteDefault(BlynkReq& request __attribute__((unused)), const BlynkParam& param __attribute__((unused)))
+#define BLYNK_CONNECTED()                                                              \
+  void BlynkOnConnected();                                                             \
+  static BlynkRegistration blynkRegistrationConnected(BlynkOnConnected);               \
+  void BlynkOnConnected()
+
+class BlynkNative {
+public:
+  void begin(const char* auth, const char* ssid, const char* pass, const char* domain = nullptr, uint16_t port = 80);
+  void config(const char* auth, const char* domain = nullptr, uint16_t port = 80);
+  bool connect(unsigned long timeoutMs = 10000);
+  void disconnect() { isConnected = false; }
+  bool connected() { return isConnected; }
+  void run();
+
+  template <typename... Values>
+  void virtualWrite(int pin, Values... values) {
+    String text;
+    appendValues(text, values...);
+    virtualWriteText(pin, text);
+  }
+  void syncVirtual(int pin);
+
+private:
+  static void appendValues(String& text) { (void)text; }
+  template <typename Value, typename... Values>
+  static void appendValues(String& text, Value value, Values... values) {
+    if (text.length() > 0) {
+      text += ' ';
+    }
+    text += String(value);
+    appendValues(text, values...);
+  }
+  void virtualWriteText(int pin, const String& text);
+  void write(int pin, const String& value);
+
+  bool configured = false;
+  bool isConnected = false;
+  String input; // Partial line read from stdin
+};
+extern BlynkNative Blynk;
+
+#endif // BLYNKSIMPLEESP8266_H
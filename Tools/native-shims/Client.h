@@ -0,0 +1,22 @@
+// Client.h
+// Interface PubSubClient talks to, implemented by WiFiClient
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include "Arduino.h"
+
+class Client : public Stream {
+public:
+  virtual int connect(IPAddress ip, uint16_t port) = 0;
+  virtual int connect(const char* host, uint16_t port) = 0;
+  using Print::write;
+  virtual size_t write(uint8_t c) override = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size) override = 0;
+  virtual int read(uint8_t* buffer, size_t size) = 0;
+  using Stream::read;
+  virtual void stop() = 0;
+  virtual uint8_t connected() = 0;
+  virtual operator bool() = 0;
+};
+
+#endif // CLIENT_H
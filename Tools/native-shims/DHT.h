@@ -0,0 +1,30 @@
+// DHT.h
+// DHT sensor without a sensor: temperature and humidity drift slowly around room values,
+// so deadbands and window statistics see realistic changes
+#ifndef DHT_H
+#define DHT_H
+
+#include "Arduino.h"
+
+#define DHT11 11
+#define DHT12 12
+#define DHT21 21
+#define DHT22 22
+#define AM2301 21
+
+class DHT {
+public:
+  DHT(uint8_t pin, uint8_t type, uint8_t count = 6) { (void)pin, (void)type, (void)count; }
+  void begin(uint8_t usecDelay = 55) { (void)usecDelay; }
+  float readTemperature(bool fahrenheit = false, bool force = false) {
+    (void)force;
+    float celsius = 22.0f + 1.5f * sinf(millis() / 600000.0f); // One cycle every hour
+    return fahrenheit ? celsius * 1.8f + 32 : celsius;
+  }
+  float readHumidity(bool force = false) {
+    (void)force;
+    return 45.0f + 5.0f * sinf(millis() / 900000.0f);
+  }
+};
+
+#endif // DHT_H
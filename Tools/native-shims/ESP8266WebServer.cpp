@@ -0,0 +1,268 @@
+// ESP8266WebServer.cpp
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "ESP8266WebServer.h"
+#include "native_net.h"
+
+static const int REQUEST_TIMEOUT_S = 2; // A client that sends nothing for this long is dropped
+static const size_t MAX_HEADER_SIZE = 8192;
+static const size_t MAX_BODY_SIZE = 65536;
+
+void ESP8266WebServer::begin() {
+  close();
+  listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+  int reuse = 1;
+  setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(nativeServerPort(port));
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(listenFd, (sockaddr*)&address, sizeof(address)) != 0 || listen(listenFd, 8) != 0) {
+    fprintf(stderr, "[native] web server cannot listen on port %u: %s\n", nativeServerPort(port), strerror(errno));
+    ::close(listenFd);
+    listenFd = -1;
+    return;
+  }
+  fcntl(listenFd, F_SETFL, O_NONBLOCK);
+  fprintf(stderr, "[native] web server for port %d listening on port %u\n", port, nativeServerPort(port));
+}
+
+void ESP8266WebServer::close() {
+  if (listenFd >= 0) {
+    ::close(listenFd);
+    listenFd = -1;
+  }
+}
+
+void ESP8266WebServer::handleClient() {
+  if (listenFd < 0) {
+    return;
+  }
+  int fd = accept(listenFd, nullptr, nullptr);
+  if (fd < 0) {
+    return;
+  }
+  timeval timeout = { REQUEST_TIMEOUT_S, 0 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  if (!readRequest(fd)) {
+    ::close(fd);
+    return;
+  }
+  currentClient = WiFiClient::fromSocket(fd);
+  responseHeaders = String();
+  contentLength = CONTENT_LENGTH_NOT_SET;
+  responseSent = false;
+
+  dispatch();
+
+  if (responseSent) {
+    currentClient.stop();
+  }
+  currentClient = WiFiClient(); // A handler that kept a copy, like /events, keeps the connection open
+}
+
+// Read the request line, the headers and a body with a Content-Length
+bool ESP8266WebServer::readRequest(int fd) {
+  std::string request;
+  size_t headerEnd;
+  char chunk[1024];
+  while ((headerEnd = request.find("\r\n\r\n")) == std::string::npos) {
+    if (request.size() > MAX_HEADER_SIZE) {
+      return false;
+    }
+    ssize_t count = recv(fd, chunk, sizeof(chunk), 0);
+    if (count <= 0) {
+      return false;
+    }
+    request.append(chunk, count);
+  }
+
+  char method[16];
+  char target[2048];
+  if (sscanf(request.c_str(), "%15s %2047s", method, target) != 2) {
+    return false;
+  }
+  static const char* methodNames[] = { "", "GET", "HEAD", "POST", "PUT", "PATCH", "DELETE", "OPTIONS" };
+  requestMethod = HTTP_GET;
+  for (int i = HTTP_GET; i <= HTTP_OPTIONS; i++) {
+    if (strcmp(method, methodNames[i]) == 0) {
+      requestMethod = (HTTPMethod)i;
+    }
+  }
+
+  requestArgs.clear();
+  const char* query = strchr(target, '?');
+  if (query != nullptr) {
+    requestUri = String(target, query - target);
+    parseArgs(query + 1, strlen(query + 1));
+  } else {
+    requestUri = target;
+  }
+
+  requestHeaders.clear();
+  size_t lineStart = request.find("\r\n") + 2;
+  while (lineStart < headerEnd) {
+    size_t lineEnd = request.find("\r\n", lineStart);
+    size_t colon = request.find(':', lineStart);
+    if (colon != std::string::npos && colon < lineEnd) {
+      size_t valueStart = request.find_first_not_of(' ', colon + 1);
+      if (valueStart > lineEnd) {
+        valueStart = lineEnd;
+      }
+      requestHeaders.push_back(Field { String(request.c_str() + lineStart, colon - lineStart),
+                                       String(request.c_str() + valueStart, lineEnd - valueStart) });
+    }
+    lineStart = lineEnd + 2;
+  }
+
+  size_t bodyLength = header("Content-Length").toInt();
+  if (bodyLength > MAX_BODY_SIZE) {
+    return false;
+  }
+  std::string body = request.substr(headerEnd + 4);
+  while (body.size() < bodyLength) {
+    ssize_t count = recv(fd, chunk, std::min(sizeof(chunk), bodyLength - body.size()), 0);
+    if (count <= 0) {
+      return false;
+    }
+    body.append(chunk, count);
+  }
+  if (bodyLength > 0) {
+    if (header("Content-Type").startsWith("application/x-www-form-urlencoded")) {
+      parseArgs(body.c_str(), body.size());
+    }
+    requestArgs.push_back(Field { "plain", String(body.c_str(), body.size()) }); // The core keeps the raw body as "plain"
+  }
+  return true;
+}
+
+static String urlDecode(const char* text, size_t length) {
+  String decoded;
+  for (size_t i = 0; i < length; i++) {
+    if (text[i] == '+') {
+      decoded += ' ';
+    } else if (text[i] == '%' && i + 2 < length && isxdigit((unsigned char)text[i + 1]) &&
+               isxdigit((unsigned char)text[i + 2])) {
+      char hex[3] = { text[i + 1], text[i + 2], 0 };
+      decoded += (char)strtol(hex, nullptr, 16);
+      i += 2;
+    } else {
+      decoded += text[i];
+    }
+  }
+  return decoded;
+}
+
+void ESP8266WebServer::parseArgs(const char* text, size_t length) {
+  const char* end = text + length;
+  while (text < end) {
+    const char* pairEnd = (const char*)memchr(text, '&', end - text);
+    if (pairEnd == nullptr) {
+      pairEnd = end;
+    }
+    const char* equals = (const char*)memchr(text, '=', pairEnd - text);
+    if (equals == nullptr) {
+      requestArgs.push_back(Field { urlDecode(text, pairEnd - text), String() });
+    } else {
+      requestArgs.push_back(Field { urlDecode(text, equals - text), urlDecode(equals + 1, pairEnd - equals - 1) });
+    }
+    text = pairEnd + 1;
+  }
+}
+
+void ESP8266WebServer::dispatch() {
+  for (Route& route : routes) {
+    bool methodMatches = route.method == HTTP_ANY || route.method == requestMethod ||
+                         (route.method == HTTP_GET && requestMethod == HTTP_HEAD);
+    if (methodMatches && route.uri->canHandle(requestUri, pathArgs)) {
+      route.handler();
+      return;
+    }
+  }
+  if (notFoundHandler) {
+    notFoundHandler();
+  } else {
+    send(404, "text/plain", String("Not found: ") + requestUri);
+  }
+}
+
+String ESP8266WebServer::arg(const String& name) const {
+  for (const Field& field : requestArgs) {
+    if (field.name == name) {
+      return field.value;
+    }
+  }
+  return String();
+}
+
+bool ESP8266WebServer::hasArg(const String& name) const {
+  for (const Field& field : requestArgs) {
+    if (field.name == name) {
+      return true;
+    }
+  }
+  return false;
+}
+
+String ESP8266WebServer::header(const String& name) const {
+  for (const Field& field : requestHeaders) {
+    if (field.name.equalsIgnoreCase(name)) {
+      return field.value;
+    }
+  }
+  return String();
+}
+
+bool ESP8266WebServer::hasHeader(const String& name) const {
+  for (const Field& field : requestHeaders) {
+    if (field.name.equalsIgnoreCase(name)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ESP8266WebServer::sendHeader(const String& name, const String& value, bool first) {
+  String line = name + ": " + value + "\r\n";
+  responseHeaders = first ? line + responseHeaders : responseHeaders + line;
+}
+
+static const char* reasonPhrase(int code) {
+  switch (code) {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default: return "";
+  }
+}
+
+void ESP8266WebServer::send(int code, const char* contentType, const char* content, size_t length) {
+  String head = String("HTTP/1.1 ") + code + " " + reasonPhrase(code) + "\r\n";
+  if (contentType != nullptr) {
+    head += String("Content-Type: ") + contentType + "\r\n";
+  }
+  if (contentLength != CONTENT_LENGTH_UNKNOWN) {
+    head += String("Content-Length: ") + (contentLength != CONTENT_LENGTH_NOT_SET ? contentLength : length) + "\r\n";
+  }
+  head += responseHeaders;
+  head += "Connection: close\r\n\r\n";
+  currentClient.write(head.c_str(), head.length());
+  if (requestMethod != HTTP_HEAD && length > 0) {
+    currentClient.write(content, length);
+  }
+  responseSent = true;
+}
+
+void ESP8266WebServer::sendContent(const char* content, size_t length) {
+  currentClient.write(content, length);
+}
@@ -0,0 +1,107 @@
+// ESP8266WebServer.h
+// HTTP/1.1 server with the ESP8266WebServer interface. One request per connection, each
+// handled to completion inside handleClient() like on the board.
+#ifndef ESP8266WEBSERVER_H
+#define ESP8266WEBSERVER_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include "ESP8266WiFi.h"
+#include "Uri.h"
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1) // Body ends when the connection closes
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+
+class ESP8266WebServer {
+public:
+  typedef std::function<void(void)> THandlerFunction;
+
+  explicit ESP8266WebServer(int port = 80) : port(port) {}
+  ~ESP8266WebServer() { close(); }
+
+  void begin();
+  void begin(uint16_t port) {
+    this->port = port;
+    begin();
+  }
+  void close();
+  void stop() { close(); }
+
+  // Accept at most one waiting connection and answer it, returns at once if there is none
+  void handleClient();
+
+  void on(const Uri& uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+  void on(const Uri& uri, HTTPMethod method, THandlerFunction handler) {
+    routes.push_back(Route { std::unique_ptr<Uri>(uri.clone()), method, handler });
+  }
+  void onNotFound(THandlerFunction handler) { notFoundHandler = handler; }
+
+  const String& uri() const { return requestUri; }
+  HTTPMethod method() const { return requestMethod; }
+  WiFiClient& client() { return currentClient; }
+
+  String arg(const String& name) const;
+  String arg(int index) const { return index < (int)requestArgs.size() ? requestArgs[index].value : String(); }
+  String argName(int index) const { return index < (int)requestArgs.size() ? requestArgs[index].name : String(); }
+  int args() const { return requestArgs.size(); }
+  bool hasArg(const String& name) const;
+  String pathArg(unsigned int index) const { return index < pathArgs.size() ? pathArgs[index] : String(); }
+
+  // Every request header is kept, so collectHeaders() only has to exist
+  void collectHeaders(const char* headerKeys[], const size_t count) { (void)headerKeys, (void)count; }
+  String header(const String& name) const;
+  bool hasHeader(const String& name) const;
+
+  void sendHeader(const String& name, const String& value, bool first = false);
+  void setContentLength(size_t length) { contentLength = length; }
+  void send(int code, const char* contentType = nullptr, const String& content = emptyString) {
+    send(code, contentType, content.c_str(), content.length());
+  }
+  void send(int code, const String& contentType, const String& content) {
+    send(code, contentType.c_str(), content.c_str(), content.length());
+  }
+  void send(int code, const char* contentType, const char* content) {
+    send(code, contentType, content, strlen(content));
+  }
+  void send(int code, const char* contentType, const char* content, size_t length);
+  void send_P(int code, PGM_P contentType, PGM_P content) { send(code, contentType, content); }
+  void send_P(int code, PGM_P contentType, PGM_P content, size_t length) { send(code, contentType, content, length); }
+  void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+  void sendContent(const char* content) { sendContent(content, strlen(content)); }
+  void sendContent(const char* content, size_t length);
+
+private:
+  struct Route {
+    std::unique_ptr<Uri> uri;
+    HTTPMethod method;
+    THandlerFunction handler;
+  };
+  struct Field {
+    String name;
+    String value;
+  };
+
+  bool readRequest(int fd);
+  void parseArgs(const char* text, size_t length);
+  void dispatch();
+
+  int port;
+  int listenFd = -1;
+  std::vector<Route> routes;
+  THandlerFunction notFoundHandler;
+
+  WiFiClient currentClient;
+  HTTPMethod requestMethod = HTTP_GET;
+  String requestUri;
+  std::vector<Field> requestArgs;
+  std::vector<Field> requestHeaders;
+  std::vector<String> pathArgs;
+  String responseHeaders;
+  size_t contentLength = CONTENT_LENGTH_NOT_SET;
+  bool responseSent = false;
+};
+
+#endif // ESP8266WEBSERVER_H
@@ -0,0 +1,113 @@
+// ESP8266WiFi.h
+// WiFi on the host: the station is always connected, and WiFiClient is a plain TCP socket.
+// NATIVE_HOSTS and NATIVE_PORTS redirect names and ports, see native_net.cpp.
+#ifndef ESP8266WIFI_H
+#define ESP8266WIFI_H
+
+#include <memory>
+#include "Arduino.h"
+#include "Client.h"
+
+enum WiFiMode { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 };
+typedef WiFiMode WiFiMode_t;
+
+enum wl_status_t {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_WRONG_PASSWORD = 6,
+  WL_DISCONNECTED = 7
+};
+
+class NativeSocket;
+
+class WiFiClient : public Client {
+public:
+  WiFiClient() { setTimeout(5000); } // The core's default, it bounds connect() and every write
+
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char* host, uint16_t port) override;
+  int connect(const String& host, uint16_t port) { return connect(host.c_str(), port); }
+
+  using Print::write;
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buffer, size_t size) override;
+  int availableForWrite() override;
+
+  int available() override;
+  int read() override;
+  int read(uint8_t* buffer, size_t size) override;
+  int peek() override;
+  void flush() override {}
+
+  void stop() override;
+  uint8_t connected() override;
+  operator bool() override { return connected(); }
+
+  void setNoDelay(bool noDelay);
+  IPAddress remoteIP();
+  uint16_t remotePort();
+  IPAddress localIP();
+
+  // Wrap a socket accepted by the web server. Copies share the socket, like on the board.
+  static WiFiClient fromSocket(int fd);
+
+private:
+  std::shared_ptr<NativeSocket> socket;
+};
+
+class ESP8266WiFiClass {
+public:
+  bool mode(WiFiMode_t mode) {
+    currentMode = mode;
+    return true;
+  }
+  WiFiMode_t getMode() { return currentMode; }
+  wl_status_t begin(const char* ssid, const char* passphrase = nullptr);
+  wl_status_t begin(const String& ssid, const String& passphrase = emptyString) {
+    return begin(ssid.c_str(), passphrase.c_str());
+  }
+  bool disconnect(bool wifiOff = false);
+  bool reconnect() { return begin(ssidName.c_str()) == WL_CONNECTED; }
+  wl_status_t status() { return currentStatus; }
+  bool isConnected() { return currentStatus == WL_CONNECTED; }
+  bool setAutoReconnect(bool autoReconnect) {
+    (void)autoReconnect;
+    return true;
+  }
+  bool persistent(bool persistent) {
+    (void)persistent;
+    return true;
+  }
+
+  IPAddress localIP() { return IPAddress(127, 0, 0, 1); }
+  IPAddress gatewayIP() { return IPAddress(127, 0, 0, 1); }
+  IPAddress subnetMask() { return IPAddress(255, 0, 0, 0); }
+  IPAddress dnsIP(uint8_t index = 0) {
+    (void)index;
+    return IPAddress(127, 0, 0, 53);
+  }
+  String SSID() { return ssidName; }
+  String macAddress() { return "02:00:00:00:00:01"; }
+  int32_t RSSI() { return currentStatus == WL_CONNECTED ? -50 : 31; } // A strong signal, 31 means no link
+  int32_t channel() { return 1; }
+  const char* getHostname() { return "esp8266-native"; }
+
+  // Resolve through NATIVE_HOSTS, then the host resolver. Returns 1 on success like the core.
+  int hostByName(const char* host, IPAddress& address);
+  int hostByName(const char* host, IPAddress& address, uint32_t timeoutMs) {
+    (void)timeoutMs;
+    return hostByName(host, address);
+  }
+
+private:
+  WiFiMode_t currentMode = WIFI_STA;
+  wl_status_t currentStatus = WL_DISCONNECTED;
+  String ssidName;
+};
+extern ESP8266WiFiClass WiFi;
+
+#endif // ESP8266WIFI_H
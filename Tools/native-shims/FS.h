@@ -0,0 +1,128 @@
+// FS.h
+// File system interface of the ESP8266 core on top of a host directory
+#ifndef FS_H
+#define FS_H
+
+#include <stdio.h>
+#include <dirent.h>
+#include <memory>
+#include "Arduino.h"
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class File : public Stream {
+public:
+  File() {}
+  File(FILE* file, const String& name) : file(file, fclose), fileName(name) {}
+
+  using Print::write;
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buffer, size_t size) override { return file ? fwrite(buffer, 1, size, file.get()) : 0; }
+  int available() override {
+    if (!file) {
+      return 0;
+    }
+    return size() - position();
+  }
+  int read() override {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+  }
+  size_t read(uint8_t* buffer, size_t size) { return file ? fread(buffer, 1, size, file.get()) : 0; }
+  int peek() override {
+    int c = read();
+    if (c >= 0) {
+      fseek(file.get(), -1, SEEK_CUR);
+    }
+    return c;
+  }
+  void flush() override {
+    if (file) {
+      fflush(file.get());
+    }
+  }
+  bool seek(uint32_t position, SeekMode mode = SeekSet) {
+    return file && fseek(file.get(), position, mode == SeekSet ? SEEK_SET : mode == SeekCur ? SEEK_CUR : SEEK_END) == 0;
+  }
+  size_t position() const { return file ? ftell(file.get()) : 0; }
+  size_t size() const {
+    if (!file) {
+      return 0;
+    }
+    long current = ftell(file.get());
+    fseek(file.get(), 0, SEEK_END);
+    long end = ftell(file.get());
+    fseek(file.get(), current, SEEK_SET);
+    return end;
+  }
+  void close() { file.reset(); }
+  const char* name() const { return fileName.c_str(); }
+  operator bool() const { return (bool)file; }
+
+private:
+  std::shared_ptr<FILE> file;
+  String fileName;
+};
+
+class Dir {
+public:
+  Dir() {}
+  Dir(const String& path) : path(path), dir(opendir(path.c_str()), [](DIR* d) { if (d) closedir(d); }) {}
+
+  bool next();
+  String fileName() const { return name; }
+  size_t fileSize() const { return size; }
+  bool isFile() const { return !directory; }
+  bool isDirectory() const { return directory; }
+
+private:
+  String path;
+  std::shared_ptr<DIR> dir;
+  String name;
+  size_t size = 0;
+  bool directory = false;
+};
+
+struct FSInfo {
+  size_t totalBytes;
+  size_t usedBytes;
+  size_t blockSize;
+  size_t pageSize;
+  size_t maxOpenFiles;
+  size_t maxPathLength;
+};
+
+namespace fs {
+
+// Paths are relative to NATIVE_FS_DIR, ./littlefs by default
+class FS {
+public:
+  bool begin();
+  void end() {}
+  bool format();
+  bool info(FSInfo& info);
+  File open(const char* path, const char* mode);
+  File open(const String& path, const char* mode) { return open(path.c_str(), mode); }
+  bool exists(const char* path);
+  bool exists(const String& path) { return exists(path.c_str()); }
+  Dir openDir(const char* path) { return Dir(hostPath(path)); }
+  Dir openDir(const String& path) { return openDir(path.c_str()); }
+  bool mkdir(const char* path);
+  bool mkdir(const String& path) { return mkdir(path.c_str()); }
+  bool remove(const char* path);
+  bool remove(const String& path) { return remove(path.c_str()); }
+  bool rename(const char* from, const char* to);
+  bool rename(const String& from, const String& to) { return rename(from.c_str(), to.c_str()); }
+  bool rmdir(const char* path);
+
+private:
+  String hostPath(const char* path);
+
+  String root;
+};
+
+} // namespace fs
+
+using fs::FS;
+
+#endif // FS_H
@@ -0,0 +1,43 @@
+// IPAddress.h
+// IPv4 address, stored in network byte order like the ESP8266 core
+#ifndef IPADDRESS_H
+#define IPADDRESS_H
+
+#include "Arduino.h"
+
+class IPAddress : public Printable {
+public:
+  IPAddress() : address(0) {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+      : address((uint32_t)a | (uint32_t)b << 8 | (uint32_t)c << 16 | (uint32_t)d << 24) {}
+  IPAddress(uint32_t networkOrder) : address(networkOrder) {}
+
+  operator uint32_t() const { return address; }
+  uint8_t operator[](int index) const { return address >> (8 * index); }
+  bool operator==(const IPAddress& other) const { return address == other.address; }
+  bool operator!=(const IPAddress& other) const { return address != other.address; }
+  bool isSet() const { return address != 0; }
+
+  bool fromString(const char* text) {
+    unsigned a, b, c, d;
+    char tail;
+    if (sscanf(text, "%u.%u.%u.%u%c", &a, &b, &c, &d, &tail) != 4 || a > 255 || b > 255 || c > 255 || d > 255) {
+      return false;
+    }
+    *this = IPAddress(a, b, c, d);
+    return true;
+  }
+
+  size_t printTo(Print& out) const override { return out.print(toString()); }
+
+  String toString() const {
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+    return String(text);
+  }
+
+private:
+  uint32_t address;
+};
+
+#endif // IPADDRESS_H
@@ -0,0 +1,86 @@
+// Print.h
+// Text and number formatting for Serial and the network clients, all of it ends in write()
+#ifndef PRINT_H
+#define PRINT_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "WString.h"
+
+class Print;
+
+// Objects that know how to print themselves, like IPAddress
+class Printable {
+public:
+  virtual ~Printable() {}
+  virtual size_t printTo(Print& out) const = 0;
+};
+
+class Print {
+public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size) {
+    size_t written = 0;
+    while (written < size && write(buffer[written])) {
+      written++;
+    }
+    return written;
+  }
+  size_t write(const char* text) { return text ? write((const uint8_t*)text, strlen(text)) : 0; }
+  size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+
+  size_t print(const __FlashStringHelper* text) { return write(reinterpret_cast<const char*>(text)); }
+  size_t print(const String& text) { return write(text.c_str(), text.length()); }
+  size_t print(const char* text) { return write(text); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char number, int base = DEC) { return print(String(number, base)); }
+  size_t print(int number, int base = DEC) { return print(String(number, base)); }
+  size_t print(unsigned int number, int base = DEC) { return print(String(number, base)); }
+  size_t print(long number, int base = DEC) { return print(String(number, base)); }
+  size_t print(unsigned long number, int base = DEC) { return print(String(number, base)); }
+  size_t print(long long number, int base = DEC) { return print(String(number, base)); }
+  size_t print(unsigned long long number, int base = DEC) { return print(String(number, base)); }
+  size_t print(double number, int decimals = 2) { return print(String(number, decimals)); }
+  size_t print(const Printable& value) { return value.printTo(*this); }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T>
+  size_t println(const T& value) {
+    size_t written = print(value);
+    return written + println();
+  }
+  template <typename T>
+  size_t println(const T& value, int format) {
+    size_t written = print(value, format);
+    return written + println();
+  }
+
+  __attribute__((format(printf, 2, 3))) size_t printf(const char* format, ...) {
+    // Longer output than the buffer is formatted a second time into one of the right size
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    if (length < 0) {
+      return 0;
+    }
+    if ((size_t)length < sizeof(text)) {
+      return write(text, length);
+    }
+    char* buffer = new char[length + 1];
+    va_start(args, format);
+    vsnprintf(buffer, length + 1, format, args);
+    va_end(args);
+    size_t written = write(buffer, length);
+    delete[] buffer;
+    return written;
+  }
+};
+
+#endif // PRINT_H
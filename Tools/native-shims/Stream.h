@@ -0,0 +1,57 @@
+// Stream.h
+// Readable Print, the base of Serial and the network clients
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "Arduino.h"
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long timeoutMs) { timeout = timeoutMs; }
+  unsigned long getTimeout() const { return timeout; }
+
+  // Read until size bytes arrived or nothing came for the timeout
+  virtual size_t readBytes(uint8_t* buffer, size_t size) {
+    size_t count = 0;
+    while (count < size) {
+      int c = timedRead();
+      if (c < 0) {
+        break;
+      }
+      buffer[count++] = c;
+    }
+    return count;
+  }
+  size_t readBytes(char* buffer, size_t size) { return readBytes((uint8_t*)buffer, size); }
+
+  String readStringUntil(char terminator) {
+    String text;
+    int c = timedRead();
+    while (c >= 0 && c != terminator) {
+      text += (char)c;
+      c = timedRead();
+    }
+    return text;
+  }
+
+protected:
+  int timedRead() {
+    unsigned long start = millis();
+    do {
+      int c = read();
+      if (c >= 0) {
+        return c;
+      }
+      yield();
+    } while (millis() - start < timeout);
+    return -1;
+  }
+
+  unsigned long timeout = 1000;
+};
+
+#endif // STREAM_H
@@ -0,0 +1,27 @@
+// Uri.h
+// Route pattern of the web server, matches one path exactly
+#ifndef URI_H
+#define URI_H
+
+#include <vector>
+#include "Arduino.h"
+
+class Uri {
+public:
+  Uri(const char* uri) : uri(uri) {}
+  Uri(const String& uri) : uri(uri) {}
+  virtual ~Uri() {}
+
+  virtual Uri* clone() const { return new Uri(uri); }
+
+  // True if the path matches, placeholders are appended to pathArgs
+  virtual bool canHandle(const String& requestUri, std::vector<String>& pathArgs) {
+    (void)pathArgs;
+    return requestUri == uri;
+  }
+
+protected:
+  const String uri;
+};
+
+#endif // URI_H
@@ -0,0 +1,207 @@
+// WString.h
+// Arduino String on top of std::string, with the conversions and operators the labs use
+#ifndef WSTRING_H
+#define WSTRING_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <algorithm>
+#include <string>
+
+class __FlashStringHelper;
+
+class String {
+public:
+  String() {}
+  String(const char* text) : value(text ? text : "") {}
+  String(const char* text, size_t length) : value(text, length) {}
+  String(const __FlashStringHelper* text) : String(reinterpret_cast<const char*>(text)) {}
+  explicit String(char c) : value(1, c) {}
+  explicit String(unsigned char number, unsigned char base = 10) { appendNumber((unsigned long long)number, base); }
+  explicit String(int number, unsigned char base = 10) { appendSigned(number, base); }
+  explicit String(unsigned int number, unsigned char base = 10) { appendNumber(number, base); }
+  explicit String(long number, unsigned char base = 10) { appendSigned(number, base); }
+  explicit String(unsigned long number, unsigned char base = 10) { appendNumber(number, base); }
+  explicit String(long long number, unsigned char base = 10) { appendSigned(number, base); }
+  explicit String(unsigned long long number, unsigned char base = 10) { appendNumber(number, base); }
+  explicit String(float number, unsigned char decimals = 2) { appendFloat(number, decimals); }
+  explicit String(double number, unsigned char decimals = 2) { appendFloat(number, decimals); }
+
+  const char* c_str() const { return value.c_str(); }
+  unsigned int length() const { return value.size(); }
+  bool isEmpty() const { return value.empty(); }
+  bool reserve(unsigned int size) {
+    value.reserve(size);
+    return true;
+  }
+  void clear() { value.clear(); }
+
+  bool concat(const String& other) {
+    value += other.value;
+    return true;
+  }
+  bool concat(const char* text) {
+    value += text ? text : "";
+    return true;
+  }
+  bool concat(const char* text, unsigned int length) {
+    value.append(text, length);
+    return true;
+  }
+  bool concat(const __FlashStringHelper* text) { return concat(reinterpret_cast<const char*>(text)); }
+  bool concat(char c) {
+    value += c;
+    return true;
+  }
+  bool concat(unsigned char number) { return concat(String(number)); }
+  bool concat(int number) { return concat(String(number)); }
+  bool concat(unsigned int number) { return concat(String(number)); }
+  bool concat(long number) { return concat(String(number)); }
+  bool concat(unsigned long number) { return concat(String(number)); }
+  bool concat(long long number) { return concat(String(number)); }
+  bool concat(unsigned long long number) { return concat(String(number)); }
+  bool concat(float number) { return concat(String(number)); }
+  bool concat(double number) { return concat(String(number)); }
+
+  template <typename T>
+  String& operator+=(const T& other) {
+    concat(other);
+    return *this;
+  }
+
+  bool equals(const String& other) const { return value == other.value; }
+  bool equals(const char* text) const { return value == (text ? text : ""); }
+  bool equalsIgnoreCase(const String& other) const { return strcasecmp(c_str(), other.c_str()) == 0; }
+  bool operator==(const String& other) const { return equals(other); }
+  bool operator==(const char* text) const { return equals(text); }
+  bool operator!=(const String& other) const { return !equals(other); }
+  bool operator!=(const char* text) const { return !equals(text); }
+  bool operator<(const String& other) const { return value < other.value; }
+  bool operator>(const String& other) const { return value > other.value; }
+  bool startsWith(const String& prefix) const { return value.compare(0, prefix.value.size(), prefix.value) == 0; }
+  bool endsWith(const String& suffix) const {
+    return value.size() >= suffix.value.size() &&
+           value.compare(value.size() - suffix.value.size(), suffix.value.size(), suffix.value) == 0;
+  }
+
+  char charAt(unsigned int index) const { return index < value.size() ? value[index] : 0; }
+  void setCharAt(unsigned int index, char c) {
+    if (index < value.size()) {
+      value[index] = c;
+    }
+  }
+  char operator[](unsigned int index) const { return charAt(index); }
+  char& operator[](unsigned int index) { return value[index]; }
+
+  int indexOf(char c, unsigned int from = 0) const { return position(value.find(c, from)); }
+  int indexOf(const String& text, unsigned int from = 0) const { return position(value.find(text.value, from)); }
+  int lastIndexOf(char c) const { return position(value.rfind(c)); }
+  int lastIndexOf(const String& text) const { return position(value.rfind(text.value)); }
+  String substring(unsigned int from) const { return from < value.size() ? String(value.c_str() + from) : String(); }
+  String substring(unsigned int from, unsigned int to) const {
+    if (from > to) {
+      std::swap(from, to);
+    }
+    if (from >= value.size()) {
+      return String();
+    }
+    return String(value.c_str() + from, std::min<size_t>(to, value.size()) - from);
+  }
+
+  void replace(const String& find, const String& replacement) {
+    if (find.value.empty()) {
+      return;
+    }
+    for (size_t at = value.find(find.value); at != std::string::npos;
+         at = value.find(find.value, at + replacement.value.size())) {
+      value.replace(at, find.value.size(), replacement.value);
+    }
+  }
+  void remove(unsigned int index) { remove(index, value.size()); }
+  void remove(unsigned int index, unsigned int count) {
+    if (index < value.size()) {
+      value.erase(index, count);
+    }
+  }
+  void trim() {
+    size_t first = value.find_first_not_of(" \t\r\n");
+    size_t last = value.find_last_not_of(" \t\r\n");
+    value = first == std::string::npos ? std::string() : value.substr(first, last - first + 1);
+  }
+  void toLowerCase() {
+    for (char& c : value) {
+      c = tolower((unsigned char)c);
+    }
+  }
+  void toUpperCase() {
+    for (char& c : value) {
+      c = toupper((unsigned char)c);
+    }
+  }
+
+  long toInt() const { return strtol(c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(c_str(), nullptr); }
+  double toDouble() const { return strtod(c_str(), nullptr); }
+
+private:
+  static int position(size_t at) { return at == std::string::npos ? -1 : (int)at; }
+
+  void appendNumber(unsigned long long number, unsigned char base) {
+    char digits[65];
+    char* end = digits + sizeof(digits) - 1;
+    *end = 0;
+    do {
+      unsigned digit = number % base;
+      *--end = digit < 10 ? '0' + digit : 'a' + digit - 10;
+      number /= base;
+    } while (number);
+    value += end;
+  }
+
+  void appendSigned(long long number, unsigned char base) {
+    if (number < 0 && base == 10) {
+      value += '-';
+      appendNumber(0ULL - (unsigned long long)number, base);
+    } else {
+      appendNumber((unsigned long long)number, base);
+    }
+  }
+
+  void appendFloat(double number, unsigned char decimals) {
+    char text[40];
+    snprintf(text, sizeof(text), "%.*f", decimals, number);
+    value += text;
+  }
+
+  std::string value;
+};
+
+template <typename T>
+String operator+(const String& lhs, const T& rhs) {
+  String sum(lhs);
+  sum.concat(rhs);
+  return sum;
+}
+
+inline String operator+(const char* lhs, const String& rhs) {
+  String sum(lhs);
+  sum.concat(rhs);
+  return sum;
+}
+
+inline String operator+(char lhs, const String& rhs) {
+  String sum(lhs);
+  sum.concat(rhs);
+  return sum;
+}
+
+inline bool operator==(const char* lhs, const String& rhs) { return rhs.equals(lhs); }
+inline bool operator!=(const char* lhs, const String& rhs) { return !rhs.equals(lhs); }
+
+extern const String emptyString;
+
+#endif // WSTRING_H
@@ -0,0 +1,10 @@
+// WiFiClientSecure.h
+// Same as the ESP8266 core: WiFiClientSecure is the BearSSL client
+#ifndef WIFICLIENTSECURE_H
+#define WIFICLIENTSECURE_H
+
+#include "WiFiClientSecureBearSSL.h"
+
+using namespace BearSSL;
+
+#endif // WIFICLIENTSECURE_H
@@ -0,0 +1,72 @@
+// WiFiClientSecureBearSSL.h
+// The BearSSL client without TLS: connections are plain TCP, so point the lab at a broker
+// listener without TLS (for example with NATIVE_PORTS=8883=1883). Certificates and keys are
+// accepted and ignored.
+#ifndef WIFICLIENTSECUREBEARSSL_H
+#define WIFICLIENTSECUREBEARSSL_H
+
+#include "ESP8266WiFi.h"
+
+namespace BearSSL {
+
+class X509List {
+public:
+  X509List() {}
+  X509List(const char* pem) { append(pem); }
+  X509List(const uint8_t* der, size_t length) { append(der, length); }
+  bool append(const char* pem) { return pem != nullptr && ++count; }
+  bool append(const uint8_t* der, size_t length) { return der != nullptr && length > 0 && ++count; }
+  size_t getCount() const { return count; }
+
+private:
+  size_t count = 0;
+};
+
+class PrivateKey {
+public:
+  PrivateKey() {}
+  PrivateKey(const char* pem) { parse(pem); }
+  PrivateKey(const uint8_t* der, size_t length) { parse(der, length); }
+  bool parse(const char* pem) { return valid = pem != nullptr; }
+  bool parse(const uint8_t* der, size_t length) { return valid = der != nullptr && length > 0; }
+  bool isRSA() const { return valid; }
+  bool isEC() const { return false; }
+
+private:
+  bool valid = false;
+};
+
+// Every connection stores a new session ID, so the labs log a full handshake each time
+class Session {
+public:
+  uint8_t id[32] = {};
+};
+
+class WiFiClientSecure : public WiFiClient {
+public:
+  using WiFiClient::connect;
+  int connect(const char* host, uint16_t port) override;
+  int connect(IPAddress ip, uint16_t port) override;
+
+  void setClientRSACert(const X509List* cert, const PrivateKey* key) { (void)cert, (void)key; }
+  void setTrustAnchors(const X509List* anchors) { (void)anchors; }
+  void setSession(Session* session) { this->session = session; }
+  void setInsecure() {}
+  void setBufferSizes(int receive, int transmit) { (void)receive, (void)transmit; }
+  void setX509Time(time_t now) { (void)now; }
+  int getLastSSLError(char* text = nullptr, size_t size = 0) {
+    if (text != nullptr && size > 0) {
+      text[0] = 0;
+    }
+    return 0;
+  }
+
+private:
+  void newSession();
+
+  Session* session = nullptr;
+};
+
+} // namespace BearSSL
+
+#endif // WIFICLIENTSECUREBEARSSL_H
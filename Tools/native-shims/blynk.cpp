@@ -0,0 +1,103 @@
+// blynk.cpp
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <map>
+#include "BlynkSimpleEsp8266.h"
+
+BlynkNative Blynk;
+
+static std::map<int, BlynkWriteHandler>& writeHandlers() {
+  static std::map<int, BlynkWriteHandler> handlers; // Filled by static constructors, so not a plain global
+  return handlers;
+}
+static BlynkConnectedHandler connectedHandler = nullptr;
+static std::map<int, String> pinValues; // Last value written to each virtual pin, for syncVirtual()
+
+BlynkRegistration::BlynkRegistration(int pin, BlynkWriteHandler handler) {
+  writeHandlers()[pin] = handler;
+}
+
+BlynkRegistration::BlynkRegistration(BlynkConnectedHandler handler) {
+  connectedHandler = handler;
+}
+
+void BlynkNative::begin(const char* auth, const char* ssid, const char* pass, const char* domain, uint16_t port) {
+  WiFi.begin(ssid, pass);
+  config(auth, domain, port);
+  connect();
+}
+
+void BlynkNative::config(const char* auth, const char* domain, uint16_t port) {
+  (void)auth, (void)domain, (void)port;
+  configured = true;
+  fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_NONBLOCK);
+}
+
+bool BlynkNative::connect(unsigned long timeoutMs) {
+  (void)timeoutMs;
+  if (!configured || WiFi.status() != WL_CONNECTED) {
+    return false;
+  }
+  if (!isConnected) {
+    isConnected = true;
+    fprintf(stderr, "[blynk] connected\n");
+    if (connectedHandler != nullptr) {
+      connectedHandler();
+    }
+  }
+  return true;
+}
+
+void BlynkNative::run() {
+  if (!isConnected && !connect()) {
+    return;
+  }
+  char chunk[128];
+  ssize_t count;
+  while ((count = ::read(STDIN_FILENO, chunk, sizeof(chunk))) > 0) {
+    input.concat(chunk, count);
+  }
+  int newline;
+  while ((newline = input.indexOf('\n')) >= 0) {
+    String line = input.substring(0, newline);
+    input.remove(0, newline + 1);
+    line.trim();
+    int space = line.indexOf(' ');
+    if ((line[0] == 'V' || line[0] == 'v') && space > 1) {
+      String value = line.substring(space + 1);
+      value.trim();
+      write(line.substring(1, space).toInt(), value);
+    } else if (line.length() > 0) {
+      fprintf(stderr, "[blynk] expected \"V<pin> <value>\", got \"%s\"\n", line.c_str());
+    }
+  }
+}
+
+void BlynkNative::write(int pin, const String& value) {
+  pinValues[pin] = value;
+  std::map<int, BlynkWriteHandler>& handlers = writeHandlers();
+  auto handler = handlers.find(pin);
+  if (handler == handlers.end()) {
+    handler = handlers.find(-1); // BLYNK_WRITE_DEFAULT
+  }
+  if (handler == handlers.end()) {
+    fprintf(stderr, "[blynk] no handler for V%d\n", pin);
+    return;
+  }
+  BlynkReq request = { (uint8_t)pin };
+  BlynkParam param(value);
+  handler->second(request, param);
+}
+
+void BlynkNative::syncVirtual(int pin) {
+  auto value = pinValues.find(pin);
+  if (value != pinValues.end()) {
+    write(pin, value->second);
+  }
+}
+
+void BlynkNative::virtualWriteText(int pin, const String& text) {
+  pinValues[pin] = text;
+  fprintf(stderr, "[blynk] V%d <- %s\n", pin, text.c_str());
+}
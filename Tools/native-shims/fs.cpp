@@ -0,0 +1,92 @@
+// fs.cpp
+#include <ftw.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+#include "FS.h"
+#include "LittleFS.h"
+
+fs::FS LittleFS;
+
+bool Dir::next() {
+  if (!dir) {
+    return false;
+  }
+  while (dirent* entry = readdir(dir.get())) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+      continue;
+    }
+    name = entry->d_name;
+    struct stat status;
+    String full = path + "/" + name;
+    if (stat(full.c_str(), &status) == 0) {
+      size = status.st_size;
+      directory = S_ISDIR(status.st_mode);
+    }
+    return true;
+  }
+  return false;
+}
+
+namespace fs {
+
+String FS::hostPath(const char* path) {
+  return root + (path[0] == '/' ? "" : "/") + path;
+}
+
+bool FS::begin() {
+  const char* dir = getenv("NATIVE_FS_DIR");
+  root = dir ? dir : "littlefs";
+  ::mkdir(root.c_str(), 0755);
+  struct stat status;
+  return stat(root.c_str(), &status) == 0 && S_ISDIR(status.st_mode);
+}
+
+static int removeEntry(const char* path, const struct stat* status, int type, FTW* walk) {
+  (void)status, (void)type;
+  return walk->level == 0 ? 0 : ::remove(path); // Keep the root directory itself
+}
+
+bool FS::format() {
+  return nftw(root.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS) == 0;
+}
+
+bool FS::info(FSInfo& info) {
+  info.totalBytes = 1 << 20; // The 1 MB file system of a 4 MB board
+  info.usedBytes = 0;
+  info.blockSize = 8192;
+  info.pageSize = 256;
+  info.maxOpenFiles = 5;
+  info.maxPathLength = 32;
+  return true;
+}
+
+File FS::open(const char* path, const char* mode) {
+  // "r+" and "w+" behave as on the board, plain "r", "w" and "a" map to binary host modes
+  String hostMode = String(mode) + "b";
+  FILE* file = fopen(hostPath(path).c_str(), hostMode.c_str());
+  return file ? File(file, path) : File();
+}
+
+bool FS::exists(const char* path) {
+  struct stat status;
+  return stat(hostPath(path).c_str(), &status) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+  return ::mkdir(hostPath(path).c_str(), 0755) == 0;
+}
+
+bool FS::remove(const char* path) {
+  return ::remove(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* from, const char* to) {
+  return ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+bool FS::rmdir(const char* path) {
+  return ::rmdir(hostPath(path).c_str()) == 0;
+}
+
+} // namespace fs
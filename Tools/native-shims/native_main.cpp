@@ -0,0 +1,181 @@
+// native_main.cpp
+// Runs a lab's setup() and loop() on Linux, and provides the clock, the pins, Serial and ESP.
+//
+// Environment variables:
+//   NATIVE_LOOPS=N        stop after N loop() iterations (default: run until Ctrl-C)
+//   NATIVE_REAL_DELAY=1   make delay() sleep instead of only advancing the clock
+//   NATIVE_TRACE_PINS=1   print every digitalWrite() that changes a pin to stderr
+//   NATIVE_HOSTS, NATIVE_PORTS, NATIVE_FS_DIR: see native_net.h and FS.h
+//
+// On exit the loop statistics are printed to stderr: iterations, iterations per second and
+// the mean and worst time of one loop() call. For deeper profiling run the binary under
+// perf, valgrind or heaptrack.
+//
+// Build with PlatformIO from a lab folder: pio run -e native && .pio/build/native/program
+// Or directly, with PubSubClient and ArduinoJson checked out next to the repository:
+//   g++ -std=gnu++17 -O2 -I Tools/native-shims -I ../pubsubclient/src -I ../ArduinoJson/src
+//       -D ARDUINOJSON_ENABLE_PROGMEM=0 -x c++ "Lab 10/main.cpp" -x none Tools/native-shims/*.cpp
+//       ../pubsubclient/src/PubSubClient.cpp -o lab10          (one command)
+#include <signal.h>
+#include <sys/random.h>
+#include <unistd.h>
+#include <chrono>
+#include <random>
+#include "Arduino.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+const String emptyString;
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+static uint64_t skippedUs = 0; // Time added by delay() calls that did not sleep
+static bool realDelay = false;
+static bool tracePins = false;
+static uint8_t pinValues[32];
+static std::mt19937 randomEngine;
+static volatile sig_atomic_t stopRequested = 0;
+
+static uint64_t nowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count() +
+         skippedUs;
+}
+
+unsigned long millis() {
+  return nowUs() / 1000;
+}
+
+unsigned long micros() {
+  return nowUs();
+}
+
+void delay(unsigned long ms) {
+  if (realDelay) {
+    usleep(ms * 1000);
+  } else {
+    skippedUs += (uint64_t)ms * 1000;
+  }
+}
+
+void delayMicroseconds(unsigned int us) {
+  if (realDelay) {
+    usleep(us);
+  } else {
+    skippedUs += us;
+  }
+}
+
+void yield() {}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin, (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin >= sizeof(pinValues)) {
+    return;
+  }
+  if (tracePins && pinValues[pin] != (value ? HIGH : LOW)) {
+    fprintf(stderr, "[pin] GPIO%u %s\n", pin, value ? "HIGH" : "LOW");
+  }
+  pinValues[pin] = value ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < sizeof(pinValues) ? pinValues[pin] : LOW;
+}
+
+int analogRead(uint8_t pin) {
+  (void)pin;
+  return 0;
+}
+
+void analogWrite(uint8_t pin, int value) {
+  (void)pin, (void)value;
+}
+
+long random(long howBig) {
+  return howBig > 0 ? (long)(randomEngine() % howBig) : 0;
+}
+
+long random(long howSmall, long howBig) {
+  return howSmall >= howBig ? howSmall : howSmall + random(howBig - howSmall);
+}
+
+void randomSeed(unsigned long seed) {
+  randomEngine.seed(seed);
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+void configTime(int timezone, int daylightOffsetSec, const char* server1, const char* server2, const char* server3) {
+  (void)timezone, (void)daylightOffsetSec, (void)server1, (void)server2, (void)server3;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush() {
+  fflush(stdout);
+}
+
+uint32_t EspClass::random() {
+  uint32_t value = 0;
+  if (getrandom(&value, sizeof(value), 0) != sizeof(value)) {
+    value = randomEngine();
+  }
+  return value;
+}
+
+uint32_t EspClass::getCycleCount() {
+  return (uint32_t)(nowUs() * getCpuFreqMHz());
+}
+
+void EspClass::restart() {
+  fprintf(stderr, "[native] ESP.restart()\n");
+  fflush(stdout);
+  exit(0);
+}
+
+static void requestStop(int signal) {
+  (void)signal;
+  stopRequested = 1;
+}
+
+int main() {
+  realDelay = getenv("NATIVE_REAL_DELAY") != nullptr;
+  tracePins = getenv("NATIVE_TRACE_PINS") != nullptr;
+  const char* loopsText = getenv("NATIVE_LOOPS");
+  uint64_t maxLoops = loopsText ? strtoull(loopsText, nullptr, 10) : 0;
+  signal(SIGINT, requestStop);
+  signal(SIGTERM, requestStop);
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+
+  setup();
+
+  uint64_t loops = 0;
+  uint64_t totalNs = 0;
+  uint64_t worstNs = 0;
+  auto runStart = std::chrono::steady_clock::now();
+  while (!stopRequested && (maxLoops == 0 || loops < maxLoops)) {
+    auto start = std::chrono::steady_clock::now();
+    loop();
+    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    totalNs += ns;
+    worstNs = std::max(worstNs, ns);
+    loops++;
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+
+  fflush(stdout);
+  fprintf(stderr, "\n[native] %llu loop() calls in %.2f s, %.0f per second, mean %.1f us, worst %.1f us\n",
+          (unsigned long long)loops, seconds, loops / seconds, loops ? totalNs / 1000.0 / loops : 0.0,
+          worstNs / 1000.0);
+  return 0;
+}
@@ -0,0 +1,314 @@
+// native_net.cpp
+// WiFi, WiFiClient and the BearSSL client on top of POSIX sockets
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "ESP8266WiFi.h"
+#include "WiFiClientSecureBearSSL.h"
+#include "native_net.h"
+
+ESP8266WiFiClass WiFi;
+
+static const size_t READ_BUFFER_SIZE = 1460; // One TCP segment, PubSubClient reads a byte at a time
+
+// Find "key=value" in a comma separated list, returns false if key is not there
+static bool lookup(const char* list, const char* key, String& value) {
+  if (list == nullptr) {
+    return false;
+  }
+  size_t keyLength = strlen(key);
+  for (const char* entry = list; *entry;) {
+    const char* end = strchr(entry, ',');
+    size_t length = end ? (size_t)(end - entry) : strlen(entry);
+    if (length > keyLength && strncmp(entry, key, keyLength) == 0 && entry[keyLength] == '=') {
+      value = String(entry + keyLength + 1, length - keyLength - 1);
+      return true;
+    }
+    entry += length + (end ? 1 : 0);
+  }
+  return false;
+}
+
+bool nativeResolve(const char* host, IPAddress& address) {
+  String mapped;
+  if (lookup(getenv("NATIVE_HOSTS"), host, mapped)) {
+    host = mapped.c_str();
+  }
+  if (address.fromString(host)) {
+    return true;
+  }
+
+  addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* result = nullptr;
+  if (getaddrinfo(host, nullptr, &hints, &result) != 0 || result == nullptr) {
+    return false;
+  }
+  address = IPAddress((uint32_t)((sockaddr_in*)result->ai_addr)->sin_addr.s_addr);
+  freeaddrinfo(result);
+  return true;
+}
+
+static bool mappedPort(uint16_t port, uint16_t& mapped) {
+  String value;
+  if (!lookup(getenv("NATIVE_PORTS"), String(port).c_str(), value)) {
+    return false;
+  }
+  mapped = value.toInt();
+  return true;
+}
+
+uint16_t nativeClientPort(uint16_t port) {
+  uint16_t mapped;
+  return mappedPort(port, mapped) ? mapped : port;
+}
+
+uint16_t nativeServerPort(uint16_t port) {
+  uint16_t mapped;
+  if (mappedPort(port, mapped)) {
+    return mapped;
+  }
+  return port < 1024 ? port + 8000 : port;
+}
+
+// One TCP connection, shared by every WiFiClient copied from the one that opened it.
+// Reads are buffered and never block, writes block until the data is queued.
+class NativeSocket {
+public:
+  // Connect and send give up after timeoutMs, the client's Stream timeout as on the board
+  NativeSocket(int fd, unsigned long timeoutMs) : fd(fd) {
+    timeval timeout = { (time_t)(timeoutMs / 1000), (suseconds_t)(timeoutMs % 1000 * 1000) };
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+  }
+  ~NativeSocket() { close(); }
+
+  void close() {
+    if (fd >= 0) {
+      ::close(fd);
+      fd = -1;
+    }
+    start = end = 0;
+  }
+
+  // Move whatever the kernel has into the buffer without waiting
+  void fill() {
+    if (fd < 0 || end == sizeof(buffer)) {
+      return;
+    }
+    if (start == end) {
+      start = end = 0;
+    }
+    ssize_t count = recv(fd, buffer + end, sizeof(buffer) - end, MSG_DONTWAIT);
+    if (count > 0) {
+      end += count;
+    } else if (count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+      peerClosed = true;
+    }
+  }
+
+  int fd;
+  bool peerClosed = false;
+  uint8_t buffer[READ_BUFFER_SIZE];
+  size_t start = 0;
+  size_t end = 0;
+};
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+  stop();
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return 0;
+  }
+  socket = std::make_shared<NativeSocket>(fd, timeout); // Sets the send timeout, which also bounds connect()
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(nativeClientPort(port));
+  address.sin_addr.s_addr = (uint32_t)ip;
+  if (::connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+    socket.reset();
+    return 0;
+  }
+  return 1;
+}
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+  IPAddress ip;
+  if (!nativeResolve(host, ip)) {
+    return 0;
+  }
+  return WiFiClient::connect(ip, port);
+}
+
+WiFiClient WiFiClient::fromSocket(int fd) {
+  WiFiClient client;
+  client.socket = std::make_shared<NativeSocket>(fd, client.timeout);
+  return client;
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+  if (!socket || socket->fd < 0) {
+    return 0;
+  }
+  size_t written = 0;
+  while (written < size) {
+    ssize_t count = send(socket->fd, buffer + written, size - written, MSG_NOSIGNAL);
+    if (count <= 0) {
+      if (count < 0 && errno == EINTR) {
+        continue;
+      }
+      socket->peerClosed = true;
+      break;
+    }
+    written += count;
+  }
+  return written;
+}
+
+int WiFiClient::availableForWrite() {
+  if (!connected()) {
+    return 0;
+  }
+  int bufferSize = 0;
+  socklen_t length = sizeof(bufferSize);
+  int queued = 0;
+  if (getsockopt(socket->fd, SOL_SOCKET, SO_SNDBUF, &bufferSize, &length) != 0 ||
+      ioctl(socket->fd, TIOCOUTQ, &queued) != 0) {
+    return 0;
+  }
+  return bufferSize > queued ? bufferSize - queued : 0;
+}
+
+int WiFiClient::available() {
+  if (!socket) {
+    return 0;
+  }
+  socket->fill();
+  return socket->end - socket->start;
+}
+
+int WiFiClient::read() {
+  if (!available()) {
+    return -1;
+  }
+  return socket->buffer[socket->start++];
+}
+
+int WiFiClient::read(uint8_t* buffer, size_t size) {
+  size_t count = std::min<size_t>(available(), size);
+  if (count == 0) {
+    return -1;
+  }
+  memcpy(buffer, socket->buffer + socket->start, count);
+  socket->start += count;
+  return count;
+}
+
+int WiFiClient::peek() {
+  if (!available()) {
+    return -1;
+  }
+  return socket->buffer[socket->start];
+}
+
+void WiFiClient::stop() {
+  if (socket) {
+    socket->close();
+    socket.reset();
+  }
+}
+
+uint8_t WiFiClient::connected() {
+  if (!socket || socket->fd < 0) {
+    return 0;
+  }
+  socket->fill();
+  return !socket->peerClosed || socket->start != socket->end; // Unread data still counts as connected
+}
+
+void WiFiClient::setNoDelay(bool noDelay) {
+  if (socket && socket->fd >= 0) {
+    int value = noDelay;
+    setsockopt(socket->fd, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+  }
+}
+
+static IPAddress socketAddress(int fd, bool peer, uint16_t* port) {
+  sockaddr_in address = {};
+  socklen_t length = sizeof(address);
+  int result = peer ? getpeername(fd, (sockaddr*)&address, &length) : getsockname(fd, (sockaddr*)&address, &length);
+  if (result != 0) {
+    return IPAddress();
+  }
+  if (port != nullptr) {
+    *port = ntohs(address.sin_port);
+  }
+  return IPAddress((uint32_t)address.sin_addr.s_addr);
+}
+
+IPAddress WiFiClient::remoteIP() {
+  return socket ? socketAddress(socket->fd, true, nullptr) : IPAddress();
+}
+
+uint16_t WiFiClient::remotePort() {
+  uint16_t port = 0;
+  if (socket) {
+    socketAddress(socket->fd, true, &port);
+  }
+  return port;
+}
+
+IPAddress WiFiClient::localIP() {
+  return socket ? socketAddress(socket->fd, false, nullptr) : IPAddress();
+}
+
+wl_status_t ESP8266WiFiClass::begin(const char* ssid, const char* passphrase) {
+  (void)passphrase;
+  ssidName = ssid;
+  currentStatus = WL_CONNECTED;
+  return currentStatus;
+}
+
+bool ESP8266WiFiClass::disconnect(bool wifiOff) {
+  (void)wifiOff;
+  currentStatus = WL_DISCONNECTED;
+  return true;
+}
+
+int ESP8266WiFiClass::hostByName(const char* host, IPAddress& address) {
+  return currentStatus == WL_CONNECTED && nativeResolve(host, address) ? 1 : 0;
+}
+
+namespace BearSSL {
+
+int WiFiClientSecure::connect(const char* host, uint16_t port) {
+  int result = WiFiClient::connect(host, port);
+  if (result) {
+    newSession();
+  }
+  return result;
+}
+
+int WiFiClientSecure::connect(IPAddress ip, uint16_t port) {
+  int result = WiFiClient::connect(ip, port);
+  if (result) {
+    newSession();
+  }
+  return result;
+}
+
+void WiFiClientSecure::newSession() {
+  if (session == nullptr) {
+    return;
+  }
+  for (uint8_t& byte : session->id) {
+    byte = ESP.random();
+  }
+}
+
+} // namespace BearSSL
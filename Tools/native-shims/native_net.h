@@ -0,0 +1,16 @@
+// native_net.h
+// Name and port redirection shared by the network shims, not included by the labs
+#ifndef NATIVE_NET_H
+#define NATIVE_NET_H
+
+#include "Arduino.h"
+
+// NATIVE_HOSTS="name=address,..." maps a name to an IPv4 address, other names go to the host resolver
+bool nativeResolve(const char* host, IPAddress& address);
+
+// NATIVE_PORTS="from=to,..." maps a port for outgoing connections and listening sockets.
+// An unmapped listening port below 1024 is moved up by 8000, so port 80 becomes 8080.
+uint16_t nativeClientPort(uint16_t port);
+uint16_t nativeServerPort(uint16_t port);
+
+#endif // NATIVE_NET_H
@@ -0,0 +1,29 @@
+// pgmspace.h
+// Flash is ordinary memory on the host
+#ifndef PGMSPACE_H
+#define PGMSPACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_byte_near(addr) pgm_read_byte(addr)
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define pgm_read_float(addr) (*(const float*)(addr))
+#define pgm_read_ptr(addr) (*(void* const*)(addr))
+#define memcpy_P memcpy
+#define memcmp_P memcmp
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define sprintf_P sprintf
+#define snprintf_P snprintf
+
+#endif // PGMSPACE_H
@@ -0,0 +1,41 @@
+// UriBraces.h
+// Route pattern with {} placeholders, each matching one path segment
+#ifndef URIBRACES_H
+#define URIBRACES_H
+
+#include "../Uri.h"
+
+class UriBraces : public Uri {
+public:
+  explicit UriBraces(const char* uri) : Uri(uri) {}
+  explicit UriBraces(const String& uri) : Uri(uri) {}
+
+  Uri* clone() const override { return new UriBraces(uri); }
+
+  bool canHandle(const String& requestUri, std::vector<String>& pathArgs) override {
+    pathArgs.clear();
+    const char* pattern = uri.c_str();
+    const char* path = requestUri.c_str();
+    while (*pattern) {
+      if (pattern[0] == '{' && pattern[1] == '}') {
+        const char* end = path;
+        while (*end && *end != '/' && *end != pattern[2]) {
+          end++;
+        }
+        pathArgs.push_back(String(path, end - path));
+        path = end;
+        pattern += 2;
+      } else if (*pattern++ != *path++) {
+        pathArgs.clear();
+        return false;
+      }
+    }
+    if (*path) {
+      pathArgs.clear();
+      return false;
+    }
+    return true;
+  }
+};
+
+#endif // URIBRACES_H
@@ -0,0 +1,277 @@
+// Host-side benchmark of Lab 10's control page, the page built in a String against the gzipped
+// PROGMEM page and its 304 revalidation.
+// Builds Lab 10's main.cpp on the native shims and serves GET / through its web server, so the
+// "gzip" and "304" lines measure the handleRoot() the board runs. The "String" line is the
+// handleRoot() Lab 10 had before Tools/web-compiler, rebuilt here on the same lab globals: about
+// 80 String appends, then send(). A client thread requests each page over loopback.
+//
+// For every request it reports the response time (connect to the last byte, on the client) and
+// what the handler did to the heap, counted by wrapping malloc, realloc and free:
+// - heap used: the most the handler had allocated at once, the drop in ESP.getFreeHeap() it causes
+// - largest block: the biggest single allocation, ESP.getMaxFreeBlockSize() must be at least this
+//   for the request to succeed
+// - allocations: every one leaves a hole when freed out of order, which fragments the heap
+// The shims' String sits on top of std::string, which grows geometrically while Arduino's String
+// reallocates on most appends, so the String page's allocation count is a lower bound.
+//
+// Build (from this folder, with PubSubClient and ArduinoJson checked out next to the repository):
+//   g++ -std=gnu++17 -O2 -pthread -D ARDUINOJSON_ENABLE_PROGMEM=0 -I ../native-shims -I ../../Common
+//       -I "../../Lab 10" -I ../../../pubsubclient/src -I ../../../ArduinoJson/src main.cpp
+//       ../native-shims/*.cpp ../../../pubsubclient/src/PubSubClient.cpp -o page-bench
+// Usage:  page-bench > /dev/null
+//         PAGE_BENCH_REQUESTS changes the number of requests per page (default 2000)
+
+#include <malloc.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// The lab's setup() would bring up WiFi and AWS IoT. The bench only needs its globals and
+// handlers, and it exits from its own setup() before loop() ever runs.
+#define setup labSetup
+#include "../../Lab 10/main.cpp"
+#undef setup
+#include "native_net.h"
+
+// Heap use of the handler being measured. Only the server thread is tracked, the client thread
+// does not allocate.
+static thread_local bool tracking = false;
+static int64_t heapUsed = 0; // Bytes allocated since the handler started, less those it freed
+static int64_t heapPeak = 0;
+static size_t largestBlock = 0;
+static uint64_t allocations = 0;
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* block, size_t size);
+extern "C" void __libc_free(void* block);
+
+static void allocated(void* block) {
+  if (!tracking || block == nullptr) {
+    return;
+  }
+  size_t size = malloc_usable_size(block);
+  allocations++;
+  largestBlock = std::max(largestBlock, size);
+  heapUsed += size;
+  heapPeak = std::max(heapPeak, heapUsed);
+}
+
+static void freed(void* block) {
+  if (tracking && block != nullptr) {
+    heapUsed -= malloc_usable_size(block);
+  }
+}
+
+extern "C" void* malloc(size_t size) {
+  void* block = __libc_malloc(size);
+  allocated(block);
+  return block;
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+  void* block = __libc_calloc(count, size);
+  allocated(block);
+  return block;
+}
+
+extern "C" void* realloc(void* block, size_t size) {
+  freed(block);
+  void* moved = __libc_realloc(block, size);
+  allocated(moved);
+  return moved;
+}
+
+extern "C" void free(void* block) {
+  freed(block);
+  __libc_free(block);
+}
+
+// The control page as Lab 10 built it before Tools/web-compiler, on the current relay table
+static void handleRootString() {
+  String console;
+  consoleLog.appendTo(console, 0, consoleLog.next());
+  String html = "<html><head><title>ESP8266 Control</title>";
+  html += "<style>body { font-family: monospace; text-align: center; background-color: #282c34; color: white; }";
+  html += ".container { display: flex; justify-content: center; flex-wrap: wrap; }";
+  html += ".box { padding: 20px; margin: 20px; background-color: #444; border-radius: 10px; }";
+  html += "button { padding: 10px 20px; margin: 10px; font-size: 16px; cursor: pointer; background-color: #888; color: white; border: none; border-radius: 5px; }";
+  html += ".ascii-art { font-size: 12px; line-height: 1; }";
+  html += ".console { margin-top: 20px; padding: 10px; background-color: #333; border-radius: 10px; text-align: left; }";
+  html += "</style></head><body>";
+  html += "<h1>ESP8266 Control</h1>";
+  html += "<pre class='ascii-art'>    _  _\n";
+  html += "  _| || |_ \n";
+  html += " |_  __  _| \n";
+  html += "  _|| || |_ \n";
+  html += " |_  __  _| \n";
+  html += "   |_||_|   </pre>";
+  html += "<div class='container'>";
+  html += "<div class='box'><h2>Relay 1</h2>";
+  html += "<p id='status1'>Relay 1 is " + String(relayOn(0) ? "ON" : "OFF") + "</p>";
+  html += "<button id='onButton1' onclick=\"toggleRelay('relay1', 'on')\">Turn Relay 1 ON</button>";
+  html += "<button id='offButton1' onclick=\"toggleRelay('relay1', 'off')\">Turn Relay 1 OFF</button></div>";
+  html += "<div class='box'><h2>Relay 2</h2>";
+  html += "<p id='status2'>Relay 2 is " + String(relayOn(1) ? "ON" : "OFF") + "</p>";
+  html += "<button id='onButton2' onclick=\"toggleRelay('relay2', 'on')\">Turn Relay 2 ON</button>";
+  html += "<button id='offButton2' onclick=\"toggleRelay('relay2', 'off')\">Turn Relay 2 OFF</button></div>";
+  html += "</div>";
+  html += "<div class='console' id='consoleLog'>" + console + "</div>";
+  html += "<script>";
+  html += "function toggleRelay(relay, action) {";
+  html += "  var xhr = new XMLHttpRequest();";
+  html += "  xhr.open('GET', '/' + relay + '/' + action, true);";
+  html += "  xhr.onreadystatechange = function () {";
+  html += "    if (xhr.readyState == 4 && xhr.status == 200) {";
+  html += "      updateStatus();";
+  html += "      updateConsole();";
+  html += "    }";
+  html += "  };";
+  html += "  xhr.send();";
+  html += "}";
+  html += "function updateStatus() {";
+  html += "  var xhr = new XMLHttpRequest();";
+  html += "  xhr.open('GET', '/status', true);";
+  html += "  xhr.onreadystatechange = function () {";
+  html += "    if (xhr.readyState == 4 && xhr.status == 200) {";
+  html += "      var status = JSON.parse(xhr.responseText);";
+  html += "      document.getElementById('status1').innerHTML = 'Relay 1 is ' + (status.relay1 ? 'ON' : 'OFF');";
+  html += "      document.getElementById('status2').innerHTML = 'Relay 2 is ' + (status.relay2 ? 'ON' : 'OFF');";
+  html += "      document.getElementById('onButton1').classList.toggle('active', status.relay1);";
+  html += "      document.getElementById('offButton1').classList.toggle('active', !status.relay1);";
+  html += "      document.getElementById('onButton2').classList.toggle('active', status.relay2);";
+  html += "      document.getElementById('offButton2').classList.toggle('active', !status.relay2);";
+  html += "    }";
+  html += "  };";
+  html += "  xhr.send();";
+  html += "}";
+  html += "function updateConsole() {";
+  html += "  var xhr = new XMLHttpRequest();";
+  html += "  xhr.open('GET', '/console', true);";
+  html += "  xhr.onreadystatechange = function () {";
+  html += "    if (xhr.readyState == 4 && xhr.status == 200) {";
+  html += "      document.getElementById('consoleLog').innerHTML = xhr.responseText;";
+  html += "    }";
+  html += "  };";
+  html += "  xhr.send();";
+  html += "}";
+  html += "setInterval(updateStatus, 1000);";
+  html += "setInterval(updateConsole, 1000);";
+  html += "</script>";
+  html += "</body></html>";
+  server.send(200, "text/html", html);
+}
+
+struct PageResult {
+  std::vector<uint32_t> responseUs; // Per request, from connect to the last byte
+  size_t bodyBytes = 0; // Of the last response
+  int status = 0; // Of the last response
+  int64_t heapPeak = 0; // Worst request
+  size_t largestBlock = 0; // Worst request
+  uint64_t allocations = 0; // All requests
+};
+
+// Run a route handler with its heap use tracked
+static void tracked(void (*handler)(), PageResult& result) {
+  heapUsed = heapPeak = 0;
+  largestBlock = 0;
+  uint64_t allocationsBefore = allocations;
+  tracking = true;
+  handler();
+  tracking = false;
+  result.heapPeak = std::max(result.heapPeak, heapPeak);
+  result.largestBlock = std::max(result.largestBlock, largestBlock);
+  result.allocations += allocations - allocationsBefore;
+}
+
+// Send one request and read the response until the server closes the connection, without
+// touching the heap. Returns the response time in microseconds.
+static uint32_t fetch(uint16_t port, const char* request, PageResult& result) {
+  static char response[16384];
+  auto start = std::chrono::steady_clock::now();
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+    fprintf(stderr, "page-bench: cannot connect to port %u\n", port);
+    exit(1);
+  }
+  send(fd, request, strlen(request), 0);
+  size_t length = 0;
+  ssize_t count;
+  while ((count = recv(fd, response + length, sizeof(response) - 1 - length, 0)) > 0) {
+    length += count;
+  }
+  close(fd);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  response[length] = 0;
+  const char* body = strstr(response, "\r\n\r\n");
+  result.bodyBytes = body ? response + length - (body + 4) : 0;
+  result.status = length > 12 ? atoi(response + 9) : 0;
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+// Request a page the given number of times while this thread serves them
+static void runPage(const char* request, uint32_t requests, PageResult& result) {
+  std::atomic<bool> done(false);
+  uint16_t port = nativeServerPort(80);
+  std::thread client([&]() {
+    for (uint32_t i = 0; i < requests; i++) {
+      result.responseUs[i] = fetch(port, request, result);
+    }
+    done = true;
+  });
+  while (!done) {
+    server.handleClient();
+  }
+  client.join();
+}
+
+static uint32_t percentile(std::vector<uint32_t> values, double p) {
+  std::sort(values.begin(), values.end());
+  size_t rank = (size_t)(p / 100 * values.size() + 0.999999);
+  return values[rank > 0 ? rank - 1 : 0];
+}
+
+void setup() {
+  const char* text = getenv("PAGE_BENCH_REQUESTS");
+  uint32_t requests = text ? strtoul(text, nullptr, 10) : 2000;
+
+  // A full console, as after a while of use
+  for (size_t i = 0; i < CONSOLE_LINES; i++) {
+    consoleLog.add("relay" + String(i % 2 + 1) + " turned " + (i % 4 < 2 ? "ON" : "OFF") + " from the web");
+  }
+
+  static PageResult stringPage, gzipPage, revalidated;
+  for (PageResult* result : { &stringPage, &gzipPage, &revalidated }) {
+    result->responseUs.resize(requests);
+  }
+  server.on("/string", []() { tracked(handleRootString, stringPage); });
+  server.on("/", []() { tracked(handleRoot, server.hasHeader("If-None-Match") ? revalidated : gzipPage); });
+  server.begin();
+
+  runPage("GET /string HTTP/1.1\r\nHost: bench\r\n\r\n", requests, stringPage);
+  runPage("GET / HTTP/1.1\r\nHost: bench\r\nAccept-Encoding: gzip\r\n\r\n", requests, gzipPage);
+  runPage("GET / HTTP/1.1\r\nHost: bench\r\nIf-None-Match: " INDEX_HTML_ETAG "\r\n\r\n", requests, revalidated);
+  fflush(stdout);
+
+  fprintf(stderr, "%u requests each\n\n", requests);
+  fprintf(stderr, "%-8s %6s %10s %10s %10s %12s %14s %12s\n", "", "status", "body B", "p50 us", "p99 us",
+          "heap used B", "largest blk B", "allocs/req");
+  const char* names[] = { "String", "gzip", "304" };
+  PageResult* results[] = { &stringPage, &gzipPage, &revalidated };
+  for (int i = 0; i < 3; i++) {
+    PageResult& result = *results[i];
+    fprintf(stderr, "%-8s %6d %10zu %10u %10u %12lld %14zu %12.1f\n", names[i], result.status, result.bodyBytes,
+            percentile(result.responseUs, 50), percentile(result.responseUs, 99), (long long)result.heapPeak,
+            result.largestBlock, (double)result.allocations / requests);
+  }
+  exit(0);
+}
@@ -0,0 +1,131 @@
+// Host-side benchmark of the Lab 11 telemetry payloads.
+// Encodes batches of 1 to 64 samples with the firmware's own encoders (Lab 11/telemetry_encoder.h),
+// as JSON and as CBOR, and reports the message size, the bytes per sample and the encode time.
+// The first line is the flat single-sample object Lab 11 sends with batching off.
+//
+// The samples hold the same ranges as Lab 11's dummy sensors. Encode times are host times, so
+// only the ratio between the formats carries over to the ESP8266, where float formatting in
+// JSON is slower still without an FPU.
+//
+// Build:  g++ -std=c++11 -O2 -I"../../Lab 11" -I path/to/ArduinoJson/src main.cpp -o payload-bench
+// Usage:  payload-bench [-s] [ITERATIONS]    (default: 20000 encodes per line)
+//         -s: sparse rows, as with DEADBAND_ENABLED, with half the fields changed per sample
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+
+#include "telemetry_encoder.h"
+
+static const size_t MAX_SAMPLES = 64;
+static const size_t BUFFER_SIZE = 512 + MAX_SAMPLES * 160; // Room for the largest JSON batch
+
+// Range of each field, in SensorField order, as generated by Lab 11's dummy sensors
+struct FieldRange {
+  int32_t low;
+  int32_t high;
+  float divisor;
+};
+
+static const FieldRange fieldRanges[FIELD_COUNT] = {
+  { 1500, 3500, 100 }, // Temperature
+  { 3000, 7000, 100 }, // Humidity
+  { 90000, 110000, 100 }, // Pressure
+  { 50, 300, 1 }, // AirQuality
+  { 400, 2000, 1 }, // CO2
+  { 0, 500, 1 }, // VOC
+  { 0, 10000, 1 }, // Light
+  { 30, 100, 1 }, // Noise
+};
+
+static SensorSample samples[MAX_SAMPLES];
+static char jsonBuffer[BUFFER_SIZE];
+static uint8_t cborBuffer[BUFFER_SIZE];
+static volatile size_t sink; // Keeps the compiler from dropping the encodes
+
+static void makeSamples(bool sparse) {
+  std::mt19937 random(42);
+  for (size_t i = 0; i < MAX_SAMPLES; i++) {
+    SensorSample& sample = samples[i];
+    sample.timestamp = 1760700000 + i * 60;
+    sample.takenAtMs = i * 60000;
+    sample.fieldMask = (1 << FIELD_COUNT) - 1;
+    for (int f = 0; f < FIELD_COUNT; f++) {
+      const FieldRange& range = fieldRanges[f];
+      sample.values[f] = (range.low + (int32_t)(random() % (range.high - range.low))) / range.divisor;
+      if (sparse && (random() & 1)) {
+        sample.fieldMask &= ~(1 << f);
+      }
+    }
+  }
+}
+
+// Average time of one call of encode, in microseconds
+template <typename Encode>
+static double timeEncode(uint32_t iterations, Encode encode) {
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; i++) {
+    sink = encode();
+  }
+  std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / iterations;
+}
+
+static void printFormat(size_t length, size_t count, double us) {
+  if (length == 0) {
+    printf(" %8s %8s %8s", "-", "-", "-"); // Did not fit, or encoded by a stand-in ArduinoJson
+  } else {
+    printf(" %8zu %8.1f %8.2f", length, (double)length / count, us);
+  }
+}
+
+static void printLine(const char* label, size_t count, size_t jsonLength, double jsonUs, size_t cborLength,
+                      double cborUs) {
+  printf("%-7s", label);
+  printFormat(jsonLength, count, jsonUs);
+  printFormat(cborLength, count, cborUs);
+  if (jsonLength > 0 && cborLength > 0) {
+    printf(" %7.0f%%", 100.0 * cborLength / jsonLength);
+  }
+  printf("\n");
+}
+
+int main(int argc, char** argv) {
+  bool sparse = false;
+  uint32_t iterations = 20000;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-s") == 0) {
+      sparse = true;
+    } else if ((iterations = strtoul(argv[i], nullptr, 10)) == 0) {
+      fprintf(stderr, "usage: payload-bench [-s] [ITERATIONS]\n");
+      return 2;
+    }
+  }
+
+  makeSamples(sparse);
+  TelemetryEncoder encoder("ESP8266-01", sparse);
+  printf("%u encodes per line, %s rows\n\n", iterations, sparse ? "sparse" : "full");
+  printf("%-7s %8s %8s %8s %8s %8s %8s %8s\n", "", "JSON", "B/sample", "us", "CBOR", "B/sample", "us",
+         "CBOR/JSON");
+
+  size_t jsonLength = encoder.sampleJson(samples[0], jsonBuffer, sizeof(jsonBuffer));
+  size_t cborLength = encoder.sampleCbor(samples[0], cborBuffer, sizeof(cborBuffer));
+  double jsonUs = timeEncode(iterations, [&] { return encoder.sampleJson(samples[0], jsonBuffer, sizeof(jsonBuffer)); });
+  double cborUs = timeEncode(iterations, [&] { return encoder.sampleCbor(samples[0], cborBuffer, sizeof(cborBuffer)); });
+  printLine("single", 1, jsonLength, jsonUs, cborLength, cborUs);
+
+  for (size_t count = 1; count <= MAX_SAMPLES; count *= 2) {
+    jsonLength = encoder.batchJson(samples, count, jsonBuffer, sizeof(jsonBuffer));
+    cborLength = encoder.batchCbor(samples, count, cborBuffer, sizeof(cborBuffer));
+    uint32_t batchIterations = iterations / count > 100 ? iterations / count : 100;
+    jsonUs = timeEncode(batchIterations, [&] { return encoder.batchJson(samples, count, jsonBuffer, sizeof(jsonBuffer)); });
+    cborUs = timeEncode(batchIterations, [&] { return encoder.batchCbor(samples, count, cborBuffer, sizeof(cborBuffer)); });
+    char label[16];
+    snprintf(label, sizeof(label), "x%zu", count);
+    printLine(label, count, jsonLength, jsonUs, cborLength, cborUs);
+  }
+  return 0;
+}
@@ -0,0 +1,149 @@
+// Host-side simulation of a fleet reconnecting after a broker outage.
+// Compares the old fixed 5 s retry with the exponential backoff and full jitter from
+// backoff.h, using the same Backoff class as the firmware.
+//
+// Every board loses the broker at t = 0. The broker is down for OUTAGE seconds and afterwards
+// completes at most CAPACITY connections per second; attempts beyond that fail like a TLS
+// endpoint that is being hammered.
+//
+// Build:  g++ -std=c++11 -O2 -I../../Common main.cpp -o reconnect-sim
+// Usage:  reconnect-sim [DEVICES [OUTAGE_S [CAPACITY_PER_S]]]    (defaults: 500 30 50)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <functional>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "backoff.h"
+
+static const uint32_t FIXED_RETRY_MS = 5000; // The old connectAWS() cadence
+static const uint32_t BACKOFF_BASE_MS = 1000; // Same values as the labs
+static const uint32_t BACKOFF_CAP_MS = 60000;
+static const uint32_t SIMULATION_LIMIT_MS = 3600000; // Stop after an hour
+
+struct Result {
+  std::vector<uint32_t> attemptsPerSecond;
+  std::vector<uint32_t> attemptsPerTick; // 100 ms buckets, shows how synchronized the attempts are
+  uint32_t totalAttempts = 0;
+  uint32_t attemptsAfterOutage = 0; // Load on the broker while it recovers
+  uint32_t allConnectedMs = 0; // 0 if some boards never got through
+};
+
+struct Attempt {
+  uint32_t timeMs;
+  uint32_t device;
+  bool operator>(const Attempt& other) const { return timeMs > other.timeMs; }
+};
+
+// Run the fleet with one retry policy. nextDelay(device, failed) returns the wait before the
+// next attempt: failed is false for the first attempt after the outage starts.
+static Result simulate(uint32_t devices, uint32_t outageMs, uint32_t capacity,
+                       std::function<uint32_t(uint32_t, bool)> nextDelay) {
+  Result result;
+  std::priority_queue<Attempt, std::vector<Attempt>, std::greater<Attempt>> attempts;
+  for (uint32_t d = 0; d < devices; d++) {
+    attempts.push({ nextDelay(d, false), d });
+  }
+
+  std::vector<uint32_t> acceptedPerSecond;
+  uint32_t connected = 0;
+  while (!attempts.empty()) {
+    Attempt attempt = attempts.top();
+    attempts.pop();
+    if (attempt.timeMs >= SIMULATION_LIMIT_MS) {
+      break;
+    }
+
+    uint32_t second = attempt.timeMs / 1000;
+    if (result.attemptsPerSecond.size() <= second) {
+      result.attemptsPerSecond.resize(second + 1, 0);
+      acceptedPerSecond.resize(second + 1, 0);
+    }
+    uint32_t tick = attempt.timeMs / 100;
+    if (result.attemptsPerTick.size() <= tick) {
+      result.attemptsPerTick.resize(tick + 1, 0);
+    }
+    result.attemptsPerSecond[second]++;
+    result.attemptsPerTick[tick]++;
+    result.totalAttempts++;
+    if (attempt.timeMs >= outageMs) {
+      result.attemptsAfterOutage++;
+    }
+
+    if (attempt.timeMs >= outageMs && acceptedPerSecond[second] < capacity) {
+      acceptedPerSecond[second]++;
+      if (++connected == devices) {
+        result.allConnectedMs = attempt.timeMs;
+      }
+    } else {
+      attempts.push({ attempt.timeMs + nextDelay(attempt.device, true), attempt.device });
+    }
+  }
+  return result;
+}
+
+static uint32_t peak(const std::vector<uint32_t>& values) {
+  uint32_t highest = 0;
+  for (uint32_t value : values) {
+    highest = value > highest ? value : highest;
+  }
+  return highest;
+}
+
+static void printSummary(const char* name, const Result& result) {
+  printf("%-16s %6u attempts (%5u after the outage), peak %4u per 100 ms, ", name, result.totalAttempts,
+         result.attemptsAfterOutage, peak(result.attemptsPerTick));
+  if (result.allConnectedMs) {
+    printf("all connected after %.1f s\n", result.allConnectedMs / 1000.0);
+  } else {
+    printf("not all connected within %u s\n", SIMULATION_LIMIT_MS / 1000);
+  }
+}
+
+int main(int argc, char** argv) {
+  uint32_t devices = argc > 1 ? strtoul(argv[1], nullptr, 10) : 500;
+  uint32_t outageMs = (argc > 2 ? strtoul(argv[2], nullptr, 10) : 30) * 1000;
+  uint32_t capacity = argc > 3 ? strtoul(argv[3], nullptr, 10) : 50;
+  if (devices == 0 || capacity == 0 || argc > 4) {
+    fprintf(stderr, "usage: reconnect-sim [DEVICES [OUTAGE_S [CAPACITY_PER_S]]]\n");
+    return 2;
+  }
+
+  // Fixed cadence: retry at once, then every 5 s, as connectAWS() did
+  Result fixed = simulate(devices, outageMs, capacity, [](uint32_t, bool failed) {
+    return failed ? FIXED_RETRY_MS : 0;
+  });
+
+  // Backoff: one Backoff per board and a per-board random source, like ESP.random()
+  std::mt19937 random(1);
+  std::vector<Backoff> backoffs(devices, Backoff(BACKOFF_BASE_MS, BACKOFF_CAP_MS));
+  Result jittered = simulate(devices, outageMs, capacity, [&](uint32_t device, bool) {
+    return backoffs[device].next(random());
+  });
+
+  printf("%u boards, %u s outage, broker accepts %u connections/s\n\n", devices, outageMs / 1000, capacity);
+  printSummary("fixed 5 s", fixed);
+  printSummary("backoff+jitter", jittered);
+
+  // Attempts per 5 s bucket
+  size_t seconds = fixed.attemptsPerSecond.size();
+  if (jittered.attemptsPerSecond.size() > seconds) {
+    seconds = jittered.attemptsPerSecond.size();
+  }
+  fixed.attemptsPerSecond.resize(seconds, 0);
+  jittered.attemptsPerSecond.resize(seconds, 0);
+
+  printf("\n  time    fixed  backoff\n");
+  for (size_t start = 0; start < seconds && start < 300; start += 5) {
+    uint32_t fixedCount = 0, jitteredCount = 0;
+    for (size_t s = start; s < start + 5 && s < seconds; s++) {
+      fixedCount += fixed.attemptsPerSecond[s];
+      jitteredCount += jittered.attemptsPerSecond[s];
+    }
+    printf("%5zus %8u %8u\n", start, fixedCount, jitteredCount);
+  }
+  return 0;
+}
@@ -0,0 +1,194 @@
+// Host-side check of Lab 10 with a 16-row relay table, the most it supports.
+// Builds Lab 10's main.cpp on the native shims with relay_table.h from this folder in place of
+// its own two rows, and drives every relay through each path that carries relay state: MQTT
+// commands, a shadow delta, the web and the shadow resync after a connect. The outbox is drained
+// by a stand-in broker that acknowledges everything it gets.
+//
+// Checks that every relay is found by name and switched, that each status and shadow update fits
+// the outbox and parses, that the updates together cover every relay with its current state, that
+// a full AWS delta fits the MQTT buffer, and that nothing was dropped on the way.
+// Exits with 1 on the first failed check.
+//
+// Build (from this folder, with PubSubClient and ArduinoJson checked out next to the repository):
+//   g++ -std=gnu++17 -O2 -D ARDUINOJSON_ENABLE_PROGMEM=0 -I . -I ../native-shims -I ../../Common
+//       -I "../../Lab 10" -I ../../../pubsubclient/src -I ../../../ArduinoJson/src main.cpp
+//       ../native-shims/*.cpp ../../../pubsubclient/src/PubSubClient.cpp -o relay-check
+// Usage:  relay-check > /dev/null
+
+#include <map>
+#include <string>
+
+// The lab's setup() would bring up WiFi and AWS IoT. The check only needs its globals and
+// handlers, and it exits from its own setup() before loop() ever runs.
+#define setup labSetup
+#include "../../Lab 10/main.cpp"
+#undef setup
+
+static_assert(RELAY_COUNT == 16, "relay_table.h from this folder must replace the lab's table, build with -I .");
+
+// What the stand-in broker has seen, by relay name
+static std::map<std::string, std::string> statusSeen; // Last status on statusTopic
+static std::map<std::string, std::string> shadowSeen; // Last state reported to the shadow
+static uint32_t messagesSeen = 0;
+static uint32_t largestPayload = 0;
+
+static void fail(const char* check, const std::string& detail) {
+  fflush(stdout);
+  fprintf(stderr, "FAIL %s: %s\n", check, detail.c_str());
+  exit(1);
+}
+
+// Function to take one message from the outbox, as the broker would
+static void receive(const char* topic, const uint8_t* payload, size_t length) {
+  std::string text((const char*)payload, length);
+  messagesSeen++;
+  if (length > largestPayload) {
+    largestPayload = length;
+  }
+  if (length >= OUTBOX_MAX_PAYLOAD) {
+    fail("payload size", text);
+  }
+
+  StaticJsonDocument<JSON_OBJECT_SIZE(5) + 2 * JSON_OBJECT_SIZE(1) + JSON_OBJECT_SIZE(RELAY_COUNT)> doc;
+  DeserializationError error = deserializeJson(doc, text.c_str(), length);
+  if (error) {
+    fail("payload JSON", text + " (" + error.c_str() + ")");
+  }
+
+  if (strcmp(topic, statusTopic) == 0) {
+    const char* relay = doc["relay"];
+    const char* status = doc["status"];
+    if (relay == nullptr || status == nullptr) {
+      fail("status fields", text);
+    }
+    statusSeen[relay] = status;
+  } else if (strcmp(topic, shadowUpdateTopic) == 0) {
+    JsonObject reported = doc["state"]["reported"];
+    if (reported.isNull() || reported.size() == 0) {
+      fail("shadow report", text);
+    }
+    for (JsonPair field : reported) {
+      shadowSeen[field.key().c_str()] = field.value().as<const char*>();
+    }
+  }
+}
+
+// Function to send what the outbox has and acknowledge it, until it is empty
+static void drainOutbox() {
+  while (wifiClient.outbox.depth() > 0) {
+    uint16_t packetIds[OUTBOX_CAPACITY];
+    size_t sent = 0;
+    wifiClient.outbox.service(millis(), [&](const decltype(wifiClient)::Outbox::Message& message, bool dup) {
+      receive(message.topic, message.payload, message.length);
+      packetIds[sent++] = message.packetId;
+      return true;
+    });
+    if (sent == 0) {
+      fail("outbox", "messages queued but none sent");
+    }
+    for (size_t i = 0; i < sent; i++) {
+      wifiClient.outbox.acknowledge(packetIds[i], millis());
+    }
+  }
+}
+
+// Function to run the publishing part of loop() until every channel is up to date. The broker
+// answers between passes, and time moves on by one publish window per pass.
+static void settle() {
+  for (int pass = 0; pass < 64; pass++) {
+    publishRelayChanges();
+    drainOutbox();
+    bool pending = shadowResync;
+    for (int channel : { CHANNEL_MQTT, CHANNEL_SHADOW }) {
+      for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+        pending = pending || relayEpoch[i] != channelSync[channel].syncedEpoch[i];
+      }
+    }
+    if (!pending) {
+      return;
+    }
+    delay(RELAY_PUBLISH_WINDOW_MS);
+  }
+  fail("settle", "relay changes still pending after 64 passes");
+}
+
+// Function to check that every relay is in the given state, and that the broker saw it in seen
+static void expectState(const char* check, bool on, const std::map<std::string, std::string>* seen) {
+  for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+    if (relayOn(i) != on) {
+      fail(check, std::string(relays[i].name) + " was not switched " + (on ? "on" : "off"));
+    }
+    if (seen != nullptr) {
+      auto state = seen->find(relays[i].name);
+      if (state == seen->end() || state->second != (on ? "ON" : "OFF")) {
+        fail(check, std::string(relays[i].name) + " not reported " + (on ? "ON" : "OFF"));
+      }
+    }
+  }
+  if (wifiClient.outbox.dropped != 0) {
+    fail(check, std::to_string(wifiClient.outbox.dropped) + " messages dropped by the outbox");
+  }
+  fprintf(stderr, "ok   %s\n", check);
+}
+
+// Function to hand a message to the lab's MQTT callback, from a buffer it may parse in place
+static void deliver(const char* topic, const std::string& payload) {
+  char topicBuffer[96];
+  strcpy(topicBuffer, topic);
+  std::string copy = payload;
+  messageReceived(topicBuffer, (byte*)&copy[0], copy.size());
+}
+
+void setup() {
+  for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+    if (relayIndex.find(relays[i].name) != i) {
+      fail("relay names", std::string(relays[i].name) + " not found");
+    }
+  }
+  fprintf(stderr, "ok   relay names\n");
+
+  // A connect reports every relay to the shadow
+  connection.state = CONN_READY;
+  shadowResync = true;
+  settle();
+  expectState("shadow resync", false, &shadowSeen);
+
+  // MQTT commands switch each relay, the shadow is told and MQTT is not echoed
+  for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+    deliver(controlTopic, std::string("{\"relay\": \"") + relays[i].name + "\", \"status\": \"ON\"}");
+  }
+  settle();
+  expectState("MQTT commands", true, &shadowSeen);
+  if (!statusSeen.empty()) {
+    fail("MQTT commands", "a command was echoed on the status topic");
+  }
+
+  // A delta as AWS sends it, with metadata for every relay, turns them all off
+  std::string state, metadata;
+  for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+    state += std::string(i ? ", " : "") + "\"" + relays[i].name + "\": \"OFF\"";
+    metadata += std::string(i ? ", " : "") + "\"" + relays[i].name + "\": {\"timestamp\": 1700000000}";
+  }
+  std::string delta = "{\"version\": 7, \"timestamp\": 1700000000, \"state\": {" + state + "}, \"metadata\": {" + metadata + "}}";
+  size_t packet = 5 + 2 + strlen(shadowDeltaTopic) + delta.size(); // Header, topic length, topic and payload
+  if (packet > MQTT_BUFFER_SIZE) {
+    fail("shadow delta", std::to_string(packet) + " byte delta does not fit the " + std::to_string(MQTT_BUFFER_SIZE) + " byte MQTT buffer");
+  }
+  deliver(shadowDeltaTopic, delta);
+  settle();
+  expectState("shadow delta", false, &statusSeen);
+  expectState("shadow delta reported", false, &shadowSeen);
+
+  // The web reaches every relay through setRelay(), and both MQTT and the shadow hear about it
+  for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+    setRelay(i, true, FROM_WEB);
+  }
+  settle();
+  expectState("web", true, &statusSeen);
+  expectState("web reported", true, &shadowSeen);
+
+  fflush(stdout);
+  fprintf(stderr, "\n%u relays, %u messages, largest payload %u of %u bytes, %u byte delta in a %u byte MQTT buffer\n",
+          RELAY_COUNT, messagesSeen, largestPayload, (unsigned)OUTBOX_MAX_PAYLOAD - 1, (unsigned)packet, MQTT_BUFFER_SIZE);
+  exit(0);
+}
@@ -0,0 +1,27 @@
+// relay_table.h
+// 16-row relay table for Tools/relay-check, the most relayStates can hold. Lab 10 uses it in
+// place of its own table when it is on the include path. The board has fewer free GPIOs than
+// this, the pins only matter to the native shims here.
+#ifndef RELAY_TABLE_H
+#define RELAY_TABLE_H
+
+constexpr Relay relays[] = {
+  { 0, LOW, V0, "relay1" },
+  { 1, LOW, V1, "relay2" },
+  { 2, LOW, V2, "relay3" },
+  { 3, LOW, V3, "relay4" },
+  { 4, LOW, V4, "relay5" },
+  { 5, LOW, V5, "relay6" },
+  { 6, LOW, V6, "relay7" },
+  { 7, LOW, V7, "relay8" },
+  { 8, LOW, V8, "relay9" },
+  { 9, LOW, V9, "relay10" },
+  { 10, LOW, V10, "relay11" },
+  { 11, LOW, V11, "relay12" },
+  { 12, LOW, V12, "relay13" },
+  { 13, LOW, V13, "relay14" },
+  { 14, LOW, V14, "relay15" },
+  { 15, LOW, V15, "relay16" },
+};
+
+#endif // RELAY_TABLE_H
@@ -0,0 +1,343 @@
+// Host-side decoder for the Lab 11 CBOR telemetry payload (PAYLOAD_FORMAT_CBOR).
+// Converts a binary payload back into the same JSON the device sends in JSON mode, using
+// the field keys and scales from Lab 11/telemetry_schema.h so both sides stay in sync: a
+// single sample becomes a flat object, a batch keeps its "fields" list and array rows, and
+// a window summary gets one {"n", "min", "max", "mean", "stddev"} object per metric.
+// The layout is taken from the payload's KEY_SHAPE, never guessed from the other keys: a
+// payload without a shape, with a shape this schema does not know, or with a key that does
+// not belong to its shape is rejected.
+//
+// Build:  g++ -std=c++11 -O2 -I"../../Lab 11" main.cpp -o telemetry-decoder
+// Usage:  telemetry-decoder [payload.cbor]     (reads stdin when no file is given)
+//         telemetry-decoder -x "a2 00 6a ..."  (payload given as hex, e.g. copied from a log)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "telemetry_schema.h"
+
+// Sequential reader over a CBOR buffer
+class CborReader {
+public:
+  CborReader(const std::vector<uint8_t>& data) : data(data) {}
+
+  // Read an item head, returns false at the end of the data or on an unsupported item
+  bool readHead(uint8_t& major, uint64_t& value) {
+    if (pos >= data.size()) {
+      return false;
+    }
+    uint8_t initial = data[pos++];
+    major = initial >> 5;
+    uint8_t info = initial & 0x1f;
+    if (info < 24) {
+      value = info;
+      return true;
+    }
+    int bytes = info == 24 ? 1 : info == 25 ? 2 : info == 26 ? 4 : info == 27 ? 8 : 0;
+    if (bytes == 0 || pos + bytes > data.size()) {
+      return false; // Indefinite lengths are never produced by the device
+    }
+    value = 0;
+    for (int i = 0; i < bytes; i++) {
+      value = (value << 8) | data[pos++];
+    }
+    return true;
+  }
+
+  bool readText(uint64_t length, std::string& text) {
+    if (pos + length > data.size()) {
+      return false;
+    }
+    text.assign((const char*)&data[pos], length);
+    pos += length;
+    return true;
+  }
+
+  bool done() const { return pos == data.size(); }
+
+private:
+  const std::vector<uint8_t>& data;
+  size_t pos = 0;
+};
+
+static void fail(const char* message) {
+  fprintf(stderr, "telemetry-decoder: %s\n", message);
+  exit(1);
+}
+
+static const FieldInfo* fieldByKey(uint64_t key) {
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    if (fieldInfo[i].key == key) {
+      return &fieldInfo[i];
+    }
+  }
+  return nullptr;
+}
+
+// Read an integer or null item, returns false for null
+static bool readNumber(CborReader& reader, int64_t& number) {
+  uint8_t major;
+  uint64_t value;
+  if (!reader.readHead(major, value)) {
+    fail("truncated payload");
+  }
+  if (major == 0) {
+    number = (int64_t)value;
+  } else if (major == 1) {
+    number = -1 - (int64_t)value;
+  } else if (major == 7 && value == 22) {
+    return false;
+  } else {
+    fail("expected an integer");
+  }
+  return true;
+}
+
+static void printValue(CborReader& reader, const FieldInfo& field) {
+  int64_t raw;
+  if (!readNumber(reader, raw)) {
+    printf("null");
+  } else if (field.scale == 1) {
+    printf("%lld", (long long)raw);
+  } else {
+    printf("%.*f", field.scale >= 100 ? 2 : 1, (double)raw / field.scale);
+  }
+}
+
+static void printField(CborReader& reader, const FieldInfo& field) {
+  printf("\"%s\":", field.name);
+  printValue(reader, field);
+}
+
+// Read an integer that may not be null, such as a timestamp or a count
+static int64_t readRequired(CborReader& reader, const char* what) {
+  int64_t number;
+  if (!readNumber(reader, number)) {
+    fprintf(stderr, "telemetry-decoder: missing %s\n", what);
+    exit(1);
+  }
+  return number;
+}
+
+// Batch row: [timestamp, field 0, field 1, ...]
+// Sparse row: [timestamp, field mask, fields whose bit is set...]
+// Printed as the same array the device sends in JSON mode
+static void printRow(CborReader& reader, bool sparse) {
+  uint8_t major;
+  uint64_t items;
+  if (!reader.readHead(major, items) || major != 4) {
+    fail("malformed sample row");
+  }
+  printf("[%lld", (long long)readRequired(reader, "timestamp"));
+
+  int64_t mask = (1 << FIELD_COUNT) - 1;
+  uint64_t expected = 1 + FIELD_COUNT;
+  if (sparse) {
+    if (!readNumber(reader, mask) || mask < 0 || mask >= (1 << FIELD_COUNT)) {
+      fail("malformed field mask");
+    }
+    expected = 2 + __builtin_popcount((unsigned)mask);
+    printf(",%lld", (long long)mask);
+  }
+  if (items != expected) {
+    fail("sample row length does not match its fields");
+  }
+
+  for (int f = 0; f < FIELD_COUNT; f++) {
+    if (mask & (1 << f)) {
+      printf(",");
+      printValue(reader, fieldInfo[f]);
+    }
+  }
+  printf("]");
+}
+
+// Whether a payload of the given shape may carry key, KEY_DEVICE_ID and KEY_SHAPE aside
+static bool keyInShape(int shape, uint64_t key) {
+  switch (shape) {
+    case SHAPE_SAMPLE:
+      return key == KEY_TIMESTAMP || fieldByKey(key) != nullptr;
+    case SHAPE_BATCH:
+      return key == KEY_SAMPLES;
+    case SHAPE_SPARSE_BATCH:
+      return key == KEY_SPARSE_SAMPLES;
+    case SHAPE_WINDOW:
+      return key == KEY_WINDOW_START || key == KEY_WINDOW_S || key == KEY_WINDOW_STATS;
+    default:
+      return false;
+  }
+}
+
+// Window statistics map: {field key: [n, min, max, mean, stddev], ...}
+// Printed as one object per metric at the top level, as the device does in JSON mode
+static void printWindowStats(CborReader& reader) {
+  uint8_t major;
+  uint64_t fields;
+  if (!reader.readHead(major, fields) || major != 5) {
+    fail("malformed window statistics map");
+  }
+  static const char* const names[] = { "n", "min", "max", "mean", "stddev" };
+  for (uint64_t i = 0; i < fields; i++) {
+    uint64_t key;
+    uint64_t items;
+    if (!reader.readHead(major, key) || major != 0) {
+      fail("expected an integer key");
+    }
+    const FieldInfo* field = fieldByKey(key);
+    if (!field) {
+      fail("unknown key, is telemetry_schema.h out of date?");
+    }
+    if (!reader.readHead(major, items) || major != 4 || items != 5) {
+      fail("malformed window statistics row");
+    }
+    if (i > 0) {
+      printf(",");
+    }
+    printf("\"%s\":{\"n\":%lld", field->name, (long long)readRequired(reader, "window count"));
+    for (int s = 1; s < 5; s++) {
+      printf(",\"%s\":", names[s]);
+      printValue(reader, *field);
+    }
+    printf("}");
+  }
+}
+
+static void decode(const std::vector<uint8_t>& data) {
+  CborReader reader(data);
+  uint8_t major;
+  uint64_t pairs;
+  if (!reader.readHead(major, pairs) || major != 5) {
+    fail("payload is not a CBOR map");
+  }
+
+  int shape = -1; // PayloadShape, set once KEY_SHAPE has been read
+  printf("{");
+  for (uint64_t i = 0; i < pairs; i++) {
+    uint64_t key;
+    if (!reader.readHead(major, key) || major != 0) {
+      fail("expected an integer key");
+    }
+    if (i > 0) {
+      printf(",");
+    }
+    if (key != KEY_DEVICE_ID && key != KEY_SHAPE) {
+      if (shape < 0) {
+        fail("payload has no shape, sent by firmware older than the shape key?");
+      }
+      if (!keyInShape(shape, key)) {
+        fail(fieldByKey(key) || key <= KEY_SHAPE ? "key does not belong to the payload's shape"
+                                                 : "unknown key, is telemetry_schema.h out of date?");
+      }
+    }
+
+    if (key == KEY_DEVICE_ID) {
+      uint64_t length;
+      std::string text;
+      if (!reader.readHead(major, length) || major != 3 || !reader.readText(length, text)) {
+        fail("malformed device_id");
+      }
+      printf("\"device_id\":\"%s\"", text.c_str());
+    } else if (key == KEY_SHAPE) {
+      uint64_t value;
+      if (shape >= 0 || !reader.readHead(major, value) || major != 0) {
+        fail("malformed shape");
+      }
+      if (value >= SHAPE_COUNT) {
+        fail("unknown shape, is telemetry_schema.h out of date?");
+      }
+      shape = (int)value;
+      printf("\"shape\":\"%s\"", shapeNames[shape]);
+    } else if (key == KEY_TIMESTAMP) {
+      printf("\"timestamp\":%lld", (long long)readRequired(reader, "timestamp"));
+    } else if (key == KEY_SAMPLES || key == KEY_SPARSE_SAMPLES) {
+      uint64_t rows;
+      if (!reader.readHead(major, rows) || major != 4) {
+        fail("malformed samples array");
+      }
+      printf("\"fields\":[\"timestamp\"");
+      for (int f = 0; f < FIELD_COUNT; f++) {
+        printf(",\"%s\"", fieldInfo[f].name);
+      }
+      printf("],\"%s\":[", key == KEY_SPARSE_SAMPLES ? "sparse_samples" : "samples");
+      for (uint64_t r = 0; r < rows; r++) {
+        if (r > 0) {
+          printf(",");
+        }
+        printRow(reader, key == KEY_SPARSE_SAMPLES);
+      }
+      printf("]");
+    } else if (key == KEY_WINDOW_START) {
+      printf("\"window_start\":%lld", (long long)readRequired(reader, "window start"));
+    } else if (key == KEY_WINDOW_S) {
+      printf("\"window_s\":%lld", (long long)readRequired(reader, "window length"));
+    } else if (key == KEY_WINDOW_STATS) {
+      printWindowStats(reader);
+    } else if (const FieldInfo* field = fieldByKey(key)) {
+      printField(reader, *field);
+    } else {
+      fail("unknown key, is telemetry_schema.h out of date?");
+    }
+  }
+  printf("}\n");
+
+  if (shape < 0) {
+    fail("payload has no shape, sent by firmware older than the shape key?");
+  }
+  if (!reader.done()) {
+    fail("trailing bytes after payload");
+  }
+}
+
+static std::vector<uint8_t> parseHex(const char* text) {
+  std::vector<uint8_t> data;
+  std::string digits;
+  for (const char* p = text; *p; p++) {
+    if (isxdigit((unsigned char)*p)) {
+      digits += *p;
+    }
+  }
+  if (digits.size() % 2 != 0) {
+    fail("odd number of hex digits");
+  }
+  for (size_t i = 0; i < digits.size(); i += 2) {
+    data.push_back((uint8_t)strtoul(digits.substr(i, 2).c_str(), nullptr, 16));
+  }
+  return data;
+}
+
+static std::vector<uint8_t> readAll(FILE* file) {
+  std::vector<uint8_t> data;
+  uint8_t chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    data.insert(data.end(), chunk, chunk + n);
+  }
+  return data;
+}
+
+int main(int argc, char** argv) {
+  std::vector<uint8_t> data;
+  if (argc == 3 && strcmp(argv[1], "-x") == 0) {
+    data = parseHex(argv[2]);
+  } else if (argc == 2) {
+    FILE* file = fopen(argv[1], "rb");
+    if (!file) {
+      fail("cannot open input file");
+    }
+    data = readAll(file);
+    fclose(file);
+  } else if (argc == 1) {
+    data = readAll(stdin);
+  } else {
+    fprintf(stderr, "usage: telemetry-decoder [file] | -x HEX\n");
+    return 2;
+  }
+
+  decode(data);
+  return 0;
+}
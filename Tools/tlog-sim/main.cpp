@@ -0,0 +1,135 @@
+// Host-side outage simulation of Lab 11's flash log (Lab 11/telemetry_log.h).
+// Runs the log on the LittleFS shim through repeated broker outages and reboots: one record
+// is appended per simulated minute while offline, and replayed 16 at a time once the broker
+// is back, as Lab 11 does with REPLAY_BATCH_SAMPLES. A reboot rebuilds the log from the files
+// alone, at random points including in the middle of a replay.
+//
+// Checks that every record comes out, in order, and reports how many were replayed twice after
+// a reboot and how often the read cursor was written, the figure the flash wear depends on.
+// Exits with 1 if a record was lost or reordered.
+//
+// Build:  g++ -std=gnu++17 -O2 -I ../native-shims -I "../../Lab 11" main.cpp ../native-shims/*.cpp -o tlog-sim
+//         (add -D TLOG_CURSOR_SAVE_RECORDS=1 to save the cursor on every consume() for comparison)
+// Usage:  NATIVE_FS_DIR=/tmp/tlog-sim ./tlog-sim    (the directory is formatted first)
+//         TLOG_SIM_OUTAGES and TLOG_SIM_SEED change the number of outages (default 200) and the seed
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <random>
+#include <vector>
+#include "telemetry_log.h"
+
+// Same size as a SensorSample on the board
+struct SimRecord {
+  uint32_t sequence;
+  uint8_t payload[40];
+};
+
+static const size_t REPLAY_BATCH = 16;
+
+// Number of times the cursor file changed, checked after every consume()
+static uint32_t cursorWrites = 0;
+static std::vector<uint8_t> lastCursor;
+
+static std::vector<uint8_t> readCursorFile() {
+  std::vector<uint8_t> bytes;
+  File file = LittleFS.open(TLOG_DIR "/cursor", "r");
+  if (file) {
+    bytes.resize(file.size());
+    file.read(bytes.data(), bytes.size());
+    file.close();
+  }
+  return bytes;
+}
+
+static void countCursorWrite() {
+  std::vector<uint8_t> cursor = readCursorFile();
+  if (cursor != lastCursor) {
+    cursorWrites++;
+    lastCursor = cursor;
+  }
+}
+
+static uint32_t envNumber(const char* name, uint32_t fallback) {
+  const char* text = getenv(name);
+  return text ? strtoul(text, nullptr, 10) : fallback;
+}
+
+void setup() {
+  uint32_t outages = envNumber("TLOG_SIM_OUTAGES", 200);
+  std::mt19937 random(envNumber("TLOG_SIM_SEED", 1));
+  LittleFS.begin();
+  LittleFS.format();
+
+  TelemetryLog<SimRecord>* log = new TelemetryLog<SimRecord>();
+  log->begin();
+
+  uint32_t appended = 0; // Next sequence number to append
+  uint32_t expected = 0; // Next sequence number not yet delivered
+  uint32_t delivered = 0;
+  uint32_t duplicates = 0;
+  uint32_t reboots = 0;
+  uint32_t peakBacklog = 0;
+  bool failed = false;
+
+  for (uint32_t outage = 0; outage < outages && !failed; outage++) {
+    // Offline for 10 minutes to 12 hours, one sample a minute
+    uint32_t minutes = 10 + random() % (12 * 60);
+    for (uint32_t m = 0; m < minutes; m++) {
+      SimRecord record = {};
+      record.sequence = appended++;
+      if (!log->append(record)) {
+        printf("append failed at record %u\n", record.sequence);
+        failed = true;
+        break;
+      }
+    }
+    if (log->pending() > peakBacklog) {
+      peakBacklog = log->pending();
+    }
+
+    // Back online: replay everything, rebooting now and then on the way
+    SimRecord batch[REPLAY_BATCH];
+    while (!failed && log->pending() > 0) {
+      if (random() % 40 == 0) {
+        delete log; // Power cut: only the files survive
+        log = new TelemetryLog<SimRecord>();
+        log->begin();
+        reboots++;
+        continue;
+      }
+      size_t n = log->read(batch, REPLAY_BATCH);
+      if (n == 0) {
+        printf("read returned nothing with %u records pending\n", log->pending());
+        failed = true;
+        break;
+      }
+      for (size_t i = 0; i < n; i++) {
+        uint32_t sequence = batch[i].sequence;
+        if (sequence < expected) {
+          duplicates++; // Replayed again after a reboot, the cloud side sees it twice
+        } else if (sequence == expected) {
+          expected++;
+          delivered++;
+        } else {
+          printf("record %u delivered while %u was expected\n", sequence, expected);
+          failed = true;
+          break;
+        }
+      }
+      log->consume(n);
+      countCursorWrite();
+    }
+  }
+
+  uint32_t lost = appended - delivered - log->dropped();
+  printf("%u outages, %u reboots, peak backlog %u records\n", outages, reboots, peakBacklog);
+  printf("appended %u, delivered %u, dropped by the log %u, lost %u\n", appended, delivered, log->dropped(), lost);
+  printf("duplicates after a reboot %u (%.2f%%)\n", duplicates, 100.0 * duplicates / (delivered ? delivered : 1));
+  printf("cursor writes %u (one per %.1f records delivered)\n", cursorWrites,
+         cursorWrites ? (double)delivered / cursorWrites : 0.0);
+  exit(failed || lost != 0 ? 1 : 0);
+}
+
+void loop() {
+}
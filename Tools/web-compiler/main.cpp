@@ -0,0 +1,158 @@
+// Turns a lab's web/index.html into a gzipped PROGMEM blob, so the firmware can send the page
+// straight from flash with Content-Encoding: gzip instead of building it with String
+// concatenations on every request. The header also defines an ETag (a hash of the blob) that
+// lets browsers revalidate the page and get a 304 while it is unchanged.
+//
+// Build:  g++ -std=c++11 -O2 main.cpp -lz -o web-compiler
+// Usage:  web-compiler web/index.html indexHtml > index_html_gz.h
+//
+// The generated header is committed, so the labs build without running this tool. Run it
+// again after editing web/index.html.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+static void fail(const std::string& message) {
+  fprintf(stderr, "web-compiler: %s\n", message.c_str());
+  exit(1);
+}
+
+static std::string trim(const std::string& line) {
+  size_t start = line.find_first_not_of(" \t\r\n");
+  if (start == std::string::npos) {
+    return "";
+  }
+  size_t end = line.find_last_not_of(" \t\r\n");
+  return line.substr(start, end - start + 1);
+}
+
+// Conservative minifier: drops indentation, blank lines, whole-line HTML comments and whole-line
+// // comments. Lines keep their line break, so scripts never depend on semicolon insertion, and
+// everything inside <pre> is kept verbatim.
+static std::string minify(FILE* file, size_t& originalSize) {
+  std::string output;
+  bool inPre = false;
+  bool inComment = false;
+  char buffer[4096];
+  std::string line;
+  originalSize = 0;
+  while (fgets(buffer, sizeof(buffer), file)) {
+    line = buffer;
+    originalSize += line.size();
+    if (inPre) {
+      output += line;
+      inPre = line.find("</pre>") == std::string::npos;
+      continue;
+    }
+
+    std::string text = trim(line);
+    if (inComment) {
+      inComment = text.find("-->") == std::string::npos;
+      continue;
+    }
+    if (text.compare(0, 4, "<!--") == 0) {
+      inComment = text.find("-->") == std::string::npos;
+      continue;
+    }
+    if (text.empty() || text.compare(0, 2, "//") == 0) {
+      continue;
+    }
+
+    size_t pre = text.find("<pre");
+    if (pre != std::string::npos && text.find("</pre>", pre) == std::string::npos) {
+      // Keep the spaces after <pre ...> on this line, they are part of the content
+      std::string rest = line.substr(line.find("<pre"));
+      output += text.substr(0, pre) + rest;
+      inPre = true;
+      continue;
+    }
+    output += text + "\n";
+  }
+  return output;
+}
+
+static std::vector<uint8_t> gzip(const std::string& data) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  // windowBits 15 + 16 selects the gzip wrapper. zlib writes a zero timestamp, so the output and
+  // the ETag only change when the page does.
+  if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+    fail("deflateInit2 failed");
+  }
+  std::vector<uint8_t> output(deflateBound(&stream, data.size()) + 32);
+  stream.next_in = (Bytef*)data.data();
+  stream.avail_in = data.size();
+  stream.next_out = output.data();
+  stream.avail_out = output.size();
+  if (deflate(&stream, Z_FINISH) != Z_STREAM_END) {
+    fail("deflate failed");
+  }
+  output.resize(stream.total_out);
+  deflateEnd(&stream);
+  return output;
+}
+
+// FNV-1a, only used to tell one version of the page from another
+static uint32_t fnv1a(const std::vector<uint8_t>& data) {
+  uint32_t hash = 2166136261u;
+  for (uint8_t byte : data) {
+    hash = (hash ^ byte) * 16777619u;
+  }
+  return hash;
+}
+
+// indexHtml -> INDEX_HTML
+static std::string macroName(const std::string& name) {
+  std::string macro;
+  for (size_t i = 0; i < name.size(); i++) {
+    if (i > 0 && isupper((unsigned char)name[i]) && islower((unsigned char)name[i - 1])) {
+      macro += '_';
+    }
+    macro += (char)toupper((unsigned char)name[i]);
+  }
+  return macro;
+}
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    fprintf(stderr, "usage: web-compiler PAGE.html arrayName > array_name_gz.h\n");
+    return 2;
+  }
+  FILE* file = fopen(argv[1], "r");
+  if (!file) {
+    fail(std::string("cannot open ") + argv[1]);
+  }
+  size_t originalSize;
+  std::string minified = minify(file, originalSize);
+  fclose(file);
+  std::vector<uint8_t> compressed = gzip(minified);
+
+  std::string name = argv[2];
+  std::string macro = macroName(name);
+  std::string fileName;
+  for (char c : macro) {
+    fileName += (char)tolower((unsigned char)c);
+  }
+  printf("// %s_gz.h\n", fileName.c_str());
+  printf("// Generated by Tools/web-compiler from %s. Do not edit, regenerate it instead.\n", argv[1]);
+  printf("#ifndef %s_GZ_H\n", macro.c_str());
+  printf("#define %s_GZ_H\n\n", macro.c_str());
+  printf("#include <pgmspace.h>\n\n");
+  printf("// %zu bytes of HTML, %zu minified, %zu gzipped\n", originalSize, minified.size(), compressed.size());
+  printf("#define %s_ETAG \"\\\"%08x\\\"\"\n", macro.c_str(), fnv1a(compressed));
+  printf("const uint8_t %sGz[] PROGMEM = {", name.c_str());
+  for (size_t i = 0; i < compressed.size(); i++) {
+    printf("%s0x%02x,", i % 16 == 0 ? "\n  " : " ", compressed[i]);
+  }
+  printf("\n};\n\n");
+  printf("#endif // %s_GZ_H\n", macro.c_str());
+
+  fprintf(stderr, "%s: %zu bytes, %zu minified, %zu gzipped\n", argv[1], originalSize, minified.size(), compressed.size());
+  return 0;
+}
@@ -0,0 +1,162 @@
+// Host-side accuracy test and benchmark of Lab 11's windowed statistics (Lab 11/window_stats.h).
+// Feeds random windows through WindowStats and compares its mean and sample standard deviation
+// with a two-pass double-precision reference over the same fixed-point inputs. Min, max and
+// count must match exactly. Errors are given in the metric's fixed-point unit (0.01 C for a
+// temperature scaled by 100).
+//
+// Three kinds of windows are run: uniform noise over a whole field range, a slow drift with a
+// little noise on a large offset (the case where a naive sum of squares loses its precision),
+// and the documented limits, 4095 samples at +/-2^19. Then add() is timed against a double
+// Welford update. Times are host times: the ESP8266 emulates every float and double operation
+// in software, so only the integer figure says anything about the board.
+//
+// Build:  g++ -std=c++11 -O2 -I"../../Lab 11" main.cpp -o window-stats-bench
+// Usage:  window-stats-bench [WINDOWS]    (default: 2000 random windows per kind)
+// Exits with 1 if an error is above the limits below.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "window_stats.h"
+
+static const double MEAN_LIMIT = 0.5 / (1 << WindowStats::FRACTION_BITS) + 1e-9; // Half a fraction step
+static const double STDDEV_LIMIT = 0.05; // Fixed-point units
+static const uint32_t MAX_SAMPLES = WindowStats::MAX_SAMPLES;
+static const int32_t MAX_VALUE = WindowStats::INPUT_LIMIT;
+
+// Largest error of one kind of window
+struct ErrorStats {
+  double mean = 0;
+  double stddev = 0;
+  bool exact = true; // Count, min and max all matched
+};
+
+static volatile int64_t sink; // Keeps the compiler from dropping the timed loops
+
+static void check(const std::vector<int32_t>& values, ErrorStats& errors) {
+  WindowStats stats;
+  double sum = 0;
+  int32_t low = values[0];
+  int32_t high = values[0];
+  for (int32_t value : values) {
+    stats.add(value);
+    sum += value;
+    low = value < low ? value : low;
+    high = value > high ? value : high;
+  }
+  double mean = sum / values.size();
+  double squares = 0;
+  for (int32_t value : values) {
+    squares += (value - mean) * (value - mean);
+  }
+  double stddev = values.size() > 1 ? sqrt(squares / (values.size() - 1)) : 0;
+
+  double meanError = fabs((double)stats.meanQ() / (1 << WindowStats::FRACTION_BITS) - mean);
+  double stddevError = fabs((double)stats.stddevQ() / (1 << WindowStats::FRACTION_BITS) - stddev);
+  errors.mean = meanError > errors.mean ? meanError : errors.mean;
+  errors.stddev = stddevError > errors.stddev ? stddevError : errors.stddev;
+  if (stats.count() != values.size() || stats.min() != low || stats.max() != high) {
+    errors.exact = false;
+  }
+}
+
+static bool report(const char* label, const ErrorStats& errors) {
+  bool pass = errors.exact && errors.mean <= MEAN_LIMIT && errors.stddev <= STDDEV_LIMIT;
+  printf("%-28s %12.6f %12.6f %8s %6s\n", label, errors.mean, errors.stddev, errors.exact ? "yes" : "NO",
+         pass ? "ok" : "FAIL");
+  return pass;
+}
+
+int main(int argc, char** argv) {
+  uint32_t windows = argc > 1 ? strtoul(argv[1], nullptr, 10) : 2000;
+  if (windows == 0) {
+    fprintf(stderr, "usage: window-stats-bench [WINDOWS]\n");
+    return 2;
+  }
+  std::mt19937 random(7);
+  std::vector<int32_t> values;
+  bool pass = true;
+
+  printf("Largest error against the double reference, in fixed-point units\n\n");
+  printf("%-28s %12s %12s %8s %6s\n", "", "mean", "stddev", "exact", "");
+
+  // Uniform noise, ranges of Lab 11's fields in their fixed-point units
+  ErrorStats uniform;
+  for (uint32_t w = 0; w < windows; w++) {
+    values.assign(2 + random() % (MAX_SAMPLES - 1), 0);
+    int32_t low = -(int32_t)(random() % MAX_VALUE);
+    int32_t high = low + 1 + (int32_t)(random() % (MAX_VALUE - low));
+    for (int32_t& value : values) {
+      value = low + (int32_t)(random() % (uint32_t)(high - low + 1));
+    }
+    check(values, uniform);
+  }
+  pass &= report("uniform noise", uniform);
+
+  // Drift of a few units on a large offset, e.g. a pressure of 1013 hPa scaled by 100
+  ErrorStats drift;
+  for (uint32_t w = 0; w < windows; w++) {
+    values.assign(2 + random() % (MAX_SAMPLES - 1), 0);
+    int32_t offset = 90000 + (int32_t)(random() % 20000);
+    int32_t slope = (int32_t)(random() % 21) - 10; // Units per 1000 samples
+    for (size_t i = 0; i < values.size(); i++) {
+      values[i] = offset + slope * (int32_t)i / 1000 + (int32_t)(random() % 5) - 2;
+    }
+    check(values, drift);
+  }
+  pass &= report("drift on a large offset", drift);
+
+  // The documented limits: the longest window, all at one extreme or alternating between both
+  ErrorStats limits;
+  values.assign(MAX_SAMPLES, MAX_VALUE);
+  check(values, limits);
+  values.assign(MAX_SAMPLES, -MAX_VALUE);
+  check(values, limits);
+  for (size_t i = 0; i < values.size(); i++) {
+    values[i] = i % 2 ? MAX_VALUE : -MAX_VALUE;
+  }
+  check(values, limits);
+  pass &= report("4095 samples at +/-2^19", limits);
+
+  // Time of one add(), over a window-length run of the uniform inputs
+  const uint32_t runs = 2000;
+  values.assign(MAX_SAMPLES, 0);
+  for (int32_t& value : values) {
+    value = (int32_t)(random() % 200000) - 100000;
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t r = 0; r < runs; r++) {
+    WindowStats stats;
+    for (int32_t value : values) {
+      stats.add(value);
+    }
+    sink = stats.meanQ() + stats.stddevQ();
+  }
+  std::chrono::duration<double, std::nano> fixedTime = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  for (uint32_t r = 0; r < runs; r++) {
+    double mean = 0;
+    double m2 = 0;
+    uint32_t n = 0;
+    for (int32_t value : values) {
+      n++;
+      double delta = value - mean;
+      mean += delta / n;
+      m2 += delta * (value - mean);
+    }
+    sink = (int64_t)(mean + sqrt(m2 / (n - 1)));
+  }
+  std::chrono::duration<double, std::nano> doubleTime = std::chrono::steady_clock::now() - start;
+
+  double samples = (double)runs * values.size();
+  printf("\nadd() on the host: %.1f ns/sample fixed point, %.1f ns/sample double Welford\n",
+         fixedTime.count() / samples, doubleTime.count() / samples);
+  printf("Memory: %zu bytes per metric, whatever the window length\n", sizeof(WindowStats));
+  return pass ? 0 : 1;
+}